@@ -0,0 +1,375 @@
+#!/usr/bin/env python3
+"""
+bench_regress.py -- Throughput regression suite for c_scanner
+=============================================================
+
+Runs a fixed set of `c_scanner --bench` workloads, appends the results to
+a history file and compares them against the stored baseline for this CPU,
+so a change that costs speed shows up before it reaches the fleet.
+
+Workloads (each one a Mk/s figure):
+  pipeline/<engine>/t1, pipeline/<engine>/tN
+                             end to end, one thread and all threads, for
+                             every EC engine this CPU can run
+  stage/<stage>/t1           one EC stepping stage on its own (jacobian_step,
+                             batch_inversion, affine_batch, center_batch,
+                             fused_batch)
+  hash160/<isa>/t1           hash160_words with each hash kernel (--isa)
+  sha256/<impl>/t1           sha256_33 with SHA-NI and the generic code
+
+Every run uses --pin=core and one fixed batch size; c_scanner warms each
+stage up before timing it.  A workload is run --repeat times and the best
+figure kept, which filters out most scheduler noise on a shared box.
+
+Baselines are per CPU and setup: the key is the model name, the ISA flags
+the kernels depend on, the batch size and the all-threads count, so numbers
+from an EPYC never judge a Xeon and a --batch 4096 run never judges a 2048
+one.  The first run of a new key becomes its baseline; --set-baseline
+replaces it.  A planned workload missing from the report (a --batch that
+c_scanner does not bench) fails the run and stores nothing.
+
+Files (under /root/puzzle71/data):
+  bench_history.jsonl        one JSON record per suite run (version 1)
+  bench_baseline.json        {cpu-key: record} baselines
+
+Usage:
+  python bench_regress.py [--binary ./c_scanner] [--threads N] [--repeat 3]
+                          [--threshold 5] [--batch 2048] [--quick]
+                          [--set-baseline] [--no-record] [--data-dir DIR]
+  python bench_regress.py --show
+
+Exit status is 1 when any workload is more than --threshold percent below
+the baseline and 2 when a run fails or a workload is missing, so the suite
+can gate a build script.
+"""
+
+import argparse
+import datetime
+import json
+import os
+import socket
+import subprocess
+import sys
+import tempfile
+
+# =============================================================================
+# Constants
+# =============================================================================
+
+DATA_DIR = "/root/puzzle71/data"
+HISTORY_FILE = os.path.join(DATA_DIR, "bench_history.jsonl")
+BASELINE_FILE = os.path.join(DATA_DIR, "bench_baseline.json")
+DEFAULT_BINARY = os.environ.get("C_SCANNER", "/root/puzzle71/c_scanner")
+
+HISTORY_VERSION = 1
+DEFAULT_BATCH = 2048
+BENCH_BATCHES = [256, 1024, 2048, 4096, 16384]   # c_scanner's g_bench_batches
+DEFAULT_REPEAT = 3
+DEFAULT_THRESHOLD = 5.0       # percent below baseline that counts as a regression
+
+ENGINES = ["jacobian", "affine", "center", "fused", "simd"]
+STEP_STAGES = ["jacobian_step", "batch_inversion", "affine_batch", "center_batch", "fused_batch"]
+SHA_IMPLS = ["shani", "generic"]
+
+# /proc/cpuinfo flags that change which kernels run
+CPU_KEY_FLAGS = ["bmi2", "adx", "avx2", "avx512f", "avx512bw", "avx512ifma", "sha_ni"]
+
+# =============================================================================
+# Host description
+# =============================================================================
+
+def cpu_info():
+    """Model name, flag set and logical CPU count from /proc/cpuinfo."""
+    model, flags, cpus = "unknown", set(), 0
+    try:
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                key, _, value = line.partition(":")
+                key = key.strip()
+                if key == "processor":
+                    cpus += 1
+                elif key == "model name" and model == "unknown":
+                    model = " ".join(value.split())
+                elif key == "flags" and not flags:
+                    flags = set(value.split())
+    except OSError:
+        pass
+    return model, flags, max(cpus, os.cpu_count() or 1)
+
+
+def cpu_key(model, flags, batch, threads):
+    """Baseline key: model, the ISA flags present, batch and thread count."""
+    isa = [f for f in CPU_KEY_FLAGS if f in flags]
+    return f"{model} [{' '.join(isa)}] batch {batch} t{threads}"
+
+
+def git_rev():
+    """Short revision of the source tree next to this script, if any."""
+    try:
+        out = subprocess.run(["git", "rev-parse", "--short", "HEAD"],
+                             cwd=os.path.dirname(os.path.abspath(__file__)),
+                             capture_output=True, text=True, timeout=10)
+        rev = out.stdout.strip()
+        if rev:
+            dirty = subprocess.run(["git", "diff", "--quiet", "HEAD", "--", "c_scanner.c"],
+                                   cwd=os.path.dirname(os.path.abspath(__file__)),
+                                   timeout=10).returncode
+            return rev + ("+" if dirty else "")
+    except (OSError, subprocess.SubprocessError):
+        pass
+    return None
+
+# =============================================================================
+# Workloads
+# =============================================================================
+
+def plan_runs(flags, threads, quick):
+    """
+    c_scanner invocations for the suite.  Each entry is (extra args, thread
+    count, [(workload, stage, threads-row)]) -- one --bench run yields
+    several workloads.  ISA-dependent runs are only planned when the CPU
+    has the instructions, so a missing kernel is not a regression.
+    """
+    runs = []
+    engines = [e for e in ENGINES if e != "simd" or "avx512ifma" in flags]
+    if quick:
+        engines = ["fused"] if "fused" in engines else engines[:1]
+    for i, eng in enumerate(engines):
+        want = [(f"pipeline/{eng}/t1", "pipeline", 1)]
+        if threads > 1:
+            want.append((f"pipeline/{eng}/t{threads}", "pipeline", threads))
+        if i == 0:
+            want += [(f"stage/{s}/t1", s, 1) for s in STEP_STAGES]
+        runs.append(([f"--engine={eng}"], threads, want))
+
+    isas = ["scalar"]
+    if "avx2" in flags:
+        isas.append("avx2")
+    if "avx512f" in flags and "avx512bw" in flags:
+        isas.append("avx512")
+    for isa in isas:
+        runs.append(([f"--isa={isa}"], 1, [(f"hash160/{isa}/t1", "hash160_words", 1)]))
+    shas = SHA_IMPLS if "sha_ni" in flags else ["generic"]
+    for sha in shas:
+        runs.append(([f"--sha={sha}"], 1, [(f"sha256/{sha}/t1", "sha256_33", 1)]))
+    return runs
+
+
+def run_bench(binary, args, threads, batch):
+    """One c_scanner --bench run; returns its parsed JSON report."""
+    fd, path = tempfile.mkstemp(prefix="bench_", suffix=".json")
+    os.close(fd)
+    try:
+        cmd = [binary, str(threads), "--pin=core", f"--batch={batch}", f"--bench={path}"] + args
+        proc = subprocess.run(cmd, capture_output=True, text=True)
+        if proc.returncode != 0:
+            tail = (proc.stderr or proc.stdout).strip().splitlines()[-3:]
+            raise RuntimeError(f"{' '.join(cmd)} exited {proc.returncode}: " + " | ".join(tail))
+        with open(path) as f:
+            return json.load(f)
+    finally:
+        os.unlink(path)
+
+
+def pick(report, stage, threads, batch):
+    """Mk/s for one stage / thread-count row of a --bench report."""
+    for r in report["results"]:
+        if r["stage"] == stage and r["threads"] == threads and r["batch"] == batch:
+            return r["keys_per_sec"] / 1e6
+    return None
+
+
+def run_suite(args, flags):
+    """All workloads, best of --repeat each.  Returns (results, kernels,
+    missing), missing being the planned workloads no report had."""
+    results, kernels, missing = {}, {}, []
+    for extra, threads, want in plan_runs(flags, args.threads, args.quick):
+        for _ in range(args.repeat):
+            report = run_bench(args.binary, extra, threads, args.batch)
+            for name, stage, row in want:
+                mks = pick(report, stage, row, args.batch)
+                if mks is not None and mks > results.get(name, 0.0):
+                    results[name] = mks
+                    kernels[name] = {k: report.get(k) for k in
+                                     ("engine", "hash_kernel", "sha256", "field_code")}
+        for name, _, _ in want:
+            if name in results:
+                print(f"  {name:<32} {results[name]:10.3f} Mk/s", flush=True)
+            else:
+                print(f"  {name:<32} {'-':>10}  (not in report)", flush=True)
+                missing.append(name)
+    return results, kernels, missing
+
+# =============================================================================
+# History / baseline
+# =============================================================================
+
+def load_baselines():
+    try:
+        with open(BASELINE_FILE) as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return {}
+
+
+def save_baselines(baselines):
+    """Write bench_baseline.json atomically."""
+    os.makedirs(DATA_DIR, exist_ok=True)
+    fd, tmp = tempfile.mkstemp(dir=DATA_DIR, prefix=".bench_baseline.")
+    with os.fdopen(fd, "w") as f:
+        json.dump(baselines, f, indent=2, sort_keys=True)
+        f.write("\n")
+    os.replace(tmp, BASELINE_FILE)
+
+
+def append_history(record):
+    os.makedirs(DATA_DIR, exist_ok=True)
+    with open(HISTORY_FILE, "a") as f:
+        f.write(json.dumps(record, sort_keys=True) + "\n")
+
+
+def compare(results, baseline, threshold):
+    """Print the comparison table; returns the list of regressed workloads."""
+    regressed = []
+    base = baseline.get("results", {}) if baseline else {}
+    print(f"\n  {'workload':<32} {'Mk/s':>10} {'baseline':>10} {'delta':>8}")
+    for name in sorted(results):
+        now = results[name]
+        if name not in base or base[name] <= 0:
+            print(f"  {name:<32} {now:10.3f} {'-':>10} {'new':>8}")
+            continue
+        delta = (now / base[name] - 1.0) * 100.0
+        mark = ""
+        if delta < -threshold:
+            mark = "  REGRESSION"
+            regressed.append(name)
+        print(f"  {name:<32} {now:10.3f} {base[name]:10.3f} {delta:+7.1f}%{mark}")
+    for name in sorted(set(base) - set(results)):
+        print(f"  {name:<32} {'-':>10} {base[name]:10.3f} {'gone':>8}")
+    return regressed
+
+
+def show():
+    """Baselines and the last few history records."""
+    baselines = load_baselines()
+    if not baselines:
+        print(f"No baselines in {BASELINE_FILE}")
+    for key, rec in sorted(baselines.items()):
+        print(f"{key}\n  baseline {rec.get('time')} rev {rec.get('rev') or '?'} on {rec.get('host')}")
+        for name, mks in sorted(rec.get("results", {}).items()):
+            print(f"    {name:<32} {mks:10.3f} Mk/s")
+    try:
+        with open(HISTORY_FILE) as f:
+            lines = f.readlines()[-10:]
+    except OSError:
+        lines = []
+    if lines:
+        print("\nRecent runs:")
+    for line in lines:
+        try:
+            rec = json.loads(line)
+        except ValueError:
+            continue
+        res = rec.get("results", {})
+        top = max(res.values()) if res else 0.0
+        flag = " REGRESSED" if rec.get("regressed") else ""
+        print(f"  {rec.get('time')} {rec.get('rev') or '?':<10} {rec.get('cpu_key')}: "
+              f"{len(res)} workloads, best {top:.3f} Mk/s{flag}")
+    return 0
+
+# =============================================================================
+# Main
+# =============================================================================
+
+def main():
+    global DATA_DIR, HISTORY_FILE, BASELINE_FILE
+    parser = argparse.ArgumentParser(
+        description="Run fixed c_scanner --bench workloads and flag throughput "
+                    "regressions against a per-CPU baseline.",
+    )
+    parser.add_argument("--binary", default=DEFAULT_BINARY,
+                        help=f"c_scanner binary (default: $C_SCANNER or {DEFAULT_BINARY})")
+    parser.add_argument("--threads", type=int, default=0,
+                        help="Thread count for the all-threads workloads (default: all CPUs)")
+    parser.add_argument("--batch", type=int, default=DEFAULT_BATCH,
+                        help=f"Batch size for every run (default: {DEFAULT_BATCH})")
+    parser.add_argument("--repeat", type=int, default=DEFAULT_REPEAT,
+                        help=f"Runs per workload, best one kept (default: {DEFAULT_REPEAT})")
+    parser.add_argument("--threshold", type=float, default=DEFAULT_THRESHOLD,
+                        help=f"Percent below baseline that fails the run (default: {DEFAULT_THRESHOLD:g})")
+    parser.add_argument("--quick", action="store_true",
+                        help="Only the fused engine plus the hash kernels")
+    parser.add_argument("--set-baseline", action="store_true",
+                        help="Store this run as the baseline for this CPU")
+    parser.add_argument("--no-record", action="store_true",
+                        help="Do not append to the history or create a baseline")
+    parser.add_argument("--data-dir", default=DATA_DIR,
+                        help=f"History and baseline directory (default: {DATA_DIR})")
+    parser.add_argument("--show", action="store_true",
+                        help="Print the stored baselines and recent history")
+    args = parser.parse_args()
+
+    DATA_DIR = args.data_dir
+    HISTORY_FILE = os.path.join(DATA_DIR, "bench_history.jsonl")
+    BASELINE_FILE = os.path.join(DATA_DIR, "bench_baseline.json")
+    if args.show:
+        sys.exit(show())
+
+    model, flags, ncpu = cpu_info()
+    if args.threads <= 0:
+        args.threads = ncpu
+    args.repeat = max(1, args.repeat)
+    if args.batch not in BENCH_BATCHES:
+        print(f"--batch {args.batch}: c_scanner --bench only runs batches "
+              f"{', '.join(map(str, BENCH_BATCHES))}", file=sys.stderr)
+        sys.exit(2)
+    key = cpu_key(model, flags, args.batch, args.threads)
+    print(f"CPU: {key}, {ncpu} logical CPUs")
+    print(f"Binary: {args.binary}, batch {args.batch}, best of {args.repeat}\n")
+
+    try:
+        results, kernels, missing = run_suite(args, flags)
+    except (OSError, RuntimeError, ValueError) as e:
+        print(f"Benchmark failed: {e}", file=sys.stderr)
+        sys.exit(2)
+    if missing:
+        print(f"\n{len(missing)} planned workload(s) missing from the reports: "
+              f"{', '.join(missing)}", file=sys.stderr)
+        sys.exit(2)
+
+    record = {
+        "version": HISTORY_VERSION,
+        "time": datetime.datetime.now(datetime.timezone.utc).strftime("%Y-%m-%dT%H:%M:%SZ"),
+        "host": socket.gethostname(),
+        "rev": git_rev(),
+        "cpu_model": model,
+        "cpu_key": key,
+        "isa": sorted(f for f in CPU_KEY_FLAGS if f in flags),
+        "threads": args.threads,
+        "batch": args.batch,
+        "repeat": args.repeat,
+        "results": results,
+        "kernels": kernels,
+    }
+
+    baselines = load_baselines()
+    baseline = baselines.get(key)
+    regressed = compare(results, baseline, args.threshold)
+    record["regressed"] = regressed
+
+    if not args.no_record:
+        append_history(record)
+        if args.set_baseline or baseline is None:
+            baselines[key] = record
+            save_baselines(baselines)
+            print(f"\nBaseline for this CPU, batch and thread count {'replaced' if baseline else 'created'} in {BASELINE_FILE}")
+
+    if regressed and not args.set_baseline:
+        print(f"\n{len(regressed)} workload(s) more than {args.threshold:g}% below baseline")
+        sys.exit(1)
+    if baseline:
+        print("\nNo regressions")
+
+
+if __name__ == "__main__":
+    main()
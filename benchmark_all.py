@@ -15,6 +15,7 @@ sys.path.insert(0, '/root/iceland_secp256k1')
 import secp256k1 as ice
 import time
 import os
+import json
 
 # ─── Configuration ───────────────────────────────────────────────────────────
 TARGET_H160 = bytes.fromhex("f6f5431d25bbf7b12e8add9af5e3475c44a0a5b8")
@@ -486,6 +487,35 @@ for batch_sz in [10_000, 50_000, 100_000, 500_000, 1_000_000, 2_000_000]:
         print()
 
 
+# ─────────────────────────────────────────────────────────────────────────────
+divider("13. C ENGINE STAGES (c_scanner --bench)")
+# ─────────────────────────────────────────────────────────────────────────────
+
+# Written by `c_scanner --bench[=FILE]`; rows at the scanner's default batch
+# size are merged into the summary as c_scanner_<stage>_t<threads>.
+C_BENCH_FILE = os.environ.get('C_SCANNER_BENCH', '/root/puzzle71/data/c_scanner_bench.json')
+try:
+    with open(C_BENCH_FILE) as f:
+        c_bench = json.load(f)
+except (OSError, ValueError) as e:
+    c_bench = None
+    print(f"  No c_scanner benchmark ({C_BENCH_FILE}): {e}")
+    print(f"  Run: ./c_scanner {NUM_CPUS} --bench={C_BENCH_FILE}")
+    print()
+
+if c_bench:
+    print(f"  engine={c_bench['engine']}  hash={c_bench['hash_kernel']}  sha256={c_bench['sha256']}")
+    print()
+    print(f"  {'Stage':<18} {'Batch':>6} {'Thr':>4} {'ns/key':>10} {'cyc/key':>9} {'Keys/sec':>12}")
+    print(f"  {'─'*18} {'─'*6} {'─'*4} {'─'*10} {'─'*9} {'─'*12}")
+    for row in c_bench['results']:
+        print(f"  {row['stage']:<18} {row['batch']:>6} {row['threads']:>4} "
+              f"{row['ns_per_key']:>10.1f} {row['cycles_per_key']:>9.0f} {fmt(row['keys_per_sec']):>11}/s")
+        if row['batch'] == c_bench['default_batch']:
+            results[f"c_scanner_{row['stage']}_t{row['threads']}"] = row['keys_per_sec']
+    print()
+
+
 # ═══════════════════════════════════════════════════════════════════════════════
 #  RESULTS SUMMARY
 # ═══════════════════════════════════════════════════════════════════════════════
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+c_engine — Python binding for libc_scanner.so (scanner_engine.h).
+
+The C engine runs its own scan threads; scan() blocks in C with the GIL
+released (ctypes drops it for foreign calls), so Python threads keep
+running for stats and signal handling.  Matches are delivered as
+(key, h160) through a callback — no per-batch h160 blobs are built or
+searched in Python.
+
+Build the library (see scanner_engine.h), then:
+    eng = CEngine(threads=4)
+    eng.set_targets([bytes.fromhex("f6f5431d25bbf7b12e8add9af5e3475c44a0a5b8")])
+    checked = eng.scan(start, count, lambda key, h160: print(hex(key)))
+"""
+
+import ctypes
+import os
+
+LIB_PATH = os.environ.get("C_SCANNER_LIB", "/root/puzzle71/libc_scanner.so")
+
+MATCH_FN = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.c_uint64, ctypes.c_uint64,
+                            ctypes.POINTER(ctypes.c_ubyte * 20))
+
+
+class Counters(ctypes.Structure):
+    _fields_ = [
+        ("keys", ctypes.c_uint64),
+        ("matches", ctypes.c_uint64),
+        ("scans", ctypes.c_uint64),
+        ("threads", ctypes.c_int32),
+        ("batch", ctypes.c_int32),
+    ]
+
+
+_lib = None
+
+
+def load(path=LIB_PATH):
+    """Load libc_scanner.so once and declare its signatures."""
+    global _lib
+    if _lib is None:
+        lib = ctypes.CDLL(path)
+        lib.scanner_engine_init.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_char_p, ctypes.c_char_p]
+        lib.scanner_engine_init.restype = ctypes.c_int
+        lib.scanner_engine_set_targets.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+        lib.scanner_engine_set_targets.restype = ctypes.c_int
+        lib.scanner_engine_scan.argtypes = [ctypes.c_uint64, ctypes.c_uint64, ctypes.c_uint64,
+                                            MATCH_FN, ctypes.c_void_p]
+        lib.scanner_engine_scan.restype = ctypes.c_int64
+        lib.scanner_engine_stop.argtypes = []
+        lib.scanner_engine_stop.restype = None
+        lib.scanner_engine_counters.argtypes = [ctypes.POINTER(Counters)]
+        lib.scanner_engine_counters.restype = None
+        lib.scanner_engine_info.argtypes = []
+        lib.scanner_engine_info.restype = ctypes.c_char_p
+        lib.scanner_engine_shutdown.argtypes = []
+        lib.scanner_engine_shutdown.restype = None
+        _lib = lib
+    return _lib
+
+
+class CEngine:
+    """One engine per process (the library keeps global state)."""
+
+    def __init__(self, threads=4, batch=0, engine=None, isa=None, path=LIB_PATH):
+        self.lib = load(path)
+        rc = self.lib.scanner_engine_init(threads, batch,
+                                          engine.encode() if engine else None,
+                                          isa.encode() if isa else None)
+        if rc != 0:
+            raise RuntimeError("scanner_engine_init failed (check engine / isa / batch)")
+
+    def set_targets(self, h160s):
+        """Target set from an iterable of 20-byte hash160s (one buffer, copied once)."""
+        blob = b"".join(h160s)
+        if not blob or len(blob) % 20:
+            raise ValueError("targets must be 20-byte hash160s")
+        if self.lib.scanner_engine_set_targets(blob, len(blob) // 20) != 0:
+            raise RuntimeError("scanner_engine_set_targets failed")
+
+    def scan(self, start, count, on_match=None):
+        """Check keys start .. start+count-1 on all engine threads.
+
+        on_match(key, h160) runs on an engine thread (serialized) for each
+        hit.  Returns the number of keys checked, short of count after stop().
+        """
+        def cb(_user, hi, lo, h160):
+            if on_match is not None:
+                on_match((hi << 64) | lo, bytes(h160.contents))
+        fn = MATCH_FN(cb)
+        n = self.lib.scanner_engine_scan(start >> 64, start & 0xFFFFFFFFFFFFFFFF, count, fn, None)
+        if n < 0:
+            raise RuntimeError("scanner_engine_scan failed")
+        return n
+
+    def stop(self):
+        self.lib.scanner_engine_stop()
+
+    def counters(self):
+        c = Counters()
+        self.lib.scanner_engine_counters(ctypes.byref(c))
+        return {name: getattr(c, name) for name, _ in Counters._fields_}
+
+    def info(self):
+        return self.lib.scanner_engine_info().decode()
+
+    def close(self):
+        self.lib.scanner_engine_shutdown()
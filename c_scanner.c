@@ -15,11 +15,111 @@
  *      (fastest form of EC point addition, no inversions)
  *   4. Direct secp256k1_eckey_pubkey_serialize33 (no public API overhead)
  *   5. Lock-free atomic counters, fast xorshift PRNG
+ *   6. AFFINE STEPPING engine (default): P + iG computed directly in affine
+ *      from a precomputed table of 1G..BATCH_SIZE*G, with all BATCH_SIZE
+ *      slope denominators (x_iG - x_P) sharing one batched inversion.
+ *      Roughly half the field multiplications per key of Jacobian stepping.
+ *   7. CENTER-OUT engine: each batch is generated from its midpoint C as
+ *      C + iG and C - iG, which share the inverse of (x_iG - x_C), so only
+ *      BATCH_SIZE/2 + 1 denominators per batch go through the inversion.
+ *   8. MULTI-BUFFER hash160: 8 / 16 pubkeys per SHA256+RIPEMD160 pass in
+ *      AVX2 / AVX-512 lanes (sha256_rmd160_simd.h)
+ *   9. SHA-NI SHA256 when CPUID reports SHA extensions (checked at startup)
+ *  10. Hash input straight from the field element: X is read from the 5x52
+ *      limbs into the SHA256 message words (no 33-byte serialize / reload),
+ *      and both compressions are specialized for the fixed-size input
+ *  11. WORK UNITS (--units): the range is cut into 2^48 numbered units of
+ *      2^22 keys, claimed through one atomic counter and a seeded
+ *      permutation, so threads never overlap and completed units are
+ *      checkpointed; a restart resumes from the checkpoint file
+ *  12. COORDINATOR client (--coordinator=HOST:PORT): units are leased from
+ *      work_coordinator.py instead, so a whole fleet shares one permutation
+ *      and one coverage ledger; heartbeats carry the node's key rate
+ *  13. MULTI-TARGET (--targets=FILE): any number of hash160s / P2PKH
+ *      addresses checked per key through a bit filter on the first hash160
+ *      word (kept in L1/L2), with a binary search only on filter hits
+ *  14. GPU BACKEND (--gpu=LIST, built with -DWITH_CUDA): one worker thread
+ *      per CUDA device claims work units like a CPU thread and scans them
+ *      with gpu_engine.cu; hits are re-derived on the CPU before reporting
+ *  15. LIBRARY BUILD (-DSCANNER_LIBRARY -shared): the engine as
+ *      libc_scanner.so behind scanner_engine.h, driven from Python through
+ *      c_engine.py (turbo_scanner.py --engine=c)
+ *  16. FUSED engine (--engine=fused): affine stepping with the hash in the
+ *      backward pass; points go straight into the SIMD hash lanes and are
+ *      checked one lane-sized tile at a time, so no batch of points is
+ *      stored between the stages (one shared inversion per batch remains)
+ *  17. SIMD engine (--engine=simd, AVX-512 IFMA): 8 independent chains per
+ *      thread, one per 64-bit lane, with the field multiply on 52-bit
+ *      multiply-add; the chains' points feed the hash lanes directly
+ *  18. SELF-TEST (--selftest): planted keys at batch, chain, chunk and 2^64
+ *      edges through the workers' scan loop for every engine; --sample=N
+ *      re-derives one key in N batches with libsecp256k1 while scanning
+ *  19. COVERAGE LEDGER (--ledger[=FILE]): completed units are appended to
+ *      the binary ledger shared with turbo_scanner.py, work_coordinator.py
+ *      and BitCrack imports (coverage_ledger.py); covered units are skipped
+ *      when claiming and random starts become unit-aligned
+ *  20. GIANT-STEP SEEKS: a start up to GIANT_STEPS chunk strides past where
+ *      the stream already is (the next unit of a sequential claim order, a
+ *      random run continued past a short --batches chunk) is one point
+ *      addition from a precomputed table instead of a scalar multiplication;
+ *      GPU launch start points share one batched inversion
+ *  21. STRIDED SCAN (--stride=I/N): node I of N scans only the keys
+ *      2^70 + I + j*N, stepping by N*G from a strided step table, so any
+ *      number of nodes split the range with no coordinator at the same
+ *      per-key cost; work units and checkpoints count along the progression
+ *  22. PREEMPTION DRAIN: workers publish how far each unit is scanned as
+ *      they go; the checkpoint keeps it as "partial" records, SIGTERM gets
+ *      it fsynced within DRAIN_DEADLINE_MS and the next start resumes those
+ *      units mid-way
+ *  23. WORK STEALING (--units): each worker holds a range of batches of a
+ *      unit in one CAS-able word; an idle worker splits off the back half
+ *      of the largest range before it claims a new unit, so slow cores
+ *      (E-cores, stolen vCPU time) never hold up a unit or a lease
+ *  24. KERNEL REGISTRY: the fused and simd kernels are instantiated per
+ *      hash tile, field code and batch size (KERNEL_BATCHES), the batch a
+ *      compile-time constant; startup and --autotune pick the exact match
+ *      for the running BATCH_SIZE, else the generic instance
+ *  25. CANDIDATE QUEUE: a target match only pushes its key into the
+ *      worker's lock-free ring and the scan goes on; a verifier thread
+ *      re-derives it with ecmult_gen and does the printing, file and
+ *      coordinator I/O, so no worker ever blocks on a report
+ *  26. CPU+GPU CO-SCHEDULING (--gpu): each GPU feeder keeps --gpu-cores
+ *      CPUs to itself, CPU workers are parked while the GPUs' measured
+ *      rate sags and probed back in when it holds, and coordinator leases
+ *      are sized to COORD_LEASE_SECS of the box's measured rate
+ *  27. POINT TABLE CACHE: the step, giant-step and GPU stride tables are
+ *      built once per host into checksummed files (--table-cache) and
+ *      mapped read-only by later starts, so every process on the box
+ *      shares one copy in the page cache
+ *  28. ENERGY GOVERNOR (--governor=rate|energy, --power-cap=W): RAPL or
+ *      hwmon energy is read next to the key rate; a sweep before the scan
+ *      tries engine x hash ISA x CPU worker count and keeps the best keys/s
+ *      or keys/J under the cap, and workers are parked while the box runs
+ *      over the cap
  *
- * Compile (from secp256k1_src directory):
- *   gcc -O3 -march=native -I/root/secp256k1_src/include -I/root/secp256k1_src/src \
+ * Usage:
+ *   c_scanner [threads] [--engine=affine|center|fused|jacobian|simd]
+ *             [--units] [--checkpoint=FILE] [--seed=HEX]
+ *             [--coordinator=HOST:PORT] [--node=NAME] [--lease=UNITS]
+ *             [--targets=FILE] [--batch=N] [--batches=N] [--autotune]
+ *             [--bench[=FILE]] [--stats=FILE] [--stage-timing]
+ *             [--metrics-port=PORT] [--pin=core|smt]
+ *             [--isa=auto|scalar|avx2|avx512] [--sha=auto|shani|generic]
+ *             [--gpu=ID[,ID...]] [--selftest] [--sample=N] [--ledger[=FILE]]
+ *             [--stride=I/N] [--gpu-cores=N] [--no-cosched]
+ *             [--table-cache=DIR|off] [--governor[=rate|energy]] [--power-cap=W]
+ *
+ * Compile (from secp256k1_src directory).  The hash kernels and field code
+ * carry their own AVX2 / AVX-512 / SHA-NI / BMI2 variants and pick one at
+ * startup, so one baseline build runs on every rented host:
+ *   gcc -O3 -march=x86-64-v2 -I/root/secp256k1_src/include -I/root/secp256k1_src/src \
  *       -I/root/secp256k1_src -Wno-deprecated-declarations -Wno-unused-function \
  *       -o /root/puzzle71/c_scanner /root/puzzle71/c_scanner.c -lcrypto -lpthread
+ *
+ * With the GPU backend (CUDA toolkit; see gpu_engine.h):
+ *   nvcc -O3 -arch=sm_86 -c /root/puzzle71/gpu_engine.cu -o /root/puzzle71/gpu_engine.o
+ *   gcc ... -DWITH_CUDA -o /root/puzzle71/c_scanner /root/puzzle71/c_scanner.c \
+ *       /root/puzzle71/gpu_engine.o -L/usr/local/cuda/lib64 -lcudart -lstdc++ -lcrypto -lpthread
  */
 
 #define _GNU_SOURCE
@@ -30,6 +130,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdatomic.h>
 #include <pthread.h>
@@ -37,7 +139,20 @@
 #include <unistd.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <dirent.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 /* Include secp256k1 source as single compilation unit */
 #include "include/secp256k1.h"
@@ -66,6 +181,13 @@
 /* Custom optimized SHA256 and RIPEMD160 (specialized for 33 and 32 byte inputs) */
 #include "/root/puzzle71/sha256_rmd160_fast.h"
 
+#ifdef WITH_CUDA
+#include "/root/puzzle71/gpu_engine.h"
+#endif
+
+/* C API for the -DSCANNER_LIBRARY build (libc_scanner.so) */
+#include "/root/puzzle71/scanner_engine.h"
+
 /* ======================== Configuration ======================== */
 
 static const unsigned char TARGET_H160[20] = {
@@ -74,31 +196,473 @@ static const unsigned char TARGET_H160[20] = {
     0x44, 0xa0, 0xa5, 0xb8
 };
 
-static uint32_t TARGET_PREFIX;
+/* Target set bit filter: >= TARGET_FILTER_RATIO bits per target, clamped
+ * to 4 KB .. 2 MB so it stays L1/L2 resident.  A false positive (rate
+ * <= 1/TARGET_FILTER_RATIO below the cap) costs one binary search. */
+#define TARGET_FILTER_MIN_BITS 15
+#define TARGET_FILTER_MAX_BITS 24
+#define TARGET_FILTER_RATIO    256
 
-/* Batch size for batch inversion */
-#define BATCH_SIZE     2048
+/* Work units: unit u covers keys 2^70 + u*UNIT_KEYS .. + UNIT_KEYS-1 */
+#define UNIT_BITS      22
+#define UNIT_KEYS      (1ULL << UNIT_BITS)
+#define NUM_UNITS      (1ULL << (70 - UNIT_BITS))
+#define UNIT_WINDOW    4096    /* max claimed-but-unfinished span past the watermark */
+#define DRAIN_DEADLINE_MS 1500 /* after a stop request, wait this long for workers */
+#define STEAL_MIN_BATCHES 16   /* smallest range (batches per chain) worth splitting */
+#define CHECKPOINT_FILE "/root/puzzle71/data/scan_checkpoint.txt"
+#define LEDGER_FILE     "/root/puzzle71/data/coverage.ledger"
+#define LEDGER_MAGIC    "P71LEDG1"
+#define LEDGER_VERSION  1
+#define LEDGER_DRAWS    64      /* random starts tried before taking a covered one */
 
-/* How many batches per random start */
-#define NUM_BATCHES    2048
+/* Batch size for batch inversion (--batch, power of two, or --autotune) */
+#define DEFAULT_BATCH_SIZE 2048
+#define MIN_BATCH_SIZE     64
+#define MAX_BATCH_SIZE     65536
+static int BATCH_SIZE = DEFAULT_BATCH_SIZE;
+
+/* How many batches per start (--batches; by default one UNIT_KEYS chunk,
+ * and always so in work-unit mode) */
+static int NUM_BATCHES = 0;
 #define CHUNK_SIZE     ((uint64_t)BATCH_SIZE * NUM_BATCHES)
 
+/* --autotune sweep */
+#define AUTOTUNE_MIN_BATCH 256
+#define AUTOTUNE_MAX_BATCH 16384
+#define AUTOTUNE_SECONDS   0.25
+
 static int NUM_THREADS = 4;
+
+/* GPU workers (--gpu) follow the NUM_THREADS CPU workers in the telemetry
+ * arrays; each launch scans GPU_UNITS_PER_LAUNCH work units */
+#define MAX_GPUS             16
+#define GPU_UNITS_PER_LAUNCH 16
+static int g_num_gpus = 0;
+#ifdef WITH_CUDA
+static int g_gpu_ids[MAX_GPUS];
+#endif
+static int g_num_workers;          /* NUM_THREADS + g_num_gpus */
+
+/* Co-scheduler (--gpu with CPU workers in the same process).  CPU workers
+ * with tid >= g_cpu_active park between chunks; g_cpu_max is the ceiling
+ * left after g_cpu_reserved CPUs are kept for the GPU feeder threads. */
+#define COSCHED_STARVE_PCT 3     /* GPU rate drop that parks CPU workers */
+#define COSCHED_MAX_HOLD   32    /* stats intervals between probes, at most */
+#define COSCHED_PARK_US    50000
+static int        g_gpu_cores = 1;     /* --gpu-cores: CPUs per GPU feeder */
+static int        g_cosched = 1;       /* --no-cosched: CPU pool stays fixed */
+static int        g_cpu_reserved = 0;
+static atomic_int g_cpu_max = 0;
+static atomic_int g_cpu_active = 0;
+static atomic_int g_gpu_lost[MAX_GPUS];
+
+/* Energy governor (--governor).  Package energy comes from the powercap
+ * RAPL zones, else from the hwmon power sensors in g_energy_hwmon; the
+ * sweep settles engine, hash ISA and g_gov_threads CPU workers (the rest
+ * park like co-scheduled ones) for the objective, under --power-cap. */
+#define ENERGY_POWERCAP_DIR "/sys/class/powercap"
+#define ENERGY_HWMON_DIR    "/sys/class/hwmon"
+#define ENERGY_MAX_METERS   8
+#define GOVERNOR_WARMUP     0.25   /* seconds per setting before it is measured */
+#define GOVERNOR_SECONDS    1.00   /* measured seconds per setting */
+enum { GOV_OFF, GOV_RATE, GOV_ENERGY };
+static const char *GOV_NAMES[] = { "off", "rate", "energy" };
+static int    g_governor = GOV_OFF;
+static double g_power_cap = 0;       /* --power-cap: watts, 0 = none */
+static int    g_gov_threads = 0;     /* CPU workers the sweep settled on */
+static double g_gov_kpj = 0;         /* keys/J the sweep measured for them */
+static double g_energy_j = 0;        /* since the scan started (stats thread) */
+static double g_power_w = 0;         /* over the last stats interval */
 #define STATS_INTERVAL 10
+#define STATS_FILE     "/root/puzzle71/data/c_scanner_stats.json"
+#define STAGE_SAMPLE_SHIFT 4    /* --stage-timing: time 1 batch in 16 */
+
+/* Point generation engines (selected with --engine) */
+enum {
+    ENGINE_JACOBIAN = 0,   /* Jacobian add chain + secp256k1_ge_set_all_gej_var */
+    ENGINE_AFFINE   = 1,   /* Affine P + iG from g_step_table, one inversion/batch */
+    ENGINE_CENTER   = 2,   /* Affine C +- iG from the batch midpoint, shared inverses */
+    ENGINE_FUSED    = 3,   /* Affine P + iG hashed tile by tile inside the stepping pass */
+    ENGINE_SIMD     = 4    /* Fused, on SIMD_CHAINS chains at once in AVX-512 IFMA lanes */
+};
+static const char *ENGINE_NAMES[] = { "jacobian", "affine", "center", "fused", "simd" };
+#define NUM_ENGINES ((int)(sizeof(ENGINE_NAMES) / sizeof(ENGINE_NAMES[0])))
+static int g_engine = ENGINE_AFFINE;
 
 /* ======================== Global State ======================== */
 
 static atomic_ullong g_total_keys = 0;
 static atomic_int    g_found = 0;
+static int           g_sample_every = 0;   /* --sample: check 1 batch in N */
+static atomic_ullong g_samples = 0;
+static atomic_int    g_sample_failed = 0;
 static volatile sig_atomic_t g_interrupted = 0;
 static double        g_start_time_d;
 
+/* Per-thread telemetry.  Each worker is the only writer of its own entry
+ * (relaxed load + store, no locked add) and entries are cache-line aligned
+ * so workers never false-share; the stats and metrics threads only read. */
+enum { TSTAGE_GENERATE, TSTAGE_HASH, NUM_TSTAGES };
+typedef struct {
+    _Alignas(64) atomic_ullong keys;
+    atomic_ullong batches;
+    atomic_ullong starts;              /* start points (ecmult_gen) */
+    atomic_ullong sampled_batches;     /* batches timed with --stage-timing */
+    atomic_ullong ticks[NUM_TSTAGES];  /* TSC cycles in sampled batches */
+} thread_stats_t;
+static thread_stats_t *g_thread_stats;
+static const char    *g_stats_path = STATS_FILE;  /* --stats */
+static int            g_stage_timing = 0;         /* --stage-timing */
+#ifndef SCANNER_LIBRARY
+static int            g_metrics_port = 0;         /* --metrics-port */
+#endif
+
+static inline void tstat_add(atomic_ullong *c, uint64_t v) {
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + v,
+                          memory_order_relaxed);
+}
+
 /* Generator point G in affine coordinates */
 static secp256k1_ge g_gen_affine;
 
 /* secp256k1 context for ecmult_gen (initial scalar multiplication) */
 static secp256k1_ecmult_gen_context g_ecmult_gen_ctx;
 
+/* Affine multiples of G: g_step_table[i] = (i+1)*G, i = 0..g_step_table_size-1
+ * (at least BATCH_SIZE; larger while --autotune tries bigger batches).  A
+ * point table (ptable_get): a read-only cache file mapping, or built. */
+static const secp256k1_ge *g_step_table;
+static int           g_step_table_size;
+static size_t        g_step_table_len;
+
+/* Point table cache (--table-cache; NULL when off) */
+#define TABLE_CACHE_DIR "/root/puzzle71/data/tables"
+#define PTABLE_MAGIC    "P71PTBL"
+#define PTABLE_VERSION  1
+static const char   *g_table_dir = TABLE_CACHE_DIR;
+static int           g_tables_mapped = 0, g_tables_built = 0;
+static double        g_tables_secs = 0;
+
+/* Giant steps: g_giant_table[j] = (j+1) * g_giant_stride * G, j < GIANT_STEPS,
+ * with g_giant_stride one chain's share of a chunk.  A stream is moved that
+ * far ahead by one addition; g_seeks counts seeks [full, by giant step]. */
+#define GIANT_STEPS 1024
+static const secp256k1_ge *g_giant_table;
+static size_t        g_giant_len;
+static uint64_t      g_giant_stride;
+static atomic_ullong g_seeks[2];
+
+/* --stride=I/N: keys 2^70 + g_key_residue + j * g_key_stride.  Every step
+ * table holds multiples of g_key_stride * G, offsets inside a stream count
+ * along the progression, and work unit u covers j = u*UNIT_KEYS onwards,
+ * so only g_stride_units units exist.  Set after the startup tests. */
+static uint64_t      g_key_stride = 1;
+static uint64_t      g_key_residue = 0;
+static uint64_t      g_stride_units = NUM_UNITS;
+
+/* BMI2 build of the stepping engines, chosen at startup from CPUID */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define FIELD_DISPATCH 1
+#else
+#define FIELD_DISPATCH 0
+#endif
+#define SCANNER_ALWAYS_INLINE inline __attribute__((always_inline))
+static int           g_field_bmi2 = 0;
+
+/* AVX-512 IFMA field code for the simd engine (5x52 limbs need int128) */
+#if FIELD_DISPATCH && defined(SECP256K1_WIDEMUL_INT128)
+#define SIMD_FIELD 1
+#else
+#define SIMD_FIELD 0
+#endif
+#define SIMD_CHAINS 8
+static int           g_simd_ifma = 0;   /* CPU has AVX-512 IFMA */
+static int           g_chains = 1;      /* chains per stream: SIMD_CHAINS for simd */
+
+/* g_step_table as normalized limbs, broadcast into every lane by simd */
+typedef struct {
+    uint64_t x[5], y[5];
+} simd_step_t;
+static simd_step_t  *g_simd_step;
+static size_t        g_simd_step_len;
+
+/* --pin: one worker per physical core (core) or per SMT thread (smt) */
+#define MAX_CPUS       1024
+#define MAX_NODES      64
+#define ARENA_ALIGN    ((size_t)2 << 20)   /* 2MB huge page */
+enum { PIN_NONE, PIN_CORE, PIN_SMT };
+typedef struct {
+    int cpu, core, pkg, node, smt;
+} cpu_info_t;
+static cpu_info_t g_cpus[MAX_CPUS];
+static int        g_num_cpus;
+static int        g_pin_mode = PIN_NONE;
+static atomic_int g_arena_hugetlb = 0;
+
+/* Per-NUMA-node replicas of g_step_table; a pinned worker reads its node's */
+static const secp256k1_ge *g_node_step_table[MAX_NODES];
+static size_t              g_node_step_len[MAX_NODES];
+static pthread_mutex_t     g_node_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread const secp256k1_ge *t_step_table;
+
+static inline const secp256k1_ge *step_table(void) {
+    return t_step_table ? t_step_table : g_step_table;
+}
+
+/* Work-unit mode (--units).  Sequence numbers are handed out by g_unit_next
+ * and mapped to unit indices by unit_permute(); every sequence number below
+ * g_unit_done_below is complete, and g_unit_done[seq % UNIT_WINDOW] flags
+ * completed ones above it. */
+static int           g_units_mode = 0;
+static const char   *g_checkpoint_path = CHECKPOINT_FILE;
+static uint64_t      g_unit_seed;
+static atomic_ullong g_unit_next;
+static atomic_ullong g_unit_done_below;
+static atomic_uchar  g_unit_done[UNIT_WINDOW];
+static pthread_mutex_t g_unit_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int    g_units_exhausted = 0;
+
+/* Work stealing.  A claimed unit is a job: `left` batches (per chain) not
+ * yet scanned and `front`, below which every batch is scanned (the
+ * checkpoint's partial record).  Each CPU worker holds one range of one job
+ * in its slot, packed as (job + 1) << 48 | end << 24 | next: the holder takes
+ * batches from the front with a CAS each, thieves CAS the back half off the
+ * end, and the job index in the word keeps a thief from splitting a range
+ * that has since moved to another unit.  Jobs are taken and dropped under
+ * g_unit_lock.  Resume entries are the checkpoint's "partial" records not
+ * yet claimed again: chain c of `chains` has scanned `keys` keys from its
+ * start. */
+typedef struct {
+    uint64_t      seq, lease, hi, lo;
+    atomic_uint   left, front;
+    int           busy;
+} unit_job_t;
+typedef struct {
+    _Alignas(64) atomic_ullong range;
+    unsigned      taken;               /* batches this holder took (own use) */
+} steal_slot_t;
+typedef struct { uint64_t seq, keys; unsigned chains; } unit_resume_t;
+static unit_job_t   *g_jobs;           /* 2 * NUM_THREADS: a job outlives its claimer's range */
+static int           g_njobs;
+static steal_slot_t *g_slots;
+static atomic_ullong g_steals = 0;
+static unit_resume_t g_unit_resume[UNIT_WINDOW];
+static int           g_unit_nresume = 0;
+static pthread_mutex_t g_checkpoint_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int    g_workers_live = 0;
+
+/* Candidate queue: one single-producer ring per worker (CPU or GPU), read
+ * by the verifier thread.  head is the worker's, tail the verifier's. */
+#define CAND_RING     64        /* power of two */
+#define CAND_POLL_US  1000
+typedef struct {
+    _Alignas(64) atomic_uint head;
+    _Alignas(64) atomic_uint tail;
+    uint64_t hi[CAND_RING], lo[CAND_RING];
+} cand_ring_t;
+static cand_ring_t  *g_cand_rings;     /* g_num_workers */
+static atomic_int    g_cand_stop = 0;
+static atomic_ullong g_cand_pushed = 0, g_cand_confirmed = 0, g_cand_rejected = 0;
+
+/* Coverage ledger (--ledger, format in coverage_ledger.py): a 32-byte
+ * header, then {first, end} unit runs.  The first `sorted` runs are merged
+ * and disjoint and are searched in the mapping; the appended tail is read
+ * once at startup into g_ledger_tail, sorted and merged. */
+typedef struct { uint64_t first, end; } ledger_run_t;
+static const char   *g_ledger_path = NULL;
+static int           g_ledger_fd = -1;
+static void         *g_ledger_map = NULL;
+static size_t        g_ledger_map_len = 0;
+static const ledger_run_t *g_ledger_sorted = NULL;
+static size_t        g_ledger_nsorted = 0;
+static ledger_run_t *g_ledger_tail = NULL;
+static size_t        g_ledger_ntail = 0;
+static pthread_mutex_t g_ledger_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_ullong g_ledger_skipped = 0;
+
+/* Targets checked per key (--targets, default: TARGET_H160 only).  h160 is
+ * sorted; filter has bit (w0 & filter_mask) set for the first little-endian
+ * hash160 word w0 of every target. */
+typedef struct {
+    uint32_t *filter;
+    uint32_t  filter_mask;
+    int       filter_bits;
+    size_t    count;
+    unsigned char (*h160)[20];
+} target_set_t;
+static target_set_t g_targets;
+#ifndef SCANNER_LIBRARY
+static const char  *g_targets_path = NULL;        /* --targets */
+#endif
+
+/* Coordinator client (--coordinator): one connection, one request at a time */
+#define COORD_LEASE_MAX 4096
+static const char   *g_coord_addr = NULL;
+static char          g_node_name[64];
+static int           g_coord_lease_units = 0;  /* 0: sized from the measured rate */
+#define COORD_LEASE_SECS 60
+static atomic_int    g_coord_lease_auto = 0;   /* COORD_LEASE_SECS of keys, in units */
+static int           g_coord_fd = -1;
+static pthread_mutex_t g_coord_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t      g_lease_id;
+static uint64_t      g_lease_seq[COORD_LEASE_MAX];
+static int           g_lease_n = 0, g_lease_pos = 0;
+
+/* ======================== Coordinator Client ======================== */
+
+/* Send one request line and read the one-line reply (without the newline).
+ * Caller holds g_coord_lock.  Returns 0 on a connection error. */
+static int coord_roundtrip(const char *req, char *reply, size_t cap) {
+    size_t len = strlen(req), off = 0;
+    while (off < len) {
+        ssize_t w = send(g_coord_fd, req + off, len - off, MSG_NOSIGNAL);
+        if (w <= 0) return 0;
+        off += (size_t)w;
+    }
+    size_t got = 0;
+    for (;;) {
+        ssize_t r = recv(g_coord_fd, reply + got, cap - 1 - got, 0);
+        if (r <= 0) return 0;
+        got += (size_t)r;
+        reply[got] = '\0';
+        char *nl = strchr(reply, '\n');
+        if (nl) { *nl = '\0'; return 1; }
+        if (got == cap - 1) return 0;
+    }
+}
+
+/* (Re)connect and say HELLO; retries until connected or the scan stops.
+ * Caller holds g_coord_lock. */
+static int coord_connect(void) {
+    char host[256], reply[256], hello[384];
+    const char *colon = strrchr(g_coord_addr, ':');
+    if (!colon || colon == g_coord_addr || (size_t)(colon - g_coord_addr) >= sizeof(host)) {
+        fprintf(stderr, "Coordinator: expected HOST:PORT, got '%s'\n", g_coord_addr);
+        return 0;
+    }
+    memcpy(host, g_coord_addr, colon - g_coord_addr);
+    host[colon - g_coord_addr] = '\0';
+    const char *token = getenv("COORDINATOR_TOKEN");
+    snprintf(hello, sizeof(hello), "HELLO %s %s\n", g_node_name, token ? token : "");
+
+    for (int attempt = 0; !atomic_load(&g_found); attempt++) {
+        if (g_coord_fd >= 0) { close(g_coord_fd); g_coord_fd = -1; }
+        if (attempt > 0) sleep(attempt < 6 ? attempt : 30);
+
+        struct addrinfo hints = {0}, *res = NULL;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host, colon + 1, &hints, &res) != 0) continue;
+        for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+            int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd < 0) continue;
+            if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) { g_coord_fd = fd; break; }
+            close(fd);
+        }
+        freeaddrinfo(res);
+        if (g_coord_fd < 0) {
+            fprintf(stderr, "Coordinator: cannot reach %s, retrying\n", g_coord_addr);
+            continue;
+        }
+        struct timeval tv = { .tv_sec = 30, .tv_usec = 0 };
+        int one = 1;
+        setsockopt(g_coord_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(g_coord_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if (!coord_roundtrip(hello, reply, sizeof(reply))) continue;
+        if (strncmp(reply, "OK ", 3) != 0) {
+            fprintf(stderr, "Coordinator: %s\n", reply);
+            close(g_coord_fd);
+            g_coord_fd = -1;
+            return 0;
+        }
+        g_unit_seed = strtoull(reply + 3, NULL, 16);
+        return 1;
+    }
+    return 0;
+}
+
+/* One request with a reconnect + resend on connection loss; returns 1 if
+ * the reply starts with OK.  Leases held across a reconnect stay valid.
+ * Also called from the stats thread, so cancellation is held off while
+ * g_coord_lock is taken. */
+static int coord_request(const char *req, char *reply, size_t cap) {
+    int cancel_state;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancel_state);
+    pthread_mutex_lock(&g_coord_lock);
+    int ok = 0;
+    for (int attempt = 0; attempt < 2 && !ok; attempt++) {
+        if (g_coord_fd < 0 && !coord_connect()) break;
+        if (coord_roundtrip(req, reply, cap)) {
+            ok = 1;
+        } else {
+            close(g_coord_fd);
+            g_coord_fd = -1;
+        }
+    }
+    pthread_mutex_unlock(&g_coord_lock);
+    pthread_setcancelstate(cancel_state, NULL);
+    if (!ok) snprintf(reply, cap, "ERR connection");
+    return ok && strncmp(reply, "OK", 2) == 0;
+}
+
+/* Next leased sequence number, fetching a new lease when the current one is
+ * used up.  Returns 0 when the coordinator has nothing left. */
+static int coord_claim(uint64_t *lease, uint64_t *seq) {
+    static char reply[COORD_LEASE_MAX * 21 + 64];
+    pthread_mutex_lock(&g_unit_lock);
+    while (g_lease_pos >= g_lease_n) {
+        char req[64];
+        /* Before the first stats interval: 8 units per thread, 2 launches per GPU */
+        int want = g_coord_lease_units ? g_coord_lease_units : atomic_load(&g_coord_lease_auto);
+        if (!want) want = NUM_THREADS * 8 + g_num_gpus * 2 * GPU_UNITS_PER_LAUNCH;
+        if (want > COORD_LEASE_MAX) want = COORD_LEASE_MAX;
+        snprintf(req, sizeof(req), "LEASE %d\n", want);
+        if (!coord_request(req, reply, sizeof(reply))) {
+            if (strcmp(reply, "ERR exhausted") == 0) {
+                atomic_store(&g_units_exhausted, 1);
+                pthread_mutex_unlock(&g_unit_lock);
+                return 0;
+            }
+            fprintf(stderr, "Coordinator: LEASE failed (%s)\n", reply);
+            pthread_mutex_unlock(&g_unit_lock);
+            if (atomic_load(&g_found)) return 0;
+            sleep(5);
+            pthread_mutex_lock(&g_unit_lock);
+            continue;
+        }
+        char *p = reply + 3, *end;
+        g_lease_id = strtoull(p, &end, 10);
+        g_lease_n = g_lease_pos = 0;
+        for (p = end; g_lease_n < COORD_LEASE_MAX; p = end) {
+            uint64_t v = strtoull(p, &end, 10);
+            if (end == p) break;
+            g_lease_seq[g_lease_n++] = v;
+        }
+    }
+    *lease = g_lease_id;
+    *seq = g_lease_seq[g_lease_pos++];
+    pthread_mutex_unlock(&g_unit_lock);
+    return 1;
+}
+
+static void coord_done(uint64_t lease, uint64_t seq) {
+    char req[96], reply[64];
+    snprintf(req, sizeof(req), "DONE %llu %llu\n",
+             (unsigned long long)lease, (unsigned long long)seq);
+    if (!coord_request(req, reply, sizeof(reply)))
+        fprintf(stderr, "Coordinator: DONE %llu not recorded (%s)\n",
+                (unsigned long long)seq, reply);
+}
+
+static void coord_heartbeat(unsigned long long total, double rate) {
+    char req[96], reply[64];
+    snprintf(req, sizeof(req), "HEARTBEAT %llu %.0f\n", total, rate);
+    if (!coord_request(req, reply, sizeof(reply)))
+        fprintf(stderr, "Coordinator: heartbeat failed (%s)\n", reply);
+}
+
 /* ======================== Utility Functions ======================== */
 
 /* hash160 wrapper using optimized implementations */
@@ -130,12 +694,27 @@ static inline uint64_t xorshift64_next(xorshift64_t *rng) {
     return x * 0x2545F4914F6CDD1DULL;
 }
 
+/* Random chunk start in [2^70, 2^71): hi carries key bits 64..70 */
 static void random_start(xorshift64_t *rng, uint64_t *hi, uint64_t *lo) {
     uint64_t r = xorshift64_next(rng);
-    *hi = 0x4ULL + (r & 0x3ULL);
+    *hi = 0x40ULL + (r & 0x3FULL);
     *lo = xorshift64_next(rng);
 }
 
+/* (hi, lo) moved m keys along the progression (m * g_key_stride) */
+static inline void key_step(uint64_t *hi, uint64_t *lo, uint64_t m) {
+    unsigned __int128 k = ((unsigned __int128)*hi << 64 | *lo) + (unsigned __int128)m * g_key_stride;
+    *hi = (uint64_t)(k >> 64);
+    *lo = (uint64_t)k;
+}
+
+/* Key j of the progression: 2^70 + g_key_residue + j * g_key_stride */
+static inline void key_at(unsigned __int128 j, uint64_t *hi, uint64_t *lo) {
+    unsigned __int128 k = ((unsigned __int128)0x40 << 64) + g_key_residue + j * g_key_stride;
+    *hi = (uint64_t)(k >> 64);
+    *lo = (uint64_t)k;
+}
+
 static void format_privkey(char *buf, uint64_t hi, uint64_t lo) {
     sprintf(buf, "0x%llX%016llX",
             (unsigned long long)hi, (unsigned long long)lo);
@@ -157,134 +736,3511 @@ static void make_scalar(secp256k1_scalar *s, uint64_t hi, uint64_t lo) {
     secp256k1_scalar_set_b32(s, b32, &overflow);
 }
 
-static double get_time_sec(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return tv.tv_sec + tv.tv_usec / 1e6;
+static double get_time_sec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* Time-stamp counter for --bench (0 where there is none) */
+static inline uint64_t read_tsc(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void report_found(uint64_t hi, uint64_t lo, const unsigned char h160[20]) {
+    char keystr[64], h160str[41];
+    format_privkey(keystr, hi, lo);
+    for (int i = 0; i < 20; i++)
+        sprintf(h160str + 2 * i, "%02x", h160[i]);
+    int primary = memcmp(h160, TARGET_H160, 20) == 0;
+
+    printf("\n");
+    printf("============================================================\n");
+    printf("  %s KEY FOUND!\n", primary ? "PUZZLE #71" : "TARGET");
+    printf("  Private Key: %s\n", keystr);
+    printf("  Hash160: %s\n", h160str);
+    printf("============================================================\n");
+    fflush(stdout);
+
+    /* Appended and synced: a second target match never replaces the first */
+    FILE *f = fopen("/root/puzzle71/FOUND_KEY.txt", "a");
+    if (f) {
+        fprintf(f, "%s\n", primary ? "PUZZLE #71 SOLUTION" : "TARGET SET MATCH");
+        fprintf(f, "Private Key: %s\n", keystr);
+        if (primary)
+            fprintf(f, "Target: 1PWo3JeB9jrGwfHDNpdGK54CRas7fsVzXU\n");
+        fprintf(f, "Hash160: %s\n", h160str);
+        time_t now = time(NULL);
+        fprintf(f, "Found: %s", ctime(&now));
+        unsigned long long total = atomic_load(&g_total_keys);
+        fprintf(f, "Total keys checked: %llu\n", total);
+        fflush(f);
+        fsync(fileno(f));
+        fclose(f);
+    }
+
+    if (g_coord_addr) {
+        char req[96], reply[64];
+        snprintf(req, sizeof(req), "FOUND %s\n", keystr);
+        coord_request(req, reply, sizeof(reply));
+    }
+
+    atomic_store(&g_found, 1);
+}
+
+/* ======================== Target Set ======================== */
+
+static int h160_cmp(const void *a, const void *b) {
+    return memcmp(a, b, 20);
+}
+
+static inline uint32_t h160_word0(const unsigned char h160[20]) {
+    return (uint32_t)h160[0] | ((uint32_t)h160[1] << 8) |
+           ((uint32_t)h160[2] << 16) | ((uint32_t)h160[3] << 24);
+}
+
+/* Early reject on the first hash160 word: one load + bit test per key */
+static inline int target_filter_hit(const target_set_t *t, uint32_t w0) {
+    uint32_t i = w0 & t->filter_mask;
+    return (t->filter[i >> 5] >> (i & 31)) & 1;
+}
+
+static inline int target_set_contains(const target_set_t *t, const unsigned char h160[20]) {
+    return bsearch(h160, t->h160, t->count, 20, h160_cmp) != NULL;
+}
+
+/* Sort, deduplicate and index n hash160s (takes ownership of h160) */
+static int target_set_build(target_set_t *t, unsigned char (*h160)[20], size_t n) {
+    qsort(h160, n, 20, h160_cmp);
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (m == 0 || memcmp(h160[m - 1], h160[i], 20) != 0)
+            memcpy(h160[m++], h160[i], 20);
+    }
+    int bits = TARGET_FILTER_MIN_BITS;
+    while (bits < TARGET_FILTER_MAX_BITS && ((uint64_t)1 << bits) < (uint64_t)m * TARGET_FILTER_RATIO)
+        bits++;
+    uint32_t *filter = (uint32_t *)calloc(((size_t)1 << bits) / 32, sizeof(uint32_t));
+    if (!filter) return 0;
+    t->filter = filter;
+    t->filter_bits = bits;
+    t->filter_mask = (uint32_t)(((uint64_t)1 << bits) - 1);
+    t->count = m;
+    t->h160 = h160;
+    for (size_t i = 0; i < m; i++) {
+        uint32_t b = h160_word0(h160[i]) & t->filter_mask;
+        t->filter[b >> 5] |= 1u << (b & 31);
+    }
+    return 1;
+}
+
+static void target_set_free(target_set_t *t) {
+    free(t->filter);
+    free(t->h160);
+    memset(t, 0, sizeof(*t));
+}
+
+/* P2PKH address (base58check, version 0x00) -> hash160; 0 if invalid */
+static int p2pkh_to_h160(const char *addr, unsigned char h160[20]) {
+    static const char B58[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    unsigned char raw[25] = {0};
+    size_t len = strlen(addr);
+    if (len < 26 || len > 35) return 0;
+    for (size_t i = 0; i < len; i++) {
+        const char *c = strchr(B58, addr[i]);
+        if (!c || !addr[i]) return 0;
+        int carry = (int)(c - B58);
+        for (int j = 24; j >= 0; j--) {
+            carry += 58 * raw[j];
+            raw[j] = (unsigned char)carry;
+            carry >>= 8;
+        }
+        if (carry) return 0;
+    }
+    unsigned char d[32];
+    secp256k1_sha256 sha;
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, raw, 21);
+    secp256k1_sha256_finalize(&sha, d);
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, d, 32);
+    secp256k1_sha256_finalize(&sha, d);
+    if (raw[0] != 0x00 || memcmp(d, raw + 21, 4) != 0) return 0;
+    memcpy(h160, raw + 1, 20);
+    return 1;
+}
+
+/*
+ * Load targets from a file: one per line, 40-hex hash160 or a P2PKH
+ * address as the first token ('#' starts a comment).  Hashes of
+ * compressed pubkeys are what the scanner produces, so other address
+ * types are skipped with a warning.
+ */
+static int target_set_load(target_set_t *t, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Targets: cannot open %s\n", path);
+        return 0;
+    }
+    size_t n = 0, cap = 1024;
+    unsigned char (*h160)[20] = malloc(cap * 20);
+    char line[512], tok[128];
+    int lineno = 0;
+    while (h160 && fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        if (sscanf(line, "%127s", tok) != 1) continue;
+        if (n == cap) {
+            cap *= 2;
+            void *grown = realloc(h160, cap * 20);
+            if (!grown) { free(h160); h160 = NULL; break; }
+            h160 = grown;
+        }
+        int ok = 0;
+        if (strlen(tok) == 40) {
+            ok = 1;
+            for (int i = 0; i < 20 && ok; i++) {
+                unsigned int byte;
+                if (!isxdigit((unsigned char)tok[2*i]) || !isxdigit((unsigned char)tok[2*i+1]) ||
+                    sscanf(tok + 2 * i, "%2x", &byte) != 1) ok = 0;
+                else h160[n][i] = (unsigned char)byte;
+            }
+        } else {
+            ok = p2pkh_to_h160(tok, h160[n]);
+        }
+        if (ok) n++;
+        else fprintf(stderr, "Targets: %s:%d: skipping '%s' (not a hash160 or P2PKH address)\n",
+                     path, lineno, tok);
+    }
+    fclose(f);
+    if (!h160) {
+        fprintf(stderr, "Targets: out of memory\n");
+        return 0;
+    }
+    if (n == 0) {
+        fprintf(stderr, "Targets: no usable entries in %s\n", path);
+        free(h160);
+        return 0;
+    }
+    if (!target_set_build(t, h160, n)) {
+        free(h160);
+        return 0;
+    }
+    return 1;
+}
+
+/* ======================== Coverage Ledger ======================== */
+
+static int ledger_run_cmp(const void *a, const void *b) {
+    const ledger_run_t *x = a, *y = b;
+    return x->first < y->first ? -1 : x->first > y->first;
+}
+
+/* Open (creating) the ledger, map it and merge the appended tail */
+static int ledger_open(void) {
+    g_ledger_fd = open(g_ledger_path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (g_ledger_fd < 0) {
+        fprintf(stderr, "Ledger: cannot open %s\n", g_ledger_path);
+        return 0;
+    }
+    struct stat sb;
+    flock(g_ledger_fd, LOCK_EX);
+    if (fstat(g_ledger_fd, &sb) == 0 && sb.st_size == 0) {
+        unsigned char hdr[32] = { 0 };
+        uint32_t version = LEDGER_VERSION, bits = UNIT_BITS;
+        memcpy(hdr, LEDGER_MAGIC, 8);
+        memcpy(hdr + 8, &version, 4);
+        memcpy(hdr + 12, &bits, 4);
+        if (write(g_ledger_fd, hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr))
+            sb.st_size = -1;
+    }
+    flock(g_ledger_fd, LOCK_UN);
+    if (fstat(g_ledger_fd, &sb) != 0 || sb.st_size < 32) {
+        fprintf(stderr, "Ledger: cannot initialize %s\n", g_ledger_path);
+        return 0;
+    }
+
+    g_ledger_map_len = sb.st_size;
+    g_ledger_map = mmap(NULL, g_ledger_map_len, PROT_READ, MAP_SHARED, g_ledger_fd, 0);
+    if (g_ledger_map == MAP_FAILED) {
+        g_ledger_map = NULL;
+        fprintf(stderr, "Ledger: cannot map %s\n", g_ledger_path);
+        return 0;
+    }
+    const unsigned char *hdr = g_ledger_map;
+    uint32_t version, bits;
+    uint64_t nsorted;
+    memcpy(&version, hdr + 8, 4);
+    memcpy(&bits, hdr + 12, 4);
+    memcpy(&nsorted, hdr + 16, 8);
+    if (memcmp(hdr, LEDGER_MAGIC, 8) != 0 || version != LEDGER_VERSION || bits != UNIT_BITS) {
+        fprintf(stderr, "Ledger: %s is not a v%d ledger of %d-bit units\n",
+                g_ledger_path, LEDGER_VERSION, UNIT_BITS);
+        return 0;
+    }
+    size_t n = (g_ledger_map_len - 32) / sizeof(ledger_run_t);
+    const ledger_run_t *runs = (const ledger_run_t *)(hdr + 32);
+    g_ledger_nsorted = nsorted < n ? nsorted : n;
+    g_ledger_sorted = runs;
+
+    size_t ntail = n - g_ledger_nsorted;
+    if (ntail) {
+        g_ledger_tail = malloc(ntail * sizeof(ledger_run_t));
+        if (!g_ledger_tail) {
+            fprintf(stderr, "Ledger: out of memory\n");
+            return 0;
+        }
+        memcpy(g_ledger_tail, runs + g_ledger_nsorted, ntail * sizeof(ledger_run_t));
+        qsort(g_ledger_tail, ntail, sizeof(ledger_run_t), ledger_run_cmp);
+        size_t m = 0;
+        for (size_t i = 0; i < ntail; i++) {
+            ledger_run_t r = g_ledger_tail[i];
+            if (r.end <= r.first) continue;
+            if (m && r.first <= g_ledger_tail[m - 1].end) {
+                if (r.end > g_ledger_tail[m - 1].end) g_ledger_tail[m - 1].end = r.end;
+            } else {
+                g_ledger_tail[m++] = r;
+            }
+        }
+        g_ledger_ntail = m;
+    }
+    return 1;
+}
+
+static void ledger_close(void) {
+    if (g_ledger_map) munmap(g_ledger_map, g_ledger_map_len);
+    if (g_ledger_fd >= 0) close(g_ledger_fd);
+    free(g_ledger_tail);
+    g_ledger_map = NULL;
+    g_ledger_fd = -1;
+    g_ledger_tail = NULL;
+}
+
+static int ledger_search(const ledger_run_t *runs, size_t n, uint64_t unit) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (runs[mid].end <= unit) lo = mid + 1;
+        else if (runs[mid].first > unit) hi = mid;
+        else return 1;
+    }
+    return 0;
+}
+
+/* Was the unit covered when the ledger was opened?  Read-only, no lock. */
+static int ledger_covered(uint64_t unit) {
+    if (!g_ledger_path) return 0;
+    return ledger_search(g_ledger_sorted, g_ledger_nsorted, unit) ||
+           ledger_search(g_ledger_tail, g_ledger_ntail, unit);
+}
+
+/* Append units [first, end).  One write on an O_APPEND descriptor under a
+ * shared lock; if a compaction has renamed a new file over the path, the
+ * append goes to that one (the mapping keeps serving lookups). */
+static void ledger_add(uint64_t first, uint64_t end) {
+    if (!g_ledger_path || end <= first) return;
+    ledger_run_t rec = { first, end > NUM_UNITS ? NUM_UNITS : end };
+    int cancel_state;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancel_state);
+    pthread_mutex_lock(&g_ledger_lock);
+    struct stat path_sb, fd_sb;
+    if (stat(g_ledger_path, &path_sb) == 0 && fstat(g_ledger_fd, &fd_sb) == 0 &&
+        path_sb.st_ino != fd_sb.st_ino) {
+        int fd = open(g_ledger_path, O_WRONLY | O_APPEND);
+        if (fd >= 0) {
+            close(g_ledger_fd);
+            g_ledger_fd = fd;
+        }
+    }
+    flock(g_ledger_fd, LOCK_SH);
+    if (write(g_ledger_fd, &rec, sizeof(rec)) != (ssize_t)sizeof(rec))
+        fprintf(stderr, "Ledger: failed to record units %llu..%llu\n",
+                (unsigned long long)rec.first, (unsigned long long)rec.end);
+    flock(g_ledger_fd, LOCK_UN);
+    pthread_mutex_unlock(&g_ledger_lock);
+    pthread_setcancelstate(cancel_state, NULL);
+}
+
+/* Units covered: merge the sorted prefix and the tail so overlaps count once */
+static uint64_t ledger_units(void) {
+    uint64_t n = 0, first = 0, end = 0;
+    size_t i = 0, j = 0;
+    while (i < g_ledger_nsorted || j < g_ledger_ntail) {
+        ledger_run_t r;
+        if (j == g_ledger_ntail ||
+            (i < g_ledger_nsorted && g_ledger_sorted[i].first <= g_ledger_tail[j].first))
+            r = g_ledger_sorted[i++];
+        else
+            r = g_ledger_tail[j++];
+        if (r.end <= r.first) continue;
+        if (r.first > end) {
+            n += end - first;
+            first = r.first;
+            end = r.end;
+        } else if (r.end > end) {
+            end = r.end;
+        }
+    }
+    return n + (end - first);
+}
+
+/* ======================== Work Units ======================== */
+
+/*
+ * Bijection on [0, NUM_UNITS): claim order seq -> unit index.  Each step
+ * (xor, odd multiply mod 2^48, xorshift) is invertible, so distinct
+ * sequence numbers always give distinct units.  Seed 0 scans in order.
+ */
+static uint64_t unit_permute(uint64_t seq, uint64_t seed) {
+    const uint64_t mask = NUM_UNITS - 1;
+    uint64_t x = seq;
+    if (seed == 0) return x;
+    for (int r = 0; r < 3; r++) {
+        x ^= (seed >> (r * 16)) & mask;
+        x = (x * 0x9E3779B97F4A7C15ULL) & mask;
+        x ^= x >> 23;
+        x = (x * (0xBF58476D1CE4E5B9ULL ^ (seed & 0xFFFF0))) & mask;   /* odd */
+        x ^= x >> 17;
+    }
+    return x;
+}
+
+static void unit_start(uint64_t unit, uint64_t *hi, uint64_t *lo) {
+    if (g_key_stride > 1) {
+        key_at((unsigned __int128)unit << UNIT_BITS, hi, lo);
+        return;
+    }
+    *hi = 0x40ULL + (unit >> (64 - UNIT_BITS));
+    *lo = unit << UNIT_BITS;
+}
+
+static uint64_t start_unit(uint64_t hi, uint64_t lo) {
+    return ((hi - 0x40ULL) << (64 - UNIT_BITS)) | (lo >> UNIT_BITS);
+}
+
+/* Random start: anywhere without a ledger, else the first key of a random
+ * unit the ledger does not cover yet */
+static void next_random_start(xorshift64_t *rng, uint64_t *hi, uint64_t *lo) {
+    if (g_key_stride > 1) {
+        /* A random key of the progression (j < 2^70 / N, so this is uniform
+         * to within 2^-58) */
+        unsigned __int128 r = (unsigned __int128)xorshift64_next(rng) << 64 | xorshift64_next(rng);
+        unsigned __int128 count = (((unsigned __int128)1 << 70) - g_key_residue + g_key_stride - 1) / g_key_stride;
+        key_at(r % count, hi, lo);
+        return;
+    }
+    if (!g_ledger_path) {
+        random_start(rng, hi, lo);
+        return;
+    }
+    uint64_t unit = 0;
+    for (int i = 0; i < LEDGER_DRAWS; i++) {
+        unit = xorshift64_next(rng) & (NUM_UNITS - 1);
+        if (!ledger_covered(unit)) break;
+        atomic_fetch_add(&g_ledger_skipped, 1);
+    }
+    unit_start(unit, hi, lo);
+}
+
+/* Local watermark bookkeeping for a finished sequence number */
+static void unit_mark_done(uint64_t seq) {
+    pthread_mutex_lock(&g_unit_lock);
+    atomic_store(&g_unit_done[seq % UNIT_WINDOW], 1);
+    uint64_t w = atomic_load(&g_unit_done_below);
+    while (atomic_load(&g_unit_done[w % UNIT_WINDOW])) {
+        atomic_store(&g_unit_done[w % UNIT_WINDOW], 0);
+        w++;
+    }
+    atomic_store(&g_unit_done_below, w);
+    pthread_mutex_unlock(&g_unit_lock);
+}
+
+/* Claim the next unit; returns 0 once the keyspace is exhausted or the scan
+ * is stopping.  Locally this is lock-free except for waiting on a lagging
+ * watermark; with a coordinator it comes from the current lease. */
+static int claim_unit(uint64_t *lease, uint64_t *seq, uint64_t *hi, uint64_t *lo) {
+    if (g_coord_addr) {
+        for (;;) {
+            if (!coord_claim(lease, seq)) return 0;
+            uint64_t unit = unit_permute(*seq, g_unit_seed);
+            /* Scanned elsewhere (GPU run, another scheduler): done already */
+            if (ledger_covered(unit)) {
+                atomic_fetch_add(&g_ledger_skipped, 1);
+                coord_done(*lease, *seq);
+                continue;
+            }
+            unit_start(unit, hi, lo);
+            return 1;
+        }
+    }
+    *lease = 0;
+    for (;;) {
+        uint64_t s = atomic_fetch_add(&g_unit_next, 1);
+        if (s >= NUM_UNITS) {
+            atomic_store(&g_units_exhausted, 1);
+            return 0;
+        }
+        while (s >= atomic_load(&g_unit_done_below) + UNIT_WINDOW) {
+            if (atomic_load(&g_found)) return 0;
+            usleep(1000);
+        }
+        /* Already completed before the last restart */
+        if (s < atomic_load(&g_unit_done_below) || atomic_load(&g_unit_done[s % UNIT_WINDOW]))
+            continue;
+        uint64_t unit = unit_permute(s, g_unit_seed);
+        /* Past the end of a strided progression: nothing to scan */
+        if (unit >= g_stride_units) {
+            unit_mark_done(s);
+            continue;
+        }
+        if (ledger_covered(unit)) {
+            atomic_fetch_add(&g_ledger_skipped, 1);
+            unit_mark_done(s);
+            continue;
+        }
+        *seq = s;
+        unit_start(unit, hi, lo);
+        return 1;
+    }
+}
+
+static void complete_unit(uint64_t lease, uint64_t seq) {
+    uint64_t unit = unit_permute(seq, g_unit_seed);
+    ledger_add(unit, unit + 1);
+    if (g_coord_addr) {
+        coord_done(lease, seq);
+        return;
+    }
+    unit_mark_done(seq);
+}
+
+#define RANGE_PACK(job, end, next) ((uint64_t)((job) + 1) << 48 | (uint64_t)(end) << 24 | (next))
+#define RANGE_JOB(r)   ((int)((r) >> 48) - 1)
+#define RANGE_END(r)   ((unsigned)((r) >> 24) & 0xFFFFFF)
+#define RANGE_NEXT(r)  ((unsigned)(r) & 0xFFFFFF)
+
+/* Start the claimed unit seq as a job held whole by slot: take its resume
+ * entry, if the saved geometry matches this run's, and publish the range.
+ * Returns the job, or -1 if the resume entry says it is all scanned. */
+static int job_begin(steal_slot_t *slot, uint64_t lease, uint64_t seq, uint64_t hi, uint64_t lo) {
+    const unsigned total = NUM_BATCHES / g_chains;
+    unsigned first = 0;
+    int j = 0;
+    pthread_mutex_lock(&g_unit_lock);
+    for (int i = 0; i < g_unit_nresume; i++) {
+        if (g_unit_resume[i].seq != seq) continue;
+        const unit_resume_t *r = &g_unit_resume[i];
+        if (r->chains == (unsigned)g_chains && r->keys % BATCH_SIZE == 0 &&
+            r->keys / BATCH_SIZE <= total)
+            first = (unsigned)(r->keys / BATCH_SIZE);
+        g_unit_resume[i] = g_unit_resume[--g_unit_nresume];
+        break;
+    }
+    if (first < total) {
+        /* At most NUM_THREADS jobs have a range held, and a job with none
+         * left is dropped, so one is always free */
+        while (g_jobs[j].busy) j++;
+        unit_job_t *job = &g_jobs[j];
+        job->seq = seq;
+        job->lease = lease;
+        job->hi = hi;
+        job->lo = lo;
+        job->busy = 1;
+        atomic_store(&job->left, total - first);
+        atomic_store(&job->front, first);
+        slot->taken = 0;
+        atomic_store_explicit(&slot->range, RANGE_PACK(j, total, first), memory_order_release);
+    }
+    pthread_mutex_unlock(&g_unit_lock);
+    if (first < total) return j;
+    complete_unit(lease, seq);
+    return -1;
+}
+
+/* Split the back half off the largest range another worker holds into
+ * slot.  Returns the job, -1 if no range is worth splitting. */
+static int job_steal(int tid, steal_slot_t *slot, unsigned *first) {
+    for (int attempt = 0; attempt < 4; attempt++) {
+        int victim = -1;
+        unsigned best = STEAL_MIN_BATCHES - 1;
+        uint64_t r = 0;
+        for (int i = 0; i < NUM_THREADS; i++) {
+            uint64_t ri = atomic_load_explicit(&g_slots[i].range, memory_order_acquire);
+            if (i == tid || !ri || RANGE_END(ri) - RANGE_NEXT(ri) <= best) continue;
+            best = RANGE_END(ri) - RANGE_NEXT(ri);
+            victim = i;
+            r = ri;
+        }
+        if (victim < 0) return -1;
+        unsigned mid = RANGE_NEXT(r) + best / 2;
+        if (!atomic_compare_exchange_strong(&g_slots[victim].range, &r,
+                                            RANGE_PACK(RANGE_JOB(r), mid, RANGE_NEXT(r))))
+            continue;
+        slot->taken = 0;
+        atomic_store_explicit(&slot->range, RANGE_PACK(RANGE_JOB(r), RANGE_END(r), mid),
+                              memory_order_release);
+        atomic_fetch_add_explicit(&g_steals, 1, memory_order_relaxed);
+        *first = mid;
+        return RANGE_JOB(r);
+    }
+    return -1;
+}
+
+/* Next batch of the slot's range for its holder; 0 once a thief has taken
+ * the rest */
+static inline int job_take(steal_slot_t *slot, unsigned batch) {
+    uint64_t r = atomic_load_explicit(&slot->range, memory_order_relaxed);
+    while (RANGE_NEXT(r) == batch && batch < RANGE_END(r)) {
+        if (atomic_compare_exchange_weak_explicit(&slot->range, &r, r + 1, memory_order_acq_rel,
+                                                  memory_order_relaxed)) {
+            slot->taken++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Batch `batch` of the job is scanned: move the front over it if every
+ * batch before it is.  Only the range holding the front can match. */
+static inline void job_scanned(steal_slot_t *slot, unsigned batch) {
+    unit_job_t *job = &g_jobs[RANGE_JOB(atomic_load_explicit(&slot->range, memory_order_relaxed))];
+    if (atomic_load_explicit(&job->front, memory_order_relaxed) == batch)
+        atomic_store_explicit(&job->front, batch + 1, memory_order_release);
+}
+
+/* The slot's range is scanned to its (possibly stolen-down) end; the last
+ * range of a job completes the unit */
+static void job_range_done(steal_slot_t *slot, int j) {
+    unit_job_t *job = &g_jobs[j];
+    unsigned taken = slot->taken;
+    atomic_store_explicit(&slot->range, 0, memory_order_release);
+    if (atomic_fetch_sub(&job->left, taken) != taken) return;
+    complete_unit(job->lease, job->seq);
+    pthread_mutex_lock(&g_unit_lock);
+    job->busy = 0;
+    pthread_mutex_unlock(&g_unit_lock);
+}
+
+/* Append a "partial" record unless seq is finished (g_unit_lock held) */
+static int write_partial(FILE *f, uint64_t w, uint64_t seq, uint64_t keys, unsigned chains) {
+    if (seq < w || seq >= w + UNIT_WINDOW || atomic_load(&g_unit_done[seq % UNIT_WINDOW]) || !keys)
+        return 0;
+    fprintf(f, "partial %llu %llu %u\n", (unsigned long long)seq, (unsigned long long)keys, chains);
+    return 1;
+}
+
+/* Write the checkpoint atomically (temp file + rename, both fsynced) and
+ * return its partial-unit count.  Runs in the stats thread and on a drain,
+ * so cancellation is held off while the locks are taken. */
+static int write_checkpoint(void) {
+    char tmp[4096];
+    int cancel_state, partial = 0;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancel_state);
+    pthread_mutex_lock(&g_checkpoint_lock);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", g_checkpoint_path);
+    FILE *f = fopen(tmp, "w");
+    if (!f) {
+        fprintf(stderr, "Checkpoint: cannot write %s\n", tmp);
+        pthread_mutex_unlock(&g_checkpoint_lock);
+        pthread_setcancelstate(cancel_state, NULL);
+        return 0;
+    }
+    pthread_mutex_lock(&g_unit_lock);
+    uint64_t w = atomic_load(&g_unit_done_below);
+    fprintf(f, "# c_scanner work units: unit u = keys 0x40<<64 + u*2^%d, claimed in\n", UNIT_BITS);
+    fprintf(f, "# sequence order seq -> unit_permute(seq, seed); \"partial seq keys chains\":\n");
+    fprintf(f, "# chain c of `chains` has scanned `keys` keys from key c*2^%d/chains of the unit\n", UNIT_BITS);
+    fprintf(f, "unit_bits %d\n", UNIT_BITS);
+    fprintf(f, "seed 0x%016llx\n", (unsigned long long)g_unit_seed);
+    if (g_key_stride > 1)
+        fprintf(f, "stride %llu/%llu\n", (unsigned long long)g_key_residue,
+                (unsigned long long)g_key_stride);
+    fprintf(f, "done_below %llu\n", (unsigned long long)w);
+    for (uint64_t s = w; s < w + UNIT_WINDOW; s++) {
+        if (atomic_load(&g_unit_done[s % UNIT_WINDOW]))
+            fprintf(f, "done %llu\n", (unsigned long long)s);
+    }
+    for (int i = 0; i < g_unit_nresume; i++)
+        partial += write_partial(f, w, g_unit_resume[i].seq, g_unit_resume[i].keys, g_unit_resume[i].chains);
+    for (int j = 0; g_jobs && j < g_njobs; j++) {
+        if (g_jobs[j].busy)
+            partial += write_partial(f, w, g_jobs[j].seq,
+                                     (uint64_t)atomic_load_explicit(&g_jobs[j].front, memory_order_acquire) *
+                                     BATCH_SIZE, g_chains);
+    }
+    pthread_mutex_unlock(&g_unit_lock);
+    int ok = (fflush(f) == 0) && (fsync(fileno(f)) == 0);
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp, g_checkpoint_path) != 0) {
+        fprintf(stderr, "Checkpoint: failed to save %s\n", g_checkpoint_path);
+    } else {
+        /* The rename itself survives the box going away only once the
+         * directory is synced */
+        char dir[4096];
+        snprintf(dir, sizeof(dir), "%s", g_checkpoint_path);
+        char *slash = strrchr(dir, '/');
+        if (slash) *(slash == dir ? slash + 1 : slash) = '\0';
+        int dfd = open(slash ? dir : ".", O_RDONLY | O_DIRECTORY);
+        if (dfd >= 0) {
+            fsync(dfd);
+            close(dfd);
+        }
+    }
+    pthread_mutex_unlock(&g_checkpoint_lock);
+    pthread_setcancelstate(cancel_state, NULL);
+    return partial;
+}
+
+/* Load a checkpoint if one exists; returns 0 on a malformed file */
+static int load_checkpoint(int seed_given, uint64_t residue, uint64_t stride) {
+    FILE *f = fopen(g_checkpoint_path, "r");
+    if (!f) return 1;
+    char line[256], key[32], val[32];
+    unsigned long long v, saved_residue = 0, saved_stride = 1;
+    int ok = 1;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        if (sscanf(line, "%31s %31s", key, val) != 2) { ok = 0; break; }
+        v = strtoull(val, NULL, 0);
+        if (strcmp(key, "unit_bits") == 0) {
+            if (v != UNIT_BITS) {
+                fprintf(stderr, "Checkpoint: unit_bits %llu, this build uses %d\n", v, UNIT_BITS);
+                ok = 0;
+                break;
+            }
+        } else if (strcmp(key, "seed") == 0) {
+            if (seed_given && v != g_unit_seed)
+                fprintf(stderr, "Checkpoint: keeping saved seed 0x%llx, ignoring --seed\n", v);
+            g_unit_seed = v;
+        } else if (strcmp(key, "stride") == 0) {
+            if (sscanf(val, "%llu/%llu", &saved_residue, &saved_stride) != 2) { ok = 0; break; }
+        } else if (strcmp(key, "done_below") == 0) {
+            atomic_store(&g_unit_done_below, v);
+            atomic_store(&g_unit_next, v);
+        } else if (strcmp(key, "done") == 0) {
+            uint64_t w = atomic_load(&g_unit_done_below);
+            if (v < w || v >= w + UNIT_WINDOW) { ok = 0; break; }
+            atomic_store(&g_unit_done[v % UNIT_WINDOW], 1);
+        } else if (strcmp(key, "partial") == 0) {
+            unsigned long long keys;
+            unsigned chains;
+            uint64_t w = atomic_load(&g_unit_done_below);
+            if (sscanf(line, "partial %llu %llu %u", &v, &keys, &chains) != 3 || v < w ||
+                v >= w + UNIT_WINDOW || !chains || g_unit_nresume == UNIT_WINDOW) { ok = 0; break; }
+            g_unit_resume[g_unit_nresume++] = (unit_resume_t){ v, keys, chains };
+        } else {
+            ok = 0;
+            break;
+        }
+    }
+    fclose(f);
+    if (!ok) fprintf(stderr, "Checkpoint: malformed %s\n", g_checkpoint_path);
+    if (ok && (saved_residue != residue || saved_stride != stride)) {
+        fprintf(stderr, "Checkpoint: %s is for --stride=%llu/%llu, not %llu/%llu\n", g_checkpoint_path,
+                saved_residue, saved_stride, (unsigned long long)residue, (unsigned long long)stride);
+        ok = 0;
+    }
+    return ok;
+}
+
+/* ======================== CPU Topology & Arenas ======================== */
+
+/* Allowed CPUs (sched_getaffinity), from /sys topology, in pinning order:
+ * --pin=core lists SMT rank 0 of every physical core first, then the
+ * siblings; --pin=smt keeps the siblings of each core next to each other */
+static int read_sys_int(const char *fmt, int cpu) {
+    char path[128];
+    int v = -1;
+    snprintf(path, sizeof(path), fmt, cpu);
+    FILE *f = fopen(path, "r");
+    if (f) {
+        if (fscanf(f, "%d", &v) != 1) v = -1;
+        fclose(f);
+    }
+    return v;
+}
+
+/* NUMA node of a CPU: the nodeN link in its sysfs directory */
+static int cpu_node(int cpu) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *d = opendir(path);
+    if (!d) return 0;
+    int node = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (strncmp(e->d_name, "node", 4) == 0 && isdigit((unsigned char)e->d_name[4])) {
+            node = atoi(e->d_name + 4);
+            break;
+        }
+    }
+    closedir(d);
+    return node < MAX_NODES ? node : 0;
+}
+
+static int cpu_order_cmp(const void *a, const void *b) {
+    const cpu_info_t *x = a, *y = b;
+    if (g_pin_mode == PIN_CORE && x->smt != y->smt) return x->smt - y->smt;
+    if (x->pkg != y->pkg) return x->pkg - y->pkg;
+    if (x->core != y->core) return x->core - y->core;
+    if (x->smt != y->smt) return x->smt - y->smt;
+    return x->cpu - y->cpu;
+}
+
+static void detect_topology(void) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return;
+    g_num_cpus = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && cpu < MAX_CPUS; cpu++) {
+        if (!CPU_ISSET(cpu, &set)) continue;
+        cpu_info_t *c = &g_cpus[g_num_cpus++];
+        c->cpu = cpu;
+        c->core = read_sys_int("/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        c->pkg = read_sys_int("/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        if (c->core < 0) c->core = cpu;
+        if (c->pkg < 0) c->pkg = 0;
+        c->node = cpu_node(cpu);
+    }
+    /* SMT rank: position among the CPUs sharing one physical core */
+    for (int i = 0; i < g_num_cpus; i++) {
+        g_cpus[i].smt = 0;
+        for (int j = 0; j < i; j++)
+            if (g_cpus[j].pkg == g_cpus[i].pkg && g_cpus[j].core == g_cpus[i].core)
+                g_cpus[i].smt++;
+    }
+    qsort(g_cpus, g_num_cpus, sizeof(cpu_info_t), cpu_order_cmp);
+}
+
+/* Pin the calling worker to its CPU; returns that CPU's NUMA node or -1.
+ * GPU feeders (tid >= NUM_THREADS) take the first g_cpu_reserved CPUs in
+ * pinning order, CPU workers the ones after them. */
+static int pin_worker(int tid) {
+    if (g_pin_mode == PIN_NONE || g_num_cpus == 0) return -1;
+    int idx = tid % g_num_cpus;
+    if (g_cpu_reserved && tid >= NUM_THREADS)
+        idx = (tid - NUM_THREADS) % g_cpu_reserved;
+    else if (g_cpu_reserved && g_cpu_reserved < g_num_cpus)
+        idx = g_cpu_reserved + tid % (g_num_cpus - g_cpu_reserved);
+    const cpu_info_t *c = &g_cpus[idx];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(c->cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) return -1;
+    return c->node;
+}
+
+/*
+ * Zeroed, 2MB-aligned block for one thread's hot data: MAP_HUGETLB pages
+ * when the kernel has huge pages reserved, else 4K pages advised for THP.
+ * The block is touched here, so on a pinned thread its pages come from the
+ * thread's own NUMA node (first-touch placement, no libnuma needed).
+ */
+static void *arena_alloc(size_t size, size_t *mapped) {
+    size_t len = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        atomic_store(&g_arena_hugetlb, 1);
+    } else {
+        /* Over-map and trim so the block starts on a 2MB boundary */
+        char *raw = mmap(NULL, len + ARENA_ALIGN, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) return NULL;
+        char *a = (char *)(((uintptr_t)raw + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1));
+        if (a > raw) munmap(raw, a - raw);
+        munmap(a + len, raw + ARENA_ALIGN - a);
+        p = a;
+#ifdef MADV_HUGEPAGE
+        madvise(p, len, MADV_HUGEPAGE);
+#endif
+    }
+    memset(p, 0, len);
+    *mapped = len;
+    return p;
+}
+
+static void arena_free(void *p, size_t len) {
+    if (p) munmap(p, len);
+}
+
+/* The step table replica on a NUMA node, copied by the node's first worker */
+static const secp256k1_ge *node_step_table(int node) {
+    pthread_mutex_lock(&g_node_lock);
+    if (!g_node_step_table[node]) {
+        size_t len, size = sizeof(secp256k1_ge) * g_step_table_size;
+        secp256k1_ge *t = arena_alloc(size, &len);
+        if (t) {
+            memcpy(t, g_step_table, size);
+            g_node_step_table[node] = t;
+            g_node_step_len[node] = len;
+        }
+    }
+    const secp256k1_ge *t = g_node_step_table[node];
+    pthread_mutex_unlock(&g_node_lock);
+    return t;
+}
+
+/* ======================== Point Table Cache ======================== */
+
+/*
+ * Every precomputed table here is the same shape: (i+1) * step * G for
+ * i < n, in affine form.  ptable_get maps it from TABLE_CACHE_DIR when a
+ * valid file is there, else builds it (one batch inversion) and stores it
+ * for the next start.  Files are mapped read-only and shared, so processes
+ * on one host share the pages.  A file is used only if its header, payload
+ * checksum and both end points (recomputed with ecmult_gen) all match;
+ * anything else is rebuilt and replaced.  Layout: a ptable_hdr_t, then n
+ * secp256k1_ge in this build's representation (elem_size in the header).
+ */
+typedef struct {
+    char     magic[8];
+    uint32_t version, elem_size;
+    uint64_t step, count, checksum;
+    uint8_t  reserved[24];
+} ptable_hdr_t;
+_Static_assert(sizeof(ptable_hdr_t) == 64, "ptable_hdr_t is one cache line");
+
+static uint64_t ptable_checksum(const secp256k1_ge *t, size_t n) {
+    const uint64_t *w = (const uint64_t *)t;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < n * sizeof(secp256k1_ge) / 8; i++)
+        h = (h ^ w[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+/* t[i] == (i+1) * step * G, checked the slow way */
+static int ptable_point_ok(const secp256k1_ge *t, uint64_t step, size_t i) {
+    unsigned __int128 k = (unsigned __int128)step * (i + 1);
+    secp256k1_scalar s;
+    secp256k1_gej pj;
+    secp256k1_ge want, got = t[i];
+    unsigned char a[33], b[33];
+    make_scalar(&s, (uint64_t)(k >> 64), (uint64_t)k);
+    secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &pj, &s);
+    secp256k1_ge_set_gej_var(&want, &pj);
+    if (got.infinity) return 0;
+    secp256k1_eckey_pubkey_serialize33(&want, a);
+    secp256k1_eckey_pubkey_serialize33(&got, b);
+    return memcmp(a, b, 33) == 0;
+}
+
+static void ptable_path(char *path, size_t cap, uint64_t step, int n) {
+    snprintf(path, cap, "%s/mult_%016llx_%d.tbl", g_table_dir, (unsigned long long)step, n);
+}
+
+/* Map a cache file; NULL if it is missing or does not check out */
+static const secp256k1_ge *ptable_map(const char *path, uint64_t step, int n, size_t *len) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat sb;
+    size_t want = sizeof(ptable_hdr_t) + sizeof(secp256k1_ge) * (size_t)n;
+    if (fstat(fd, &sb) != 0 || (size_t)sb.st_size != want) {
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, want, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+    madvise(p, want, MADV_HUGEPAGE);
+#endif
+    const ptable_hdr_t *h = p;
+    const secp256k1_ge *t = (const secp256k1_ge *)(h + 1);
+    if (memcmp(h->magic, PTABLE_MAGIC, 8) != 0 || h->version != PTABLE_VERSION ||
+        h->elem_size != sizeof(secp256k1_ge) || h->step != step || h->count != (uint64_t)n ||
+        h->checksum != ptable_checksum(t, n) ||
+        !ptable_point_ok(t, step, 0) || !ptable_point_ok(t, step, n - 1)) {
+        munmap(p, want);
+        return NULL;
+    }
+    *len = want;
+    return t;
+}
+
+static void ptable_release(const secp256k1_ge *t, size_t len) {
+    if (t) munmap((ptable_hdr_t *)t - 1, len);
+}
+
+/* Build the table behind a header in an arena block */
+static const secp256k1_ge *ptable_build(uint64_t step, int n, size_t *len) {
+    size_t size = sizeof(ptable_hdr_t) + sizeof(secp256k1_ge) * (size_t)n;
+    ptable_hdr_t *h = arena_alloc(size, len);
+    secp256k1_gej *tmp = malloc(sizeof(secp256k1_gej) * n);
+    if (!h || !tmp) {
+        if (h) arena_free(h, *len);
+        free(tmp);
+        return NULL;
+    }
+    secp256k1_ge *t = (secp256k1_ge *)(h + 1);
+    secp256k1_scalar sc;
+    secp256k1_ge d;
+    make_scalar(&sc, 0, step);
+    secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &tmp[0], &sc);
+    secp256k1_ge_set_gej_var(&d, &tmp[0]);
+    for (int i = 1; i < n; i++)
+        secp256k1_gej_add_ge_var(&tmp[i], &tmp[i-1], &d, NULL);
+    secp256k1_ge_set_all_gej_var(t, tmp, n);
+    free(tmp);
+    memcpy(h->magic, PTABLE_MAGIC, 8);
+    h->version = PTABLE_VERSION;
+    h->elem_size = sizeof(secp256k1_ge);
+    h->step = step;
+    h->count = (uint64_t)n;
+    h->checksum = ptable_checksum(t, n);
+    return t;
+}
+
+/* Write a built table to its cache file (temp file + rename, so a reader
+ * never maps half a table).  Returns 0 if the cache cannot be written. */
+static int ptable_store(const char *path, const secp256k1_ge *t, int n) {
+    size_t len = sizeof(ptable_hdr_t) + sizeof(secp256k1_ge) * (size_t)n;
+    char tmp[PATH_MAX];
+    /* Too long for a temp name: skip the cache write, the table still serves */
+    if (snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid()) >= (int)sizeof(tmp))
+        return 0;
+    mkdir(g_table_dir, 0755);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return 0;
+    const char *p = (const char *)((const ptable_hdr_t *)t - 1);
+    size_t off = 0;
+    while (off < len) {
+        ssize_t w = write(fd, p + off, len - off);
+        if (w <= 0) break;
+        off += (size_t)w;
+    }
+    int ok = off == len && close(fd) == 0;
+    if (off != len) close(fd);
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return 0;
+    }
+    return 1;
+}
+
+/* (i+1) * step * G for i < n; release with ptable_release(t, *len) */
+static const secp256k1_ge *ptable_get(uint64_t step, int n, size_t *len) {
+    double t0 = get_time_sec();
+    char path[PATH_MAX];
+    const secp256k1_ge *t = NULL;
+    if (g_table_dir) {
+        ptable_path(path, sizeof(path), step, n);
+        t = ptable_map(path, step, n, len);
+    }
+    if (t) {
+        g_tables_mapped++;
+    } else {
+        t = ptable_build(step, n, len);
+        if (!t) return NULL;
+        g_tables_built++;
+        /* Serve the stored copy, so this process shares it with the next */
+        size_t flen;
+        const secp256k1_ge *f;
+        if (g_table_dir && ptable_store(path, t, n) && (f = ptable_map(path, step, n, &flen))) {
+            ptable_release(t, *len);
+            t = f;
+            *len = flen;
+        }
+    }
+    g_tables_secs += get_time_sec() - t0;
+    return t;
+}
+
+/* ======================== Affine Stepping Engine ======================== */
+
+/*
+ * Fill aff[0..BATCH_SIZE-1] with P, P+G, ..., P+(BATCH_SIZE-1)G and advance
+ * *p to P+BATCH_SIZE*G.  Each point is P + g_step_table[i] in affine form:
+ *
+ *   lambda = (y_i - y_P) / (x_i - x_P)
+ *   x      = lambda^2 - x_P - x_i
+ *   y      = lambda * (x_P - x) - y_P
+ *
+ * The BATCH_SIZE denominators (the last one advances P) are inverted together
+ * with Montgomery's trick: 1 inversion + 3(N-1) multiplications.  prod is
+ * caller-provided scratch of BATCH_SIZE field elements.  *p needs magnitude-1
+ * coordinates and no table point may share its x coordinate (never happens
+ * for keys in the puzzle range, which are far from +-iG).
+ */
+static SCANNER_ALWAYS_INLINE void affine_batch_impl(secp256k1_ge *aff, secp256k1_ge *p, secp256k1_fe *prod) {
+    const secp256k1_ge start = *p;
+    const secp256k1_ge *step = step_table();
+    secp256k1_fe neg_x, neg_y, dx, inv, inv_i, lambda, t;
+
+    secp256k1_fe_negate(&neg_x, &start.x, 1);
+    secp256k1_fe_negate(&neg_y, &start.y, 1);
+
+    /* Forward pass: prod[i] = product of (x_j - x_P) for j <= i */
+    prod[0] = step[0].x;
+    secp256k1_fe_add(&prod[0], &neg_x);
+    for (int i = 1; i < BATCH_SIZE; i++) {
+        dx = step[i].x;
+        secp256k1_fe_add(&dx, &neg_x);
+        secp256k1_fe_mul(&prod[i], &prod[i-1], &dx);
+    }
+
+    secp256k1_fe_inv_var(&inv, &prod[BATCH_SIZE-1]);
+
+    /* Backward pass: peel off one inverse per step and finish that point */
+    for (int i = BATCH_SIZE - 1; i >= 0; i--) {
+        const secp256k1_ge *q = &step[i];
+        if (i > 0) {
+            dx = q->x;
+            secp256k1_fe_add(&dx, &neg_x);
+            secp256k1_fe_mul(&inv_i, &inv, &prod[i-1]);
+            secp256k1_fe_mul(&inv, &inv, &dx);
+        } else {
+            inv_i = inv;
+        }
+
+        /* The last table entry (BATCH_SIZE*G) yields the next start point */
+        secp256k1_ge *r = (i == BATCH_SIZE - 1) ? p : &aff[i+1];
+
+        t = q->y;
+        secp256k1_fe_add(&t, &neg_y);
+        secp256k1_fe_mul(&lambda, &t, &inv_i);
+
+        secp256k1_fe_sqr(&r->x, &lambda);
+        secp256k1_fe_add(&r->x, &neg_x);
+        secp256k1_fe_negate(&t, &q->x, 1);
+        secp256k1_fe_add(&r->x, &t);
+        secp256k1_fe_normalize_weak(&r->x);
+
+        secp256k1_fe_negate(&t, &r->x, 1);
+        secp256k1_fe_add(&t, &start.x);
+        secp256k1_fe_mul(&r->y, &lambda, &t);
+        secp256k1_fe_add(&r->y, &neg_y);
+        secp256k1_fe_normalize_weak(&r->y);
+        r->infinity = 0;
+    }
+
+    aff[0] = start;
+    secp256k1_fe_normalize_var(&p->x);
+    secp256k1_fe_normalize_var(&p->y);
+}
+
+/*
+ * Center-out variant of affine_batch.  *c is the midpoint C = S + HALF*G of
+ * the window starting at S (HALF = BATCH_SIZE/2).  C + iG and C - iG share
+ * the denominator (x_iG - x_C), so one inverse finishes two points:
+ *
+ *   aff[HALF + i] = C + iG    (i = 0..HALF-1)
+ *   aff[HALF - i] = C - iG    (i = 1..HALF)
+ *
+ * which keeps aff[j] = S + jG, so match offsets are the same as for the
+ * forward engines.  One more denominator (BATCH_SIZE*G) advances *c to the
+ * next window's midpoint: HALF + 1 inversions shared, prod needs HALF + 1
+ * entries.
+ */
+#define HALF_BATCH (BATCH_SIZE / 2)
+
+static SCANNER_ALWAYS_INLINE void center_batch_impl(secp256k1_ge *aff, secp256k1_ge *c, secp256k1_fe *prod) {
+    const secp256k1_ge mid = *c;
+    const secp256k1_ge *step = step_table();
+    secp256k1_fe neg_x, neg_y, neg_qx, dx, inv, inv_i, lambda, t;
+
+    secp256k1_fe_negate(&neg_x, &mid.x, 1);
+    secp256k1_fe_negate(&neg_y, &mid.y, 1);
+
+    /* prod[j] covers g_step_table[0..j] for j < HALF, prod[HALF] adds BATCH_SIZE*G */
+    prod[0] = step[0].x;
+    secp256k1_fe_add(&prod[0], &neg_x);
+    for (int j = 1; j <= HALF_BATCH; j++) {
+        dx = step[j == HALF_BATCH ? BATCH_SIZE - 1 : j].x;
+        secp256k1_fe_add(&dx, &neg_x);
+        secp256k1_fe_mul(&prod[j], &prod[j-1], &dx);
+    }
+
+    secp256k1_fe_inv_var(&inv, &prod[HALF_BATCH]);
+
+    for (int j = HALF_BATCH; j >= 0; j--) {
+        const secp256k1_ge *q = &step[j == HALF_BATCH ? BATCH_SIZE - 1 : j];
+        if (j > 0) {
+            dx = q->x;
+            secp256k1_fe_add(&dx, &neg_x);
+            secp256k1_fe_mul(&inv_i, &inv, &prod[j-1]);
+            secp256k1_fe_mul(&inv, &inv, &dx);
+        } else {
+            inv_i = inv;
+        }
+        secp256k1_fe_negate(&neg_qx, &q->x, 1);
+
+        /* C + q: the next midpoint for j == HALF, otherwise aff[HALF + i] */
+        int i = j + 1;
+        if (j == HALF_BATCH || i < HALF_BATCH) {
+            secp256k1_ge *r = (j == HALF_BATCH) ? c : &aff[HALF_BATCH + i];
+
+            t = q->y;
+            secp256k1_fe_add(&t, &neg_y);
+            secp256k1_fe_mul(&lambda, &t, &inv_i);
+
+            secp256k1_fe_sqr(&r->x, &lambda);
+            secp256k1_fe_add(&r->x, &neg_x);
+            secp256k1_fe_add(&r->x, &neg_qx);
+            secp256k1_fe_normalize_weak(&r->x);
+
+            secp256k1_fe_negate(&t, &r->x, 1);
+            secp256k1_fe_add(&t, &mid.x);
+            secp256k1_fe_mul(&r->y, &lambda, &t);
+            secp256k1_fe_add(&r->y, &neg_y);
+            secp256k1_fe_normalize_weak(&r->y);
+            r->infinity = 0;
+        }
+
+        /* C - q: slope is -(y_q + y_C) / (x_q - x_C); with l = (y_q + y_C)
+         * times the inverse, y = l * (x - x_C) - y_C */
+        if (j < HALF_BATCH) {
+            secp256k1_ge *r = &aff[HALF_BATCH - i];
+
+            t = q->y;
+            secp256k1_fe_add(&t, &mid.y);
+            secp256k1_fe_mul(&lambda, &t, &inv_i);
+
+            secp256k1_fe_sqr(&r->x, &lambda);
+            secp256k1_fe_add(&r->x, &neg_x);
+            secp256k1_fe_add(&r->x, &neg_qx);
+            secp256k1_fe_normalize_weak(&r->x);
+
+            t = r->x;
+            secp256k1_fe_add(&t, &neg_x);
+            secp256k1_fe_mul(&r->y, &lambda, &t);
+            secp256k1_fe_add(&r->y, &neg_y);
+            secp256k1_fe_normalize_weak(&r->y);
+            r->infinity = 0;
+        }
+    }
+
+    aff[HALF_BATCH] = mid;
+    secp256k1_fe_normalize_var(&c->x);
+    secp256k1_fe_normalize_var(&c->y);
+}
+
+/* ======================== Field ISA Variants ======================== */
+
+/*
+ * The stepping engines are compiled twice: for the baseline ISA and with
+ * BMI2, where the inlined 5x52 field multiply / square use mulx.  The
+ * variant is picked at startup (g_field_bmi2), so a -march=x86-64 binary
+ * still gets the faster instruction where the CPU has it.
+ */
+static void affine_batch_generic(secp256k1_ge *aff, secp256k1_ge *p, secp256k1_fe *prod) {
+    affine_batch_impl(aff, p, prod);
+}
+static void center_batch_generic(secp256k1_ge *aff, secp256k1_ge *c, secp256k1_fe *prod) {
+    center_batch_impl(aff, c, prod);
+}
+#if FIELD_DISPATCH
+__attribute__((target("bmi2")))
+static void affine_batch_bmi2(secp256k1_ge *aff, secp256k1_ge *p, secp256k1_fe *prod) {
+    affine_batch_impl(aff, p, prod);
+}
+__attribute__((target("bmi2")))
+static void center_batch_bmi2(secp256k1_ge *aff, secp256k1_ge *c, secp256k1_fe *prod) {
+    center_batch_impl(aff, c, prod);
+}
+#endif
+
+static void affine_batch(secp256k1_ge *aff, secp256k1_ge *p, secp256k1_fe *prod) {
+#if FIELD_DISPATCH
+    if (g_field_bmi2) {
+        affine_batch_bmi2(aff, p, prod);
+        return;
+    }
+#endif
+    affine_batch_generic(aff, p, prod);
+}
+
+static void center_batch(secp256k1_ge *aff, secp256k1_ge *c, secp256k1_fe *prod) {
+#if FIELD_DISPATCH
+    if (g_field_bmi2) {
+        center_batch_bmi2(aff, c, prod);
+        return;
+    }
+#endif
+    center_batch_generic(aff, c, prod);
+}
+
+/* ======================== Hash Input Words ======================== */
+
+/*
+ * Lane `lane` of the flat hash160_xw input (lanes wide) for affine point p:
+ * the compressed prefix (0x02 / 0x03) and X as 8 big-endian words, i.e. the
+ * same bytes secp256k1_eckey_pubkey_serialize33 would write.  p is only
+ * read: Y is reduced to its parity and X normalized into the words.
+ */
+#ifdef SECP256K1_WIDEMUL_INT128
+/*
+ * Canonical limbs of a coordinate fresh from the batch engines (after
+ * normalize_weak or a field multiply, so limbs 0-3 are below 2^52).  With
+ * n[4] < 2^48 - 1 the value is below 2^256 - 2^208 < p and already
+ * canonical; only the rare top-of-range values are normalized, into tmp,
+ * so the point itself is never rewritten.
+ */
+static inline const uint64_t *fe_hash_limbs(const secp256k1_fe *a, secp256k1_fe *tmp) {
+    if (__builtin_expect(a->n[4] < 0x0FFFFFFFFFFFFULL, 1))
+        return a->n;
+    *tmp = *a;
+    secp256k1_fe_normalize_var(tmp);
+    return tmp->n;
+}
+#endif
+
+static inline void ge_hash_words(const secp256k1_ge *p, uint32_t *prefix, uint32_t *xw,
+                                 int lanes, int lane) {
+#ifdef SECP256K1_WIDEMUL_INT128
+    /* Y only contributes its parity; X is normalized straight into the words */
+    secp256k1_fe tx, ty;
+    prefix[lane] = 0x02 | (uint32_t)(fe_hash_limbs(&p->y, &ty)[0] & 1);
+
+    /* 5x52 limbs -> 4x64, most significant word first */
+    const uint64_t *n = fe_hash_limbs(&p->x, &tx);
+    uint64_t q[4];
+    q[3] = (n[3] >> 36) | (n[4] << 16);
+    q[2] = (n[2] >> 24) | (n[3] << 28);
+    q[1] = (n[1] >> 12) | (n[2] << 40);
+    q[0] =  n[0]        | (n[1] << 52);
+    for (int i = 0; i < 4; i++) {
+        xw[(2*i) * lanes + lane]     = (uint32_t)(q[3 - i] >> 32);
+        xw[(2*i + 1) * lanes + lane] = (uint32_t)q[3 - i];
+    }
+#else
+    secp256k1_fe x = p->x, y = p->y;
+    unsigned char b[32];
+    secp256k1_fe_normalize_var(&x);
+    secp256k1_fe_normalize_var(&y);
+    prefix[lane] = secp256k1_fe_is_odd(&y) ? 0x03 : 0x02;
+    secp256k1_fe_get_b32(b, &x);
+    for (int i = 0; i < 8; i++)
+        xw[i * lanes + lane] = be32(b + i * 4);
+#endif
+}
+
+/* ======================== Batch Pipeline ======================== */
+
+/* One thread's point stream: batch buffers for g_engine (jac_batch for the
+ * Jacobian engine, inv_scratch for the affine engines' batched inversion;
+ * the fused engine has no aff_batch) and the position of the next batch.
+ * The simd engine keeps its g_chains chains in simd (x and y limbs, lane c
+ * = chain c, then the prefix products), chain c starting chain_stride * c
+ * keys after the seek position.  pos_hi:pos_lo is the key chain 0's next
+ * batch starts at (once positioned). */
+#define SIMD_STATE_WORDS (2 * 5 * SIMD_CHAINS)
+typedef struct {
+    secp256k1_gej *jac_batch;
+    secp256k1_fe  *inv_scratch;
+    secp256k1_ge  *aff_batch;
+    secp256k1_gej  current_jac;
+    secp256k1_ge   current_aff;
+    uint64_t      *simd;
+    uint64_t       chain_stride;
+    uint64_t       pos_hi, pos_lo;
+    int            positioned;
+    void          *arena;
+    size_t         arena_len;
+} batch_state_t;
+
+/* All buffers share one arena, allocated by (and local to) the caller */
+static int batch_state_init(batch_state_t *st) {
+    memset(st, 0, sizeof(*st));
+    size_t aff_size = g_engine >= ENGINE_FUSED ? 0 : (sizeof(secp256k1_ge) * BATCH_SIZE + 63) & ~(size_t)63;
+    size_t aux_size = g_engine == ENGINE_JACOBIAN ? sizeof(secp256k1_gej) * BATCH_SIZE :
+                      g_engine == ENGINE_SIMD ? sizeof(uint64_t) * (SIMD_STATE_WORDS + 5 * SIMD_CHAINS * BATCH_SIZE)
+                                              : sizeof(secp256k1_fe) * BATCH_SIZE;
+    char *a = arena_alloc(aff_size + aux_size, &st->arena_len);
+    if (!a) return 0;
+    st->arena = a;
+    st->aff_batch = (secp256k1_ge *)a;
+    if (g_engine == ENGINE_JACOBIAN)
+        st->jac_batch = (secp256k1_gej *)(a + aff_size);
+    else if (g_engine == ENGINE_SIMD)
+        st->simd = (uint64_t *)(a + aff_size);
+    else
+        st->inv_scratch = (secp256k1_fe *)(a + aff_size);
+    /* Chains split one chunk (one work unit before --batches is known) */
+    uint64_t chunk = CHUNK_SIZE;
+    st->chain_stride = (chunk ? chunk : UNIT_KEYS) / g_chains;
+    return 1;
+}
+
+static void batch_state_free(batch_state_t *st) {
+    arena_free(st->arena, st->arena_len);
+}
+
+/* Every batch moves each chain BATCH_SIZE keys on */
+static inline void batch_advance(batch_state_t *st) {
+    key_step(&st->pos_hi, &st->pos_lo, BATCH_SIZE);
+}
+
+/* g_giant_table for streams whose chains are `stride` keys apart (one
+ * chain's share of a chunk, counted along the progression), one batch
+ * inversion */
+static int giant_table_init(uint64_t stride) {
+    ptable_release(g_giant_table, g_giant_len);
+    g_giant_table = ptable_get(stride * g_key_stride, GIANT_STEPS, &g_giant_len);
+    if (!g_giant_table) return 0;
+    g_giant_stride = stride;
+    return 1;
+}
+
+/* Move a positioned stream to (hi, lo) if that is 0..GIANT_STEPS giant
+ * steps ahead of it: one addition per chain (the simd chains share one
+ * inversion).  Returns 0 when the seek needs a scalar multiplication. */
+static int batch_jump(batch_state_t *st, uint64_t hi, uint64_t lo) {
+    if (!st->positioned || !g_giant_table || st->chain_stride != g_giant_stride) return 0;
+    unsigned __int128 d = ((unsigned __int128)hi << 64 | lo) -
+                          ((unsigned __int128)st->pos_hi << 64 | st->pos_lo);
+    unsigned __int128 giant = (unsigned __int128)g_giant_stride * g_key_stride;
+    if (d % giant != 0 || d / giant > GIANT_STEPS) return 0;
+    uint64_t k = (uint64_t)(d / giant);
+    if (k == 0) return 1;
+
+    const secp256k1_ge *step = &g_giant_table[k - 1];
+    if (g_engine == ENGINE_JACOBIAN) {
+        secp256k1_gej_add_ge_var(&st->current_jac, &st->current_jac, step, NULL);
+    } else if (g_engine == ENGINE_SIMD) {
+        secp256k1_gej pj[SIMD_CHAINS];
+        secp256k1_ge p[SIMD_CHAINS];
+        for (int c = 0; c < SIMD_CHAINS; c++) {
+            for (int i = 0; i < 5; i++) {
+                p[c].x.n[i] = st->simd[i * SIMD_CHAINS + c];
+                p[c].y.n[i] = st->simd[(5 + i) * SIMD_CHAINS + c];
+            }
+            p[c].infinity = 0;
+            secp256k1_gej_set_ge(&pj[c], &p[c]);
+            secp256k1_gej_add_ge_var(&pj[c], &pj[c], step, NULL);
+        }
+        secp256k1_ge_set_all_gej_var(p, pj, SIMD_CHAINS);
+        for (int c = 0; c < SIMD_CHAINS; c++) {
+            secp256k1_fe_normalize_var(&p[c].x);
+            secp256k1_fe_normalize_var(&p[c].y);
+            for (int i = 0; i < 5; i++) {
+                st->simd[i * SIMD_CHAINS + c] = p[c].x.n[i];
+                st->simd[(5 + i) * SIMD_CHAINS + c] = p[c].y.n[i];
+            }
+        }
+    } else {
+        /* current_aff is the center engine's midpoint: the same distance */
+        secp256k1_gej pj;
+        secp256k1_gej_set_ge(&pj, &st->current_aff);
+        secp256k1_gej_add_ge_var(&pj, &pj, step, NULL);
+        secp256k1_ge_set_gej_var(&st->current_aff, &pj);
+    }
+    return 1;
+}
+
+/* Position the stream so the next batch starts at private key (hi, lo) */
+static void batch_seek(batch_state_t *st, uint64_t hi, uint64_t lo) {
+    secp256k1_scalar privkey_scalar;
+    int jumped = batch_jump(st, hi, lo);
+    atomic_fetch_add_explicit(&g_seeks[jumped], 1, memory_order_relaxed);
+    st->pos_hi = hi;
+    st->pos_lo = lo;
+    st->positioned = 1;
+    if (jumped) return;
+    if (g_engine == ENGINE_SIMD) {
+        /* One start point per chain, normalized into its lane */
+        for (int c = 0; c < SIMD_CHAINS; c++) {
+            uint64_t c_hi = hi, c_lo = lo;
+            secp256k1_ge p;
+            key_step(&c_hi, &c_lo, c * st->chain_stride);
+            make_scalar(&privkey_scalar, c_hi, c_lo);
+            secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &st->current_jac, &privkey_scalar);
+            secp256k1_ge_set_gej_var(&p, &st->current_jac);
+            secp256k1_fe_normalize_var(&p.x);
+            secp256k1_fe_normalize_var(&p.y);
+            for (int k = 0; k < 5; k++) {
+                st->simd[k * SIMD_CHAINS + c] = p.x.n[k];
+                st->simd[(5 + k) * SIMD_CHAINS + c] = p.y.n[k];
+            }
+        }
+        secp256k1_scalar_clear(&privkey_scalar);
+        return;
+    }
+    if (g_engine == ENGINE_CENTER) {
+        /* Center-out batches start from the first window's midpoint */
+        uint64_t mid_hi = hi, mid_lo = lo;
+        key_step(&mid_hi, &mid_lo, HALF_BATCH);
+        make_scalar(&privkey_scalar, mid_hi, mid_lo);
+    } else {
+        make_scalar(&privkey_scalar, hi, lo);
+    }
+
+    secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &st->current_jac, &privkey_scalar);
+    secp256k1_scalar_clear(&privkey_scalar);
+
+    if (g_engine != ENGINE_JACOBIAN)
+        secp256k1_ge_set_gej_var(&st->current_aff, &st->current_jac);
+}
+
+/* Steps 1+2: aff_batch = the next BATCH_SIZE points, stream advanced */
+static void batch_next(batch_state_t *st) {
+    batch_advance(st);
+    if (g_engine == ENGINE_AFFINE) {
+        /* BATCH_SIZE affine points, advancing current_aff */
+        affine_batch(st->aff_batch, &st->current_aff, st->inv_scratch);
+    } else if (g_engine == ENGINE_CENTER) {
+        /* Same window, generated outward from its midpoint */
+        center_batch(st->aff_batch, &st->current_aff, st->inv_scratch);
+    } else {
+        /* Step 1: Generate BATCH_SIZE sequential Jacobian points (step
+         * table entry 0: G, or N*G with --stride) */
+        const secp256k1_ge *g1 = step_table();
+        st->jac_batch[0] = st->current_jac;
+        for (int i = 1; i < BATCH_SIZE; i++) {
+            secp256k1_gej_add_ge_var(&st->jac_batch[i], &st->jac_batch[i-1], g1, NULL);
+        }
+
+        /* Step 2: Batch convert Jacobian -> Affine (1 field inversion for all!) */
+        secp256k1_ge_set_all_gej_var(st->aff_batch, st->jac_batch, BATCH_SIZE);
+
+        /* Advance current_jac past this batch */
+        secp256k1_gej_add_ge_var(&st->current_jac, &st->jac_batch[BATCH_SIZE-1], g1, NULL);
+    }
+}
+
+/*
+ * Step 3: hash160 every point of aff[0..BATCH_SIZE-1], `lanes` at a time,
+ * and check it against the target set.  Returns the index of the first
+ * match (its hash160 in h160_out) or -1.  Instantiated once per hash ISA
+ * below, with lanes and the kernel as constants.
+ */
+static SCANNER_ALWAYS_INLINE int batch_check_impl(secp256k1_ge *aff, unsigned char h160_out[20], const int lanes,
+                                                  void (*xw_fn)(const uint32_t *, const uint32_t *, uint32_t *)) {
+    uint32_t prefix_lanes[HASH160_MAX_LANES];
+    uint32_t xw_lanes[8 * HASH160_MAX_LANES];
+    uint32_t h160_lanes[5 * HASH160_MAX_LANES];
+
+    for (int i = 0; i < BATCH_SIZE; i += lanes) {
+        /* Compressed pubkeys as SHA256 message words, lane-interleaved */
+        for (int l = 0; l < lanes; l++)
+            ge_hash_words(&aff[i + l], prefix_lanes, xw_lanes, lanes, l);
+
+        /* Hash160 = RIPEMD160(SHA256(pub33)), one SIMD lane per key */
+        xw_fn(prefix_lanes, xw_lanes, h160_lanes);
+
+        for (int l = 0; l < lanes; l++) {
+            /* Filter on the first hash160 word before the full lookup */
+            if (__builtin_expect(target_filter_hit(&g_targets, h160_lanes[l]), 0)) {
+                for (int w = 0; w < 5; w++)
+                    put_le32(h160_out + w * 4, h160_lanes[w * lanes + l]);
+                if (target_set_contains(&g_targets, h160_out))
+                    return i + l;
+            }
+        }
+    }
+    return -1;
+}
+
+static int batch_check_x1(secp256k1_ge *aff, unsigned char h160_out[20]) {
+    return batch_check_impl(aff, h160_out, 1, hash160_xw_flat_x1);
+}
+HASH160_TARGET_AVX2
+static int batch_check_x8(secp256k1_ge *aff, unsigned char h160_out[20]) {
+    return batch_check_impl(aff, h160_out, 8, hash160_xw_flat_x8);
+}
+HASH160_TARGET_AVX512
+static int batch_check_x16(secp256k1_ge *aff, unsigned char h160_out[20]) {
+    return batch_check_impl(aff, h160_out, 16, hash160_xw_flat_x16);
+}
+
+/* Step 3 for the hash kernel picked at startup (select_batch_check) */
+static int (*batch_check)(secp256k1_ge *aff, unsigned char h160_out[20]) = batch_check_x1;
+
+/* ======================== Fused Pipeline ======================== */
+
+/*
+ * Fused engine (--engine=fused): affine_batch_impl's stepping with the
+ * hash folded into the backward pass.  Each point is written straight into
+ * its hash lane as it is finished, and every `lanes` points are hashed and
+ * checked while they are still in registers / L1, so no BATCH_SIZE array
+ * of points is ever built; the only per-batch buffer is prod, which keeps
+ * one inversion shared by the whole batch.  Points leave the backward pass
+ * from BATCH_SIZE-1 down to 0 (and *p advances as in affine_batch), so
+ * the returned index is the same key offset as batch_check's.  batch is
+ * the batch size as a constant for a registry instance, 0 for BATCH_SIZE.
+ */
+static SCANNER_ALWAYS_INLINE int fused_batch_impl(secp256k1_ge *p, secp256k1_fe *prod, unsigned char h160_out[20],
+                                                  const int lanes, const int batch,
+                                                  void (*xw_fn)(const uint32_t *, const uint32_t *, uint32_t *)) {
+    const int n = batch ? batch : BATCH_SIZE;
+    uint32_t prefix_lanes[HASH160_MAX_LANES];
+    uint32_t xw_lanes[8 * HASH160_MAX_LANES];
+    uint32_t h160_lanes[5 * HASH160_MAX_LANES];
+    const secp256k1_ge start = *p;
+    const secp256k1_ge *step = step_table();
+    secp256k1_fe neg_x, neg_y, dx, inv, inv_i, lambda, t;
+    int hit = -1, l = 0;
+
+    secp256k1_fe_negate(&neg_x, &start.x, 1);
+    secp256k1_fe_negate(&neg_y, &start.y, 1);
+
+    prod[0] = step[0].x;
+    secp256k1_fe_add(&prod[0], &neg_x);
+    for (int i = 1; i < n; i++) {
+        dx = step[i].x;
+        secp256k1_fe_add(&dx, &neg_x);
+        secp256k1_fe_mul(&prod[i], &prod[i-1], &dx);
+    }
+
+    secp256k1_fe_inv_var(&inv, &prod[n-1]);
+
+    /* Step i yields key offset i + 1 (i = -1: the start point itself), except
+     * i = n-1, which advances *p */
+    for (int i = n - 1; i >= -1; i--) {
+        secp256k1_ge r;
+        if (i >= 0) {
+            const secp256k1_ge *q = &step[i];
+            if (i > 0) {
+                dx = q->x;
+                secp256k1_fe_add(&dx, &neg_x);
+                secp256k1_fe_mul(&inv_i, &inv, &prod[i-1]);
+                secp256k1_fe_mul(&inv, &inv, &dx);
+            } else {
+                inv_i = inv;
+            }
+
+            t = q->y;
+            secp256k1_fe_add(&t, &neg_y);
+            secp256k1_fe_mul(&lambda, &t, &inv_i);
+
+            secp256k1_fe_sqr(&r.x, &lambda);
+            secp256k1_fe_add(&r.x, &neg_x);
+            secp256k1_fe_negate(&t, &q->x, 1);
+            secp256k1_fe_add(&r.x, &t);
+            secp256k1_fe_normalize_weak(&r.x);
+
+            secp256k1_fe_negate(&t, &r.x, 1);
+            secp256k1_fe_add(&t, &start.x);
+            secp256k1_fe_mul(&r.y, &lambda, &t);
+            secp256k1_fe_add(&r.y, &neg_y);
+            secp256k1_fe_normalize_weak(&r.y);
+            r.infinity = 0;
+
+            if (i == n - 1) {
+                *p = r;
+                continue;
+            }
+        } else {
+            r = start;
+        }
+
+        ge_hash_words(&r, prefix_lanes, xw_lanes, lanes, l);
+        if (++l < lanes) continue;
+        l = 0;
+
+        /* Tile full: lane k holds key offset i + lanes - k */
+        xw_fn(prefix_lanes, xw_lanes, h160_lanes);
+        for (int k = 0; k < lanes; k++) {
+            if (__builtin_expect(target_filter_hit(&g_targets, h160_lanes[k]), 0)) {
+                for (int w = 0; w < 5; w++)
+                    put_le32(h160_out + w * 4, h160_lanes[w * lanes + k]);
+                if (target_set_contains(&g_targets, h160_out)) {
+                    hit = i + lanes - k;
+                    goto out;
+                }
+            }
+        }
+    }
+
+out:
+    secp256k1_fe_normalize_var(&p->x);
+    secp256k1_fe_normalize_var(&p->y);
+    return hit;
+}
+
+/* One instance per hash kernel, each with and without BMI2 field code */
+static int fused_batch_x1(secp256k1_ge *p, secp256k1_fe *prod, unsigned char h160_out[20]) {
+    return fused_batch_impl(p, prod, h160_out, 1, 0, hash160_xw_flat_x1);
+}
+HASH160_TARGET_AVX2
+static int fused_batch_x8(secp256k1_ge *p, secp256k1_fe *prod, unsigned char h160_out[20]) {
+    return fused_batch_impl(p, prod, h160_out, 8, 0, hash160_xw_flat_x8);
+}
+HASH160_TARGET_AVX512
+static int fused_batch_x16(secp256k1_ge *p, secp256k1_fe *prod, unsigned char h160_out[20]) {
+    return fused_batch_impl(p, prod, h160_out, 16, 0, hash160_xw_flat_x16);
+}
+#if FIELD_DISPATCH
+__attribute__((target("bmi2")))
+static int fused_batch_x1_bmi2(secp256k1_ge *p, secp256k1_fe *prod, unsigned char h160_out[20]) {
+    return fused_batch_impl(p, prod, h160_out, 1, 0, hash160_xw_flat_x1);
+}
+__attribute__((target("avx2,bmi2")))
+static int fused_batch_x8_bmi2(secp256k1_ge *p, secp256k1_fe *prod, unsigned char h160_out[20]) {
+    return fused_batch_impl(p, prod, h160_out, 8, 0, hash160_xw_flat_x8);
+}
+__attribute__((target("avx512f,bmi2")))
+static int fused_batch_x16_bmi2(secp256k1_ge *p, secp256k1_fe *prod, unsigned char h160_out[20]) {
+    return fused_batch_impl(p, prod, h160_out, 16, 0, hash160_xw_flat_x16);
+}
+#endif
+
+/* Batch sizes with their own fused / simd instances (kernel registry) */
+#define KERNEL_BATCHES(X) X(1024) X(2048) X(4096)
+
+#define FUSED_KERNEL(lanes, batch, sfx, attr)                                                        \
+    attr static int fused_batch_x##lanes##_b##batch##sfx(secp256k1_ge *p, secp256k1_fe *prod,          \
+                                                          unsigned char h160_out[20]) {               \
+        return fused_batch_impl(p, prod, h160_out, lanes, batch, hash160_xw_flat_x##lanes);             \
+    }
+#if FIELD_DISPATCH
+#define FUSED_KERNELS_BMI2(batch)                                                                    \
+    FUSED_KERNEL(1, batch, _bmi2, __attribute__((target("bmi2"))))                                      \
+    FUSED_KERNEL(8, batch, _bmi2, __attribute__((target("avx2,bmi2"))))                                 \
+    FUSED_KERNEL(16, batch, _bmi2, __attribute__((target("avx512f,bmi2"))))
+#else
+#define FUSED_KERNELS_BMI2(batch)
+#endif
+#define FUSED_KERNELS(batch)                                                                         \
+    FUSED_KERNEL(1, batch, , )                                                                        \
+    FUSED_KERNEL(8, batch, , HASH160_TARGET_AVX2)                                                     \
+    FUSED_KERNEL(16, batch, , HASH160_TARGET_AVX512)                                                  \
+    FUSED_KERNELS_BMI2(batch)
+KERNEL_BATCHES(FUSED_KERNELS)
+
+/* ======================== SIMD Field Chains ======================== */
+
+/*
+ * SIMD engine (--engine=simd): SIMD_CHAINS independent chains stepped
+ * together, one chain per 64-bit lane, with the field multiply done by
+ * AVX-512 IFMA (vpmadd52luq / vpmadd52huq, 52x52-bit multiply-add) on the
+ * same 5x52 limb layout libsecp256k1 uses.  Each batch is affine stepping
+ * as in affine_batch, 8 chains wide: one prefix-product pass, one (scalar)
+ * inversion per chain, then the backward pass hashes the finished points
+ * straight from the lanes, one hash tile per step (x8 kernel) or per two
+ * steps (x16).
+ *
+ * fe8_t limbs are kept below 2^52 (n[4] <= 2^48) between operations, as
+ * IFMA only reads the low 52 bits of its multiplicands; values are reduced
+ * mod p only as far as that (canonical form only for hashing).
+ */
+#if SIMD_FIELD
+#ifdef __clang__
+#pragma clang attribute push(__attribute__((target("avx512f,avx512ifma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512ifma")
+#endif
+
+typedef struct {
+    __m512i n[5];
+} fe8_t;
+
+#define FE8_M52  0xFFFFFFFFFFFFFULL
+#define FE8_M48  0xFFFFFFFFFFFFULL
+#define FE8_C256 0x1000003D1ULL      /* 2^256 mod p */
+#define FE8_C260 0x1000003D10ULL     /* 2^260 mod p */
+
+/* 4p in 5x52 limbs: a + 4p - b keeps every limb non-negative */
+static const uint64_t FE8_4P[5] = {
+    0xFFFFEFFFFFC2FULL * 4, 0xFFFFFFFFFFFFFULL * 4, 0xFFFFFFFFFFFFFULL * 4,
+    0xFFFFFFFFFFFFFULL * 4, 0x0FFFFFFFFFFFFULL * 4
+};
+
+/* Carry limbs below 2^63 down to < 2^52 and fold bits above 2^256 */
+static inline void fe8_carry(__m512i n[5]) {
+    const __m512i m52 = _mm512_set1_epi64(FE8_M52), m48 = _mm512_set1_epi64(FE8_M48);
+    for (int k = 0; k < 4; k++) {
+        n[k + 1] = _mm512_add_epi64(n[k + 1], _mm512_srli_epi64(n[k], 52));
+        n[k] = _mm512_and_si512(n[k], m52);
+    }
+    __m512i t = _mm512_srli_epi64(n[4], 48);
+    n[4] = _mm512_and_si512(n[4], m48);
+    n[0] = _mm512_madd52lo_epu64(n[0], t, _mm512_set1_epi64(FE8_C256));
+    for (int k = 0; k < 4; k++) {
+        n[k + 1] = _mm512_add_epi64(n[k + 1], _mm512_srli_epi64(n[k], 52));
+        n[k] = _mm512_and_si512(n[k], m52);
+    }
+}
+
+static inline void fe8_mul(fe8_t *r, const fe8_t *a, const fe8_t *b) {
+    const __m512i m52 = _mm512_set1_epi64(FE8_M52), c260 = _mm512_set1_epi64(FE8_C260);
+    __m512i c[10], d[6];
+    for (int k = 0; k < 10; k++) c[k] = _mm512_setzero_si512();
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 5; j++) {
+            c[i + j]     = _mm512_madd52lo_epu64(c[i + j], a->n[i], b->n[j]);
+            c[i + j + 1] = _mm512_madd52hi_epu64(c[i + j + 1], a->n[i], b->n[j]);
+        }
+    }
+    for (int k = 0; k < 9; k++) {
+        c[k + 1] = _mm512_add_epi64(c[k + 1], _mm512_srli_epi64(c[k], 52));
+        c[k] = _mm512_and_si512(c[k], m52);
+    }
+    __m512i c10 = _mm512_srli_epi64(c[9], 52);
+    c[9] = _mm512_and_si512(c[9], m52);
+
+    /* Fold limbs 5..9 (and c10 at 2^520) back with 2^260 = FE8_C260 */
+    for (int k = 0; k < 5; k++) d[k] = c[k];
+    d[5] = _mm512_madd52lo_epu64(_mm512_setzero_si512(), c10, c260);
+    for (int k = 0; k < 5; k++) {
+        d[k]     = _mm512_madd52lo_epu64(d[k], c[5 + k], c260);
+        d[k + 1] = _mm512_madd52hi_epu64(d[k + 1], c[5 + k], c260);
+    }
+    for (int k = 0; k < 5; k++) {
+        d[k + 1] = _mm512_add_epi64(d[k + 1], _mm512_srli_epi64(d[k], 52));
+        d[k] = _mm512_and_si512(d[k], m52);
+    }
+    d[0] = _mm512_madd52lo_epu64(d[0], d[5], c260);
+    d[1] = _mm512_madd52hi_epu64(d[1], d[5], c260);
+    fe8_carry(d);
+    for (int k = 0; k < 5; k++) r->n[k] = d[k];
+}
+
+static inline void fe8_sqr(fe8_t *r, const fe8_t *a) {
+    fe8_mul(r, a, a);
+}
+
+/* r = a - b */
+static inline void fe8_sub(fe8_t *r, const fe8_t *a, const fe8_t *b) {
+    for (int k = 0; k < 5; k++)
+        r->n[k] = _mm512_sub_epi64(_mm512_add_epi64(a->n[k], _mm512_set1_epi64(FE8_4P[k])), b->n[k]);
+    fe8_carry(r->n);
+}
+
+/* Lanes of a carried element (always < 2p) that are >= p; t = r - p there */
+static inline __mmask8 fe8_ge_p(const fe8_t *r, __m512i t[5]) {
+    const __m512i m52 = _mm512_set1_epi64(FE8_M52);
+    t[0] = _mm512_add_epi64(r->n[0], _mm512_set1_epi64(FE8_C256));
+    for (int k = 1; k < 5; k++) t[k] = r->n[k];
+    for (int k = 0; k < 4; k++) {
+        t[k + 1] = _mm512_add_epi64(t[k + 1], _mm512_srli_epi64(t[k], 52));
+        t[k] = _mm512_and_si512(t[k], m52);
+    }
+    /* r + 2^256 - p reaching 2^256 means r >= p */
+    __mmask8 ge = _mm512_test_epi64_mask(t[4], _mm512_set1_epi64(1ULL << 48));
+    t[4] = _mm512_and_si512(t[4], _mm512_set1_epi64(FE8_M48));
+    return ge;
+}
+
+/* Canonical form (< p) of a carried element */
+static inline void fe8_normalize(fe8_t *r) {
+    __m512i t[5];
+    __mmask8 ge = fe8_ge_p(r, t);
+    for (int k = 0; k < 5; k++) r->n[k] = _mm512_mask_mov_epi64(r->n[k], ge, t[k]);
+}
+
+/* Parity of the canonical form: p is odd, so subtracting it flips the bit */
+static inline __m512i fe8_odd(const fe8_t *r) {
+    __m512i t[5];
+    __mmask8 ge = fe8_ge_p(r, t);
+    __m512i one = _mm512_set1_epi64(1);
+    return _mm512_mask_xor_epi64(_mm512_and_si512(r->n[0], one), ge,
+                                 _mm512_and_si512(r->n[0], one), one);
+}
+
+static inline void fe8_load(fe8_t *r, const uint64_t *limbs) {
+    for (int k = 0; k < 5; k++) r->n[k] = _mm512_loadu_si512(limbs + k * SIMD_CHAINS);
+}
+
+static inline void fe8_store(uint64_t *limbs, const fe8_t *a) {
+    for (int k = 0; k < 5; k++) _mm512_storeu_si512(limbs + k * SIMD_CHAINS, a->n[k]);
+}
+
+static inline void fe8_broadcast(fe8_t *r, const uint64_t n[5]) {
+    for (int k = 0; k < 5; k++) r->n[k] = _mm512_set1_epi64(n[k]);
+}
+
+/* Hash words of 8 points into lanes base..base+7 of the flat xw layout */
+static inline void fe8_hash_words(fe8_t *x, const fe8_t *y, uint32_t *prefix, uint32_t *xw, int lanes, int base) {
+    fe8_normalize(x);
+    __m512i odd = fe8_odd(y);
+    _mm256_storeu_si256((__m256i *)(prefix + base),
+                        _mm512_cvtepi64_epi32(_mm512_or_si512(odd, _mm512_set1_epi64(2))));
+    const __m512i *n = x->n;
+    __m512i q[4];
+    q[3] = _mm512_or_si512(_mm512_srli_epi64(n[3], 36), _mm512_slli_epi64(n[4], 16));
+    q[2] = _mm512_or_si512(_mm512_srli_epi64(n[2], 24), _mm512_slli_epi64(n[3], 28));
+    q[1] = _mm512_or_si512(_mm512_srli_epi64(n[1], 12), _mm512_slli_epi64(n[2], 40));
+    q[0] = _mm512_or_si512(n[0], _mm512_slli_epi64(n[1], 52));
+    for (int i = 0; i < 4; i++) {
+        _mm256_storeu_si256((__m256i *)(xw + (2*i) * lanes + base),
+                            _mm512_cvtepi64_epi32(_mm512_srli_epi64(q[3 - i], 32)));
+        _mm256_storeu_si256((__m256i *)(xw + (2*i + 1) * lanes + base),
+                            _mm512_cvtepi64_epi32(q[3 - i]));
+    }
+}
+
+/*
+ * One batch of every chain: chain c checks its next BATCH_SIZE keys and
+ * advances by BATCH_SIZE.  Returns c * BATCH_SIZE + offset of the first
+ * match (hash160 in h160_out) or -1.  lanes is 8 or 16; batch as in
+ * fused_batch_impl.
+ */
+static SCANNER_ALWAYS_INLINE int simd_batch_impl(uint64_t *st, unsigned char h160_out[20], const int lanes,
+                                                 const int batch,
+                                                 void (*xw_fn)(const uint32_t *, const uint32_t *, uint32_t *)) {
+    const int n = batch ? batch : BATCH_SIZE;
+    uint32_t prefix_lanes[HASH160_MAX_LANES];
+    uint32_t xw_lanes[8 * HASH160_MAX_LANES];
+    uint32_t h160_lanes[5 * HASH160_MAX_LANES];
+    const simd_step_t *step = g_simd_step;
+    fe8_t *prod = (fe8_t *)(st + SIMD_STATE_WORDS);
+    fe8_t px, py, qx, qy, dx, inv, inv_i, lambda, t, rx, ry;
+    int hit = -1, s = 0, offs[2] = { 0, 0 };
+    const int tile_steps = lanes / SIMD_CHAINS;
+
+    fe8_load(&px, st);
+    fe8_load(&py, st + 5 * SIMD_CHAINS);
+
+    for (int i = 0; i < n; i++) {
+        fe8_broadcast(&qx, step[i].x);
+        fe8_sub(&dx, &qx, &px);
+        if (i) fe8_mul(&prod[i], &prod[i-1], &dx);
+        else   prod[0] = dx;
+    }
+
+    /* One inversion per chain (scalar libsecp256k1) */
+    {
+        uint64_t limbs[5 * SIMD_CHAINS];
+        inv = prod[n-1];
+        fe8_normalize(&inv);
+        fe8_store(limbs, &inv);
+        for (int c = 0; c < SIMD_CHAINS; c++) {
+            secp256k1_fe f, fi;
+            for (int k = 0; k < 5; k++) f.n[k] = limbs[k * SIMD_CHAINS + c];
+            secp256k1_fe_inv_var(&fi, &f);
+            secp256k1_fe_normalize_var(&fi);
+            for (int k = 0; k < 5; k++) limbs[k * SIMD_CHAINS + c] = fi.n[k];
+        }
+        fe8_load(&inv, limbs);
+    }
+
+    /* Same step order as fused_batch_impl: i yields offset i + 1 */
+    for (int i = n - 1; i >= -1; i--) {
+        if (i >= 0) {
+            fe8_broadcast(&qx, step[i].x);
+            fe8_broadcast(&qy, step[i].y);
+            if (i > 0) {
+                fe8_sub(&dx, &qx, &px);
+                fe8_mul(&inv_i, &inv, &prod[i-1]);
+                fe8_mul(&inv, &inv, &dx);
+            } else {
+                inv_i = inv;
+            }
+            fe8_sub(&t, &qy, &py);
+            fe8_mul(&lambda, &t, &inv_i);
+            fe8_sqr(&rx, &lambda);
+            fe8_sub(&rx, &rx, &px);
+            fe8_sub(&rx, &rx, &qx);
+            fe8_sub(&t, &px, &rx);
+            fe8_mul(&ry, &lambda, &t);
+            fe8_sub(&ry, &ry, &py);
+            if (i == n - 1) {
+                fe8_store(st, &rx);
+                fe8_store(st + 5 * SIMD_CHAINS, &ry);
+                continue;
+            }
+        } else {
+            rx = px;
+            ry = py;
+        }
+
+        fe8_hash_words(&rx, &ry, prefix_lanes, xw_lanes, lanes, s * SIMD_CHAINS);
+        offs[s] = i + 1;
+        if (++s < tile_steps) continue;
+        s = 0;
+
+        /* Lane k: chain k % SIMD_CHAINS at offset offs[k / SIMD_CHAINS] */
+        xw_fn(prefix_lanes, xw_lanes, h160_lanes);
+        for (int k = 0; k < lanes; k++) {
+            if (__builtin_expect(target_filter_hit(&g_targets, h160_lanes[k]), 0)) {
+                for (int w = 0; w < 5; w++)
+                    put_le32(h160_out + w * 4, h160_lanes[w * lanes + k]);
+                if (target_set_contains(&g_targets, h160_out)) {
+                    hit = (k % SIMD_CHAINS) * n + offs[k / SIMD_CHAINS];
+                    return hit;
+                }
+            }
+        }
+    }
+    return hit;
+}
+
+static int simd_batch_x8(uint64_t *st, unsigned char h160_out[20]) {
+    return simd_batch_impl(st, h160_out, 8, 0, hash160_xw_flat_x8);
+}
+static int simd_batch_x16(uint64_t *st, unsigned char h160_out[20]) {
+    return simd_batch_impl(st, h160_out, 16, 0, hash160_xw_flat_x16);
+}
+
+#define SIMD_KERNELS(batch)                                                                          \
+    static int simd_batch_x8_b##batch(uint64_t *st, unsigned char h160_out[20]) {                     \
+        return simd_batch_impl(st, h160_out, 8, batch, hash160_xw_flat_x8);                           \
+    }                                                                                                 \
+    static int simd_batch_x16_b##batch(uint64_t *st, unsigned char h160_out[20]) {                    \
+        return simd_batch_impl(st, h160_out, 16, batch, hash160_xw_flat_x16);                         \
+    }
+KERNEL_BATCHES(SIMD_KERNELS)
+
+/* Field test: fe8_mul / fe8_sqr / fe8_sub lane by lane against libsecp256k1 */
+static int simd_field_selftest(void) {
+    uint64_t la[5 * SIMD_CHAINS], lb[5 * SIMD_CHAINS], lr[3][5 * SIMD_CHAINS];
+    secp256k1_fe fa[SIMD_CHAINS], fb[SIMD_CHAINS];
+    for (int c = 0; c < SIMD_CHAINS; c++) {
+        /* Table coordinates, plus p-1 and 0 in the last lanes */
+        fa[c] = g_step_table[c].x;
+        fb[c] = g_step_table[c + 1].y;
+        if (c == SIMD_CHAINS - 1) {
+            secp256k1_fe one;
+            secp256k1_fe_set_int(&one, 1);
+            secp256k1_fe_negate(&fa[c], &one, 1);
+        }
+        if (c == SIMD_CHAINS - 2) secp256k1_fe_clear(&fb[c]);
+        secp256k1_fe_normalize_var(&fa[c]);
+        secp256k1_fe_normalize_var(&fb[c]);
+        for (int k = 0; k < 5; k++) {
+            la[k * SIMD_CHAINS + c] = fa[c].n[k];
+            lb[k * SIMD_CHAINS + c] = fb[c].n[k];
+        }
+    }
+    fe8_t a, b, r;
+    fe8_load(&a, la);
+    fe8_load(&b, lb);
+    fe8_mul(&r, &a, &b);  fe8_normalize(&r); fe8_store(lr[0], &r);
+    fe8_sqr(&r, &a);      fe8_normalize(&r); fe8_store(lr[1], &r);
+    fe8_sub(&r, &b, &a);  fe8_normalize(&r); fe8_store(lr[2], &r);
+    for (int c = 0; c < SIMD_CHAINS; c++) {
+        secp256k1_fe e[3], na;
+        secp256k1_fe_mul(&e[0], &fa[c], &fb[c]);
+        secp256k1_fe_sqr(&e[1], &fa[c]);
+        secp256k1_fe_negate(&na, &fa[c], 1);
+        e[2] = fb[c];
+        secp256k1_fe_add(&e[2], &na);
+        for (int j = 0; j < 3; j++) {
+            secp256k1_fe_normalize_var(&e[j]);
+            for (int k = 0; k < 5; k++)
+                if (lr[j][k * SIMD_CHAINS + c] != e[j].n[k]) return 0;
+        }
+    }
+    return 1;
+}
+
+#ifdef __clang__
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif /* SIMD_FIELD */
+
+/* ======================== Kernel Registry ======================== */
+
+/*
+ * Every fused / simd instance by hash tile (lanes), field code and batch
+ * size; batch 0 is the generic instance, which reads BATCH_SIZE.  With the
+ * batch a constant, the stepping and hashing loops have fixed trip counts
+ * and the compiler unrolls and schedules each combination on its own.
+ * Adding a combination is one KERNEL_BATCHES entry (or one line here).
+ */
+typedef struct {
+    int engine, lanes, bmi2, batch;
+    int (*fused)(secp256k1_ge *p, secp256k1_fe *prod, unsigned char h160_out[20]);
+    int (*simd)(uint64_t *st, unsigned char h160_out[20]);
+} kernel_t;
+
+#define FUSED_ENTRIES(batch, sfx, bmi2)                                                              \
+    { ENGINE_FUSED, 1, bmi2, batch, fused_batch_x1##sfx, NULL },                                      \
+    { ENGINE_FUSED, 8, bmi2, batch, fused_batch_x8##sfx, NULL },                                      \
+    { ENGINE_FUSED, 16, bmi2, batch, fused_batch_x16##sfx, NULL },
+#define FUSED_BATCH_ENTRIES(batch) FUSED_ENTRIES(batch, _b##batch, 0)
+#define FUSED_BATCH_ENTRIES_BMI2(batch) FUSED_ENTRIES(batch, _b##batch##_bmi2, 1)
+#define SIMD_BATCH_ENTRIES(batch)                                                                    \
+    { ENGINE_SIMD, 8, 0, batch, NULL, simd_batch_x8_b##batch },                                       \
+    { ENGINE_SIMD, 16, 0, batch, NULL, simd_batch_x16_b##batch },
+
+static const kernel_t g_kernels[] = {
+    FUSED_ENTRIES(0, , 0)
+    KERNEL_BATCHES(FUSED_BATCH_ENTRIES)
+#if FIELD_DISPATCH
+    FUSED_ENTRIES(0, _bmi2, 1)
+    KERNEL_BATCHES(FUSED_BATCH_ENTRIES_BMI2)
+#endif
+#if SIMD_FIELD
+    { ENGINE_SIMD, 8, 0, 0, NULL, simd_batch_x8 },
+    { ENGINE_SIMD, 16, 0, 0, NULL, simd_batch_x16 },
+    KERNEL_BATCHES(SIMD_BATCH_ENTRIES)
+#endif
+};
+#define NUM_KERNELS ((int)(sizeof(g_kernels) / sizeof(g_kernels[0])))
+
+/* The instance for engine / lanes / field code at this batch size, else
+ * the generic one (NULL if there is none) */
+static const kernel_t *kernel_lookup(int engine, int lanes, int bmi2, int batch) {
+    const kernel_t *generic = NULL;
+    for (int i = 0; i < NUM_KERNELS; i++) {
+        const kernel_t *k = &g_kernels[i];
+        if (k->engine != engine || k->lanes != lanes || k->bmi2 != bmi2) continue;
+        if (k->batch == batch) return k;
+        if (!k->batch) generic = k;
+    }
+    return generic;
+}
+
+/* Steps 1-3 for the SIMD engine (select_batch_check) */
+static int (*simd_batch)(uint64_t *st, unsigned char h160_out[20]);
+
+/* Steps 1-3 for the fused engine (select_batch_check) */
+static int (*fused_batch)(secp256k1_ge *p, secp256k1_fe *prod, unsigned char h160_out[20]) = fused_batch_x1;
+
+/* The fused / simd registry entry in use, for reports */
+static const kernel_t *g_kernel;
+
+/* Hash kernel for the ISA, and the registry's pick for the engine at the
+ * current BATCH_SIZE: call again whenever BATCH_SIZE changes */
+static void select_batch_check(void) {
+    batch_check = hash160_lanes == 16 ? batch_check_x16 :
+                  hash160_lanes == 8  ? batch_check_x8 : batch_check_x1;
+    const kernel_t *k = kernel_lookup(ENGINE_FUSED, hash160_lanes, FIELD_DISPATCH && g_field_bmi2, BATCH_SIZE);
+    fused_batch = k->fused;
+    g_kernel = g_engine == ENGINE_FUSED ? k : NULL;
+#if SIMD_FIELD
+    /* Any IFMA CPU has AVX2, so the simd engine never hashes one lane */
+    if (g_simd_ifma) {
+        k = kernel_lookup(ENGINE_SIMD, hash160_lanes == 16 ? 16 : 8, 0, BATCH_SIZE);
+        simd_batch = k->simd;
+        if (g_engine == ENGINE_SIMD) g_kernel = k;
+    }
+#endif
+}
+
+/* Steps 1-3: check the next BATCH_SIZE keys of each of the g_chains chains;
+ * chain * BATCH_SIZE + index of the first match (its hash160 in h160_out)
+ * or -1 */
+static inline int batch_scan(batch_state_t *st, unsigned char h160_out[20]) {
+    if (g_engine >= ENGINE_FUSED) {
+        batch_advance(st);
+        if (g_engine == ENGINE_SIMD)
+            return simd_batch(st->simd, h160_out);
+        return fused_batch(&st->current_aff, st->inv_scratch, h160_out);
+    }
+    batch_next(st);
+    return batch_check(st->aff_batch, h160_out);
+}
+
+/* ======================== Autotune ======================== */
+
+/*
+ * --autotune: time the full per-key pipeline (engine + hash + target
+ * check) on one thread for each power-of-two batch size and keep the
+ * fastest.  The working set grows with the batch (aff_batch plus
+ * jac_batch / inv_scratch), so the best size depends on the L2 of the box.
+ */
+static int autotune_batch_size(void) {
+    int best = BATCH_SIZE;
+    double best_rate = 0;
+    printf("  Autotune (%s engine, %.2fs per size):\n", ENGINE_NAMES[g_engine], AUTOTUNE_SECONDS);
+    for (int b = AUTOTUNE_MIN_BATCH; b <= AUTOTUNE_MAX_BATCH; b *= 2) {
+        BATCH_SIZE = b;
+        select_batch_check();
+        batch_state_t st;
+        if (!batch_state_init(&st)) break;
+        /* Arbitrary start inside the range; a warm-up batch first */
+        unsigned char h160[20];
+        batch_seek(&st, 0x5A, 0x0123456789ABCDEFULL);
+        batch_scan(&st, h160);
+
+        uint64_t keys = 0;
+        double t0 = get_time_sec(), dt;
+        do {
+            batch_scan(&st, h160);
+            keys += (uint64_t)b * g_chains;
+            dt = get_time_sec() - t0;
+        } while (dt < AUTOTUNE_SECONDS);
+        batch_state_free(&st);
+
+        double rate = keys / dt;
+        size_t ws = (size_t)b * ((g_engine >= ENGINE_FUSED ? 0 : sizeof(secp256k1_ge)) +
+                    (g_engine == ENGINE_JACOBIAN ? sizeof(secp256k1_gej) :
+                     g_engine == ENGINE_SIMD ? sizeof(uint64_t) * 5 * SIMD_CHAINS : sizeof(secp256k1_fe)));
+        printf("    batch %6d (%5zu KB/thread): %8.3f Mk/s%s\n", b, ws / 1024, rate / 1e6,
+               g_kernel && g_kernel->batch ? "  [specialized]" : "");
+        if (rate > best_rate) {
+            best_rate = rate;
+            best = b;
+        }
+    }
+    BATCH_SIZE = best;
+    select_batch_check();
+    printf("  Autotune: batch %d\n", best);
+    return best;
+}
+
+/* ======================== Stage Benchmark ======================== */
+
+/*
+ * --bench[=FILE]: time every pipeline stage on its own, per key, for each
+ * batch size in g_bench_batches (or just --batch, when given) and thread
+ * counts 1, 2, 4 .. NUM_THREADS.  Each thread owns its buffers and is
+ * pinned as --pin says; all threads enter a stage together (barrier), run
+ * it untimed for BENCH_WARMUP and then for BENCH_SECONDS, so multi-thread
+ * rows show how the stage scales when the cores share L3 and memory
+ * bandwidth.  Cycles are TSC ticks (nominal clock), ns are wall time per
+ * key on one thread.  bench_regress.py runs fixed sets of these against
+ * stored baselines.
+ */
+#define BENCH_SECONDS  0.10
+#define BENCH_WARMUP   0.02
+#define BENCH_FILE     "/root/puzzle71/data/c_scanner_bench.json"
+
+enum {
+    STAGE_JACOBIAN_STEP,    /* gej_add_ge_var chain (Jacobian engine step 1) */
+    STAGE_BATCH_INVERSION,  /* ge_set_all_gej_var (Jacobian engine step 2) */
+    STAGE_AFFINE_BATCH,     /* affine engine: step + shared inversion */
+    STAGE_CENTER_BATCH,     /* center-out engine: step + shared inversion */
+    STAGE_FUSED_BATCH,      /* fused engine: step + inversion + hash + compare */
+    STAGE_SERIALIZE33,      /* secp256k1_eckey_pubkey_serialize33 */
+    STAGE_SHA256_33,        /* sha256_33 (SHA-NI or generic), one key at a time */
+    STAGE_RMD160_32,        /* rmd160_32, one key at a time */
+    STAGE_HASH160_WORDS,    /* ge_hash_words + hash160_xw_lanes (scan path) */
+    STAGE_COMPARE,          /* target filter + set lookup */
+    STAGE_PIPELINE,         /* batch_scan with g_engine */
+    NUM_STAGES
+};
+
+static const char *STAGE_NAMES[NUM_STAGES] = {
+    "jacobian_step", "batch_inversion", "affine_batch", "center_batch",
+    "fused_batch", "serialize33", "sha256_33", "rmd160_32", "hash160_words", "compare",
+    "pipeline"
+};
+
+static const int g_bench_batches[] = { 256, 1024, 2048, 4096, 16384 };
+#define BENCH_MAX_BATCH 16384
+
+typedef struct {
+    int                thread_id;
+    pthread_barrier_t *barrier;
+    int                ok;
+    uint64_t           keys[NUM_STAGES];
+    double             secs[NUM_STAGES];
+    uint64_t           ticks[NUM_STAGES];
+} bench_thread_t;
+
+static volatile uint64_t g_bench_sink;
+
+static void *bench_thread(void *arg) {
+    bench_thread_t *bt = (bench_thread_t *)arg;
+    pin_worker(bt->thread_id);
+    batch_state_t st;
+    secp256k1_gej *jac = malloc(sizeof(secp256k1_gej) * BATCH_SIZE);
+    secp256k1_ge *aff = malloc(sizeof(secp256k1_ge) * BATCH_SIZE);
+    secp256k1_fe *inv = malloc(sizeof(secp256k1_fe) * BATCH_SIZE);
+    unsigned char (*pub)[33] = malloc((size_t)33 * BATCH_SIZE);
+    unsigned char (*dig)[32] = malloc((size_t)32 * BATCH_SIZE);
+    unsigned char (*h160)[20] = malloc((size_t)20 * BATCH_SIZE);
+    bt->ok = jac && aff && inv && pub && dig && h160 && batch_state_init(&st);
+
+    /* Valid inputs for every stage: one batch from a per-thread start */
+    secp256k1_gej cur_j;
+    secp256k1_ge cur_a;
+    if (bt->ok) {
+        secp256k1_scalar s;
+        make_scalar(&s, 0x40 + bt->thread_id, 0x0123456789ABCDEFULL);
+        secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &cur_j, &s);
+        secp256k1_ge_set_gej_var(&cur_a, &cur_j);
+        batch_seek(&st, 0x40 + bt->thread_id, 0x0123456789ABCDEFULL);
+        jac[0] = cur_j;
+        for (int i = 1; i < BATCH_SIZE; i++)
+            secp256k1_gej_add_ge_var(&jac[i], &jac[i-1], &g_gen_affine, NULL);
+        secp256k1_ge_set_all_gej_var(aff, jac, BATCH_SIZE);
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            secp256k1_eckey_pubkey_serialize33(&aff[i], pub[i]);
+            sha256_33(pub[i], dig[i]);
+            rmd160_32(dig[i], h160[i]);
+        }
+    }
+
+    for (int stage = 0; stage < NUM_STAGES; stage++) {
+        pthread_barrier_wait(bt->barrier);
+        if (!bt->ok) continue;
+        uint64_t keys = 0, sink = 0;
+        uint64_t tick0 = read_tsc();
+        double t0 = get_time_sec(), dt;
+        int warm = 1;
+        do {
+            switch (stage) {
+            case STAGE_JACOBIAN_STEP:
+                jac[0] = cur_j;
+                for (int i = 1; i < BATCH_SIZE; i++)
+                    secp256k1_gej_add_ge_var(&jac[i], &jac[i-1], &g_gen_affine, NULL);
+                secp256k1_gej_add_ge_var(&cur_j, &jac[BATCH_SIZE-1], &g_gen_affine, NULL);
+                break;
+            case STAGE_BATCH_INVERSION:
+                secp256k1_ge_set_all_gej_var(aff, jac, BATCH_SIZE);
+                break;
+            case STAGE_AFFINE_BATCH:
+                affine_batch(aff, &cur_a, inv);
+                break;
+            case STAGE_CENTER_BATCH:
+                center_batch(aff, &cur_a, inv);
+                break;
+            case STAGE_FUSED_BATCH: {
+                unsigned char h[20];
+                sink += (uint64_t)fused_batch(&cur_a, inv, h);
+                break;
+            }
+            case STAGE_SERIALIZE33:
+                for (int i = 0; i < BATCH_SIZE; i++)
+                    secp256k1_eckey_pubkey_serialize33(&aff[i], pub[i]);
+                break;
+            case STAGE_SHA256_33:
+                for (int i = 0; i < BATCH_SIZE; i++)
+                    sha256_33(pub[i], dig[i]);
+                break;
+            case STAGE_RMD160_32:
+                for (int i = 0; i < BATCH_SIZE; i++)
+                    rmd160_32(dig[i], h160[i]);
+                break;
+            case STAGE_HASH160_WORDS: {
+                uint32_t prefix_lanes[HASH160_MAX_LANES];
+                uint32_t xw_lanes[8 * HASH160_MAX_LANES];
+                uint32_t h_lanes[5 * HASH160_MAX_LANES];
+                for (int i = 0; i < BATCH_SIZE; i += hash160_lanes) {
+                    for (int l = 0; l < hash160_lanes; l++)
+                        ge_hash_words(&aff[i + l], prefix_lanes, xw_lanes, hash160_lanes, l);
+                    hash160_xw_lanes(prefix_lanes, xw_lanes, h_lanes);
+                    sink += h_lanes[0];
+                }
+                break;
+            }
+            case STAGE_COMPARE:
+                for (int i = 0; i < BATCH_SIZE; i++)
+                    if (target_filter_hit(&g_targets, h160_word0(h160[i])))
+                        sink += target_set_contains(&g_targets, h160[i]);
+                break;
+            case STAGE_PIPELINE: {
+                unsigned char h[20];
+                sink += (uint64_t)batch_scan(&st, h);
+                break;
+            }
+            }
+            keys += stage == STAGE_PIPELINE ? (uint64_t)BATCH_SIZE * g_chains : (uint64_t)BATCH_SIZE;
+            dt = get_time_sec() - t0;
+            /* Caches, predictors and clocks settle before the timed part */
+            if (warm && dt >= BENCH_WARMUP) {
+                warm = 0;
+                keys = 0;
+                tick0 = read_tsc();
+                t0 = get_time_sec();
+                dt = 0;
+            }
+        } while (warm || dt < BENCH_SECONDS);
+        bt->ticks[stage] = read_tsc() - tick0;
+        bt->keys[stage] = keys;
+        bt->secs[stage] = dt;
+        g_bench_sink += sink;
+    }
+
+    if (jac && aff && inv && pub && dig && h160 && bt->ok) batch_state_free(&st);
+    free(jac); free(aff); free(inv); free(pub); free(dig); free(h160);
+    return NULL;
+}
+
+static int run_bench(const char *path, int only_batch) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return 1;
+    }
+    int saved_batch = BATCH_SIZE;
+    fprintf(f, "{\n  \"tool\": \"c_scanner\",\n  \"engine\": \"%s\",\n"
+               "  \"hash_kernel\": \"%s\",\n  \"sha256\": \"%s\",\n  \"field_code\": \"%s\",\n"
+               "  \"pinned\": %s,\n  \"seconds\": %.2f,\n  \"warmup\": %.2f,\n"
+               "  \"default_batch\": %d,\n  \"max_threads\": %d,\n  \"results\": [",
+            ENGINE_NAMES[g_engine], hash160_kernel_name(),
+            sha256_use_shani ? "sha-ni" : "generic", g_field_bmi2 ? "bmi2" : "generic",
+            g_pin_mode != PIN_NONE ? "true" : "false", BENCH_SECONDS, BENCH_WARMUP,
+            saved_batch, NUM_THREADS);
+
+    bench_thread_t *bt = calloc(NUM_THREADS, sizeof(bench_thread_t));
+    pthread_t *tids = malloc(sizeof(pthread_t) * NUM_THREADS);
+    if (!bt || !tids) {
+        fclose(f);
+        free(bt);
+        free(tids);
+        return 1;
+    }
+
+    printf("  Stage benchmark (%.2fs per stage after %.2fs warm-up; cycles = TSC ticks):\n",
+           BENCH_SECONDS, BENCH_WARMUP);
+    int first = 1, ok = 1;
+    for (size_t b = 0; b < sizeof(g_bench_batches) / sizeof(g_bench_batches[0]) && ok; b++) {
+        BATCH_SIZE = g_bench_batches[b];
+        if (BATCH_SIZE > g_step_table_size || (only_batch && BATCH_SIZE != only_batch)) continue;
+        select_batch_check();
+        for (int nt = 1; nt <= NUM_THREADS && ok; nt = (nt * 2 > NUM_THREADS && nt < NUM_THREADS) ? NUM_THREADS : nt * 2) {
+            pthread_barrier_t barrier;
+            pthread_barrier_init(&barrier, NULL, nt);
+            for (int i = 0; i < nt; i++) {
+                memset(&bt[i], 0, sizeof(bt[i]));
+                bt[i].thread_id = i;
+                bt[i].barrier = &barrier;
+                pthread_create(&tids[i], NULL, bench_thread, &bt[i]);
+            }
+            for (int i = 0; i < nt; i++) {
+                pthread_join(tids[i], NULL);
+                if (!bt[i].ok) ok = 0;
+            }
+            pthread_barrier_destroy(&barrier);
+            if (!ok) break;
+
+            printf("\n    batch %d, %d thread%s\n", BATCH_SIZE, nt, nt > 1 ? "s" : "");
+            printf("    %-16s %10s %10s %12s\n", "stage", "ns/key", "cyc/key", "Mk/s total");
+            for (int s = 0; s < NUM_STAGES; s++) {
+                /* Per-key cost averaged over threads; rate summed over threads */
+                double ns = 0, cyc = 0, rate = 0;
+                for (int i = 0; i < nt; i++) {
+                    ns += bt[i].secs[s] * 1e9 / bt[i].keys[s];
+                    cyc += (double)bt[i].ticks[s] / bt[i].keys[s];
+                    rate += bt[i].keys[s] / bt[i].secs[s];
+                }
+                ns /= nt;
+                cyc /= nt;
+                printf("    %-16s %10.1f %10.0f %12.3f\n", STAGE_NAMES[s], ns, cyc, rate / 1e6);
+                fprintf(f, "%s\n    {\"stage\": \"%s\", \"batch\": %d, \"threads\": %d, "
+                           "\"ns_per_key\": %.3f, \"cycles_per_key\": %.1f, \"keys_per_sec\": %.0f}",
+                        first ? "" : ",", STAGE_NAMES[s], BATCH_SIZE, nt, ns, cyc, rate);
+                first = 0;
+            }
+        }
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+    free(bt);
+    free(tids);
+    BATCH_SIZE = saved_batch;
+    select_batch_check();
+
+    if (!ok) {
+        fprintf(stderr, "Benchmark: malloc failed\n");
+        return 1;
+    }
+    printf("\n  Benchmark results written to %s\n", path);
+    return 0;
+}
+
+/* ======================== Candidate Queue ======================== */
+
+/*
+ * Workers never report a match themselves.  A hit from the scan kernels
+ * (first-word filter, then the sorted target set) or a GPU hit is pushed as
+ * its key into the worker's ring and the scan continues; the verifier
+ * thread derives the key again with secp256k1_ecmult_gen, checks its
+ * hash160 against the target set and only then prints, writes
+ * FOUND_KEY.txt and tells the coordinator (report_found).  A key that does
+ * not confirm is logged and scanning goes on.
+ */
+
+/* Re-derive a key the slow way; 1 (and h160 set) if it is a target */
+static int candidate_verify(uint64_t hi, uint64_t lo, unsigned char h160[20]) {
+    secp256k1_scalar s;
+    secp256k1_gej pj;
+    secp256k1_ge p;
+    unsigned char pub[33];
+    make_scalar(&s, hi, lo);
+    secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &pj, &s);
+    secp256k1_ge_set_gej_var(&p, &pj);
+    secp256k1_eckey_pubkey_serialize33(&p, pub);
+    hash160(pub, h160);
+    return target_set_contains(&g_targets, h160);
+}
+
+/* Worker side.  The ring only fills if the verifier is CAND_RING
+ * candidates behind; a candidate may be the key, so wait rather than drop. */
+static void cand_push(cand_ring_t *r, uint64_t hi, uint64_t lo) {
+    unsigned h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    while (h - atomic_load_explicit(&r->tail, memory_order_acquire) >= CAND_RING)
+        usleep(CAND_POLL_US);
+    r->hi[h & (CAND_RING - 1)] = hi;
+    r->lo[h & (CAND_RING - 1)] = lo;
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+    atomic_fetch_add_explicit(&g_cand_pushed, 1, memory_order_relaxed);
+}
+
+/* Verify everything queued; returns the number of candidates taken.  Two
+ * workers can reach the same key (overlapping random runs), which is
+ * reported once. */
+static int cand_drain(void) {
+    static uint64_t last_hi, last_lo;
+    static int reported = 0;
+    int n = 0;
+    for (int w = 0; w < g_num_workers; w++) {
+        cand_ring_t *r = &g_cand_rings[w];
+        unsigned t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        while (t != atomic_load_explicit(&r->head, memory_order_acquire)) {
+            uint64_t hi = r->hi[t & (CAND_RING - 1)], lo = r->lo[t & (CAND_RING - 1)];
+            atomic_store_explicit(&r->tail, ++t, memory_order_release);
+            n++;
+            unsigned char h160[20];
+            if (candidate_verify(hi, lo, h160)) {
+                atomic_fetch_add(&g_cand_confirmed, 1);
+                if (reported && hi == last_hi && lo == last_lo) continue;
+                report_found(hi, lo, h160);
+                last_hi = hi;
+                last_lo = lo;
+                reported = 1;
+            } else {
+                char keystr[64];
+                format_privkey(keystr, hi, lo);
+                atomic_fetch_add(&g_cand_rejected, 1);
+                fprintf(stderr, "Worker %d: candidate %s not confirmed by ecmult_gen\n", w, keystr);
+            }
+        }
+    }
+    return n;
+}
+
+/* Polls the rings until g_cand_stop, then takes what is left */
+static void *verifier_thread(void *arg) {
+    (void)arg;
+    for (;;) {
+        int stop = atomic_load(&g_cand_stop);
+        if (!cand_drain()) {
+            if (stop) break;
+            usleep(CAND_POLL_US);
+        }
+    }
+    return NULL;
+}
+
+/* ======================== Co-Scheduler ======================== */
+
+/*
+ * One process drives the GPUs and the CPU workers (--gpu).  Each GPU feeder
+ * thread keeps --gpu-cores CPUs to itself (g_cpu_reserved, pin_worker), and
+ * the CPU workers that remain run only while they do not slow the GPUs:
+ * cosched_tick parks some when a GPU's rate drops COSCHED_STARVE_PCT below
+ * its recent level and probes them back in after a hold that doubles on
+ * every failed probe.  One CPU worker adds far less than a GPU's rate
+ * varies, so the test is the GPUs' own rate rather than the box total.
+ * Units come from one pool, so each device already claims in proportion to
+ * its speed; the coordinator lease is sized from the measured box rate.
+ */
+
+/* Startup split: all CPU workers run at first only without GPUs */
+static void cosched_init(void) {
+    int cpu_max = NUM_THREADS;
+    g_cpu_reserved = 0;
+    if (g_num_gpus) {
+        g_cpu_reserved = g_num_gpus * g_gpu_cores;
+        if (g_cpu_reserved > g_num_cpus) g_cpu_reserved = g_num_cpus;
+        if (g_num_cpus && cpu_max > g_num_cpus - g_cpu_reserved)
+            cpu_max = g_num_cpus - g_cpu_reserved;
+    }
+    atomic_store(&g_cpu_max, cpu_max);
+    /* GPUs are measured alone for the first intervals, then CPU workers ramp in */
+    atomic_store(&g_cpu_active, g_num_gpus && g_cosched ? 0 : cpu_max);
+}
+
+/* GPU worker g gave up: its cores go back to the CPU pool */
+static void cosched_gpu_lost(int g) {
+    int cores = g_gpu_cores;
+    atomic_store(&g_gpu_lost[g], 1);
+    int cpu_max = atomic_fetch_add(&g_cpu_max, cores) + cores;
+    if (cpu_max > NUM_THREADS) atomic_store(&g_cpu_max, cpu_max = NUM_THREADS);
+    if (!g_cosched) atomic_store(&g_cpu_active, cpu_max);
+}
+
+/* ======================== Energy Governor ======================== */
+
+/*
+ * Energy meters: the top-level RAPL zones (intel-rapl:N, one per package;
+ * AMD exposes its counters there as well, and the core / dram subzones
+ * intel-rapl:N:M are part of the package figure), else hwmon sensors that
+ * measure the CPU or the whole box.  Counters are in uJ and wrap at
+ * max_energy_range_uj; hwmon power is in uW and integrated between reads.
+ * energy_uj is root-only since Linux 5.10, so an unprivileged run has no
+ * meter and governs on keys/s alone.
+ */
+typedef struct {
+    char   path[PATH_MAX];
+    int    power;        /* hwmon power (uW), else an energy counter (uJ) */
+    double range_uj;     /* counter wraps here, 0 = never */
+    double last;         /* previous reading */
+} energy_meter_t;
+
+static const struct { const char *name, *file; } g_energy_hwmon[] = {
+    { "power_meter",  "power1_average" },   /* ACPI: the box at the wall */
+    { "zenpower",     "power1_input" },     /* AMD core ... */
+    { "zenpower",     "power2_input" },     /* ... and SoC */
+    { "fam15h_power", "power1_input" },
+};
+
+static energy_meter_t g_meters[ENERGY_MAX_METERS];
+static int            g_num_meters;
+static const char    *g_meter_kind = "none";
+static double         g_meter_time;
+
+static int read_sys_double(const char *path, double *v) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    int ok = fscanf(f, "%lf", v) == 1;
+    fclose(f);
+    return ok;
+}
+
+static void energy_add_meter(const char *dir, const char *name, const char *file, int power) {
+    energy_meter_t *m = &g_meters[g_num_meters];
+    char range[PATH_MAX];
+    if (g_num_meters == ENERGY_MAX_METERS) return;
+    snprintf(m->path, sizeof(m->path), "%s/%s/%s", dir, name, file);
+    if (!read_sys_double(m->path, &m->last)) return;
+    snprintf(range, sizeof(range), "%s/%s/max_energy_range_uj", dir, name);
+    if (power || !read_sys_double(range, &m->range_uj)) m->range_uj = 0;
+    m->power = power;
+    g_num_meters++;
+}
+
+static int energy_init(void) {
+    struct dirent *e;
+    DIR *d = opendir(ENERGY_POWERCAP_DIR);
+    g_num_meters = 0;
+    while (d && (e = readdir(d)) != NULL) {
+        int pkg, end = 0;
+        if (sscanf(e->d_name, "intel-rapl:%d%n", &pkg, &end) == 1 && !e->d_name[end])
+            energy_add_meter(ENERGY_POWERCAP_DIR, e->d_name, "energy_uj", 0);
+    }
+    if (d) closedir(d);
+    g_meter_kind = "RAPL";
+    if (!g_num_meters && (d = opendir(ENERGY_HWMON_DIR)) != NULL) {
+        while ((e = readdir(d)) != NULL) {
+            char path[PATH_MAX], name[64] = "";
+            if (e->d_name[0] == '.') continue;
+            snprintf(path, sizeof(path), "%s/%s/name", ENERGY_HWMON_DIR, e->d_name);
+            FILE *f = fopen(path, "r");
+            if (!f) continue;
+            if (fscanf(f, "%63s", name) != 1) name[0] = 0;
+            fclose(f);
+            for (size_t i = 0; i < sizeof(g_energy_hwmon) / sizeof(g_energy_hwmon[0]); i++)
+                if (!strcmp(name, g_energy_hwmon[i].name))
+                    energy_add_meter(ENERGY_HWMON_DIR, e->d_name, g_energy_hwmon[i].file, 1);
+        }
+        closedir(d);
+        g_meter_kind = "hwmon";
+    }
+    if (!g_num_meters) g_meter_kind = "none";
+    g_meter_time = get_time_sec();
+    return g_num_meters;
+}
+
+/* Joules since the previous call (one caller at a time: main during the
+ * sweep, then the stats thread); -1 without a meter */
+static double energy_sample(void) {
+    if (!g_num_meters) return -1;
+    double now = get_time_sec(), joules = 0;
+    for (int i = 0; i < g_num_meters; i++) {
+        energy_meter_t *m = &g_meters[i];
+        double v;
+        if (!read_sys_double(m->path, &v)) continue;
+        if (m->power) {
+            joules += (m->last + v) / 2 * 1e-6 * (now - g_meter_time);
+        } else {
+            double d = v - m->last;
+            if (d < 0) d += m->range_uj;
+            joules += d * 1e-6;
+        }
+        m->last = v;
+    }
+    g_meter_time = now;
+    return joules;
+}
+
+/*
+ * The sweep, before the scan: every candidate engine (the --engine given,
+ * else the default, fused and simd) with every hash ISA the CPU runs (the
+ * --isa given, else all; AVX-512 clocks lower and SMT siblings share their
+ * core, so neither is assumed to pay) on 1, 2, 4 .. NUM_THREADS pinned
+ * threads, GOVERNOR_SECONDS each after GOVERNOR_WARMUP.  The objective
+ * picks the highest keys/s or keys/J among the settings within
+ * --power-cap; if none is, the lowest-power one.
+ */
+static atomic_int    g_gov_stop;
+static atomic_int    g_gov_ready;
+static atomic_ullong g_gov_keys;
+
+static void *gov_thread(void *arg) {
+    int tid = (int)(intptr_t)arg, ok;
+    pin_worker(tid);
+    batch_state_t st;
+    ok = batch_state_init(&st);
+    atomic_fetch_add(&g_gov_ready, 1);
+    if (!ok) return (void *)0;
+    unsigned char h160[20];
+    batch_seek(&st, 0x40 + tid, 0x0123456789ABCDEFULL);
+    while (!atomic_load_explicit(&g_gov_stop, memory_order_relaxed)) {
+        batch_scan(&st, h160);
+        atomic_fetch_add_explicit(&g_gov_keys, (uint64_t)BATCH_SIZE * g_chains, memory_order_relaxed);
+    }
+    batch_state_free(&st);
+    return (void *)1;
+}
+
+/* One setting on nt threads: keys/s and watts (0 without a meter) */
+static int gov_trial(int nt, double *rate, double *watts) {
+    pthread_t *tids = malloc(sizeof(pthread_t) * nt);
+    if (!tids) return 0;
+    atomic_store(&g_gov_stop, 0);
+    atomic_store(&g_gov_ready, 0);
+    atomic_store(&g_gov_keys, 0);
+    int started = 0, ok = 1;
+    for (; started < nt; started++)
+        if (pthread_create(&tids[started], NULL, gov_thread, (void *)(intptr_t)started) != 0) break;
+    while (atomic_load(&g_gov_ready) < started) usleep(1000);
+    usleep((useconds_t)(GOVERNOR_WARMUP * 1e6));
+    energy_sample();
+    unsigned long long k0 = atomic_load(&g_gov_keys);
+    double t0 = get_time_sec();
+    usleep((useconds_t)(GOVERNOR_SECONDS * 1e6));
+    double joules = energy_sample(), dt = get_time_sec() - t0;
+    unsigned long long k1 = atomic_load(&g_gov_keys);
+    atomic_store(&g_gov_stop, 1);
+    for (int i = 0; i < started; i++) {
+        void *r;
+        pthread_join(tids[i], &r);
+        if (!r) ok = 0;
+    }
+    free(tids);
+    *rate = (k1 - k0) / dt;
+    *watts = joules > 0 ? joules / dt : 0;
+    return ok && started == nt;
+}
+
+/* Engine and ISA for a trial; batches is the scan's NUM_BATCHES before it
+ * is rounded to the engine's chains, so each trial steps the real chunk */
+static void gov_apply(int engine, int isa, int batches) {
+    g_engine = engine;
+    g_chains = engine == ENGINE_SIMD ? SIMD_CHAINS : 1;
+    NUM_BATCHES = (batches + g_chains - 1) / g_chains * g_chains;
+    hash160_select(isa);
+    select_batch_check();
+}
+
+static int governor_sweep(int engine_fixed, int isa_fixed) {
+    int engines[3], ne = 0, isas[HASH160_ISA_AUTO], ni = 0;
+    engines[ne++] = g_engine;
+    if (!engine_fixed) {
+        if (g_engine != ENGINE_FUSED) engines[ne++] = ENGINE_FUSED;
+        if (g_simd_ifma && g_engine != ENGINE_SIMD) engines[ne++] = ENGINE_SIMD;
+    }
+    if (isa_fixed)
+        isas[ni++] = hash160_isa;
+    else
+        for (int k = HASH160_ISA_AUTO - 1; k >= HASH160_ISA_SCALAR; k--)
+            if (hash160_isa_supported(k)) isas[ni++] = k;
+
+    int best_e = g_engine, best_i = hash160_isa, best_nt = NUM_THREADS, fits = 0, batches = NUM_BATCHES;
+    double best = -1, best_rate = 0, best_w = 0;
+    printf("  Governor sweep (%s, %.2fs per setting, energy from %s%s):\n",
+           g_governor == GOV_ENERGY && g_num_meters ? "keys/J" : "keys/s", GOVERNOR_SECONDS,
+           g_meter_kind, g_power_cap > 0 && g_num_meters ? "" : g_power_cap > 0 ? ", no cap" : "");
+    for (int e = 0; e < ne; e++) {
+        for (int i = 0; i < ni; i++) {
+            /* Any IFMA CPU has AVX2, so the simd engine never hashes one lane */
+            if (engines[e] == ENGINE_SIMD && isas[i] == HASH160_ISA_SCALAR) continue;
+            gov_apply(engines[e], isas[i], batches);
+            for (int nt = 1; nt <= NUM_THREADS && !atomic_load(&g_found);
+                 nt = (nt * 2 > NUM_THREADS && nt < NUM_THREADS) ? NUM_THREADS : nt * 2) {
+                double rate, watts;
+                if (!gov_trial(nt, &rate, &watts)) {
+                    fprintf(stderr, "  Governor: trial allocation failed\n");
+                    return 0;
+                }
+                int ok = !(g_power_cap > 0 && watts > g_power_cap);
+                double score = g_governor == GOV_ENERGY && watts > 0 ? rate / watts : rate;
+                printf("    %-8s %-6s %3d thread%s %9.3f Mk/s", ENGINE_NAMES[engines[e]],
+                       HASH160_ISA_NAMES[isas[i]], nt, nt > 1 ? "s" : " ", rate / 1e6);
+                if (watts > 0) printf(" %7.1f W %8.4f Mk/J", watts, rate / watts / 1e6);
+                printf("%s\n", ok ? "" : "  [over cap]");
+                /* Within the cap the objective decides; until a setting fits, the lowest power */
+                if (ok ? (!fits || score > best) : (!fits && (best < 0 || watts < best_w))) {
+                    fits |= ok;
+                    best = score;
+                    best_rate = rate;
+                    best_w = watts;
+                    best_e = engines[e];
+                    best_i = isas[i];
+                    best_nt = nt;
+                }
+                /* More threads only draw more */
+                if (!ok) break;
+            }
+        }
+    }
+    gov_apply(best_e, best_i, batches);
+    g_gov_threads = best_nt;
+    g_gov_kpj = best_w > 0 ? best_rate / best_w : 0;
+    printf("  Governor: %s engine, %s hash, %d CPU worker%s: %.3f Mk/s", ENGINE_NAMES[g_engine],
+           hash160_kernel_name(), best_nt, best_nt > 1 ? "s" : "", best_rate / 1e6);
+    if (best_w > 0) printf(", %.1f W, %.4f Mk/J", best_w, g_gov_kpj / 1e6);
+    printf("%s\n", g_power_cap > 0 && g_num_meters && !fits ? " (nothing fits the cap)" : "");
+    return 1;
+}
+
+/* Stats-thread step under --power-cap: shed the workers the excess power
+ * stands for, and bring one back while its share still fits */
+static void governor_tick(double watts) {
+    int active = atomic_load(&g_cpu_active);
+    if (g_power_cap <= 0 || watts <= 0 || active < 1) return;
+    if (watts > g_power_cap && active > 1) {
+        int shed = (int)((watts - g_power_cap) * active / watts) + 1;
+        active = shed >= active ? 1 : active - shed;
+    } else if (active < g_gov_threads && watts * (active + 1) / active <= g_power_cap) {
+        active++;
+    }
+    atomic_store(&g_cpu_active, active);
+}
+
+/* ======================== Worker Thread ======================== */
+
+/*
+ * --sample=N: after every Nth batch, one key the batch covered is derived
+ * again with secp256k1_ecmult_gen and must equal the engine's point, and
+ * hash through this CPU's scan kernel (every lane) to hash160 of its
+ * serialize33 bytes.  Engines without a stored batch (fused, simd) are
+ * checked at the stream position instead: a random chain's next start.
+ * Returns 0 on a mismatch.
+ */
+static int sample_check(const batch_state_t *st, uint64_t hi, uint64_t lo, int batch_num,
+                        xorshift64_t *rng) {
+    uint64_t r = xorshift64_next(rng), off;
+    secp256k1_ge got;
+    if (g_engine >= ENGINE_FUSED) {
+        int c = (int)(r % g_chains);
+        off = c * st->chain_stride + (uint64_t)(batch_num + 1) * BATCH_SIZE;
+        if (g_engine == ENGINE_SIMD) {
+            for (int k = 0; k < 5; k++) {
+                got.x.n[k] = st->simd[k * SIMD_CHAINS + c];
+                got.y.n[k] = st->simd[(5 + k) * SIMD_CHAINS + c];
+            }
+            got.infinity = 0;
+        } else {
+            got = st->current_aff;
+        }
+    } else {
+        int j = (int)((r >> 32) % BATCH_SIZE);
+        off = (uint64_t)batch_num * BATCH_SIZE + j;
+        got = st->aff_batch[j];
+    }
+    secp256k1_fe_normalize_var(&got.x);
+    secp256k1_fe_normalize_var(&got.y);
+
+    uint64_t key_hi = hi, key_lo = lo;
+    key_step(&key_hi, &key_lo, off);
+    secp256k1_scalar s;
+    secp256k1_gej rj;
+    secp256k1_ge ref;
+    make_scalar(&s, key_hi, key_lo);
+    secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &rj, &s);
+    secp256k1_scalar_clear(&s);
+    secp256k1_ge_set_gej_var(&ref, &rj);
+
+    unsigned char want_pub[33], got_pub[33], want[20];
+    secp256k1_eckey_pubkey_serialize33(&ref, want_pub);
+    secp256k1_eckey_pubkey_serialize33(&got, got_pub);
+    hash160(want_pub, want);
+
+    uint32_t prefix_lanes[HASH160_MAX_LANES];
+    uint32_t xw_lanes[8 * HASH160_MAX_LANES];
+    uint32_t h_lanes[5 * HASH160_MAX_LANES];
+    for (int l = 0; l < hash160_lanes; l++)
+        ge_hash_words(&got, prefix_lanes, xw_lanes, hash160_lanes, l);
+    hash160_xw_lanes(prefix_lanes, xw_lanes, h_lanes);
+    int ok = memcmp(want_pub, got_pub, 33) == 0;
+    for (int l = 0; l < hash160_lanes && ok; l++) {
+        unsigned char h[20];
+        for (int w = 0; w < 5; w++)
+            put_le32(h + w * 4, h_lanes[w * hash160_lanes + l]);
+        ok = memcmp(h, want, 20) == 0;
+    }
+    if (!ok)
+        fprintf(stderr, "\n  SAMPLE MISMATCH (%s engine): key 0x%02llx%016llx\n",
+                ENGINE_NAMES[g_engine], (unsigned long long)key_hi, (unsigned long long)key_lo);
+    return ok;
+}
+
+/*
+ * One chunk of CHUNK_SIZE keys from (hi, lo) on st: every chain advances
+ * NUM_BATCHES / g_chains batches, skipping the first `first` of them (a
+ * resumed or stolen range).  With a steal slot, each batch is taken from its
+ * range first and the scan ends where the range does.  With a candidate
+ * ring, a match is pushed there and the scan goes on with the next batch;
+ * without one (the self-tests) it returns 1 with the key and its hash160.
+ * Returns 0 when the chunk is finished or the scan stops.  Checked keys go
+ * to *local_count (the caller flushes it) and ts.
+ */
+static int scan_chunk(batch_state_t *st, uint64_t hi, uint64_t lo, int first, steal_slot_t *slot,
+                      cand_ring_t *ring, thread_stats_t *ts, uint64_t *local_count, xorshift64_t *rng,
+                      uint64_t *found_hi, uint64_t *found_lo, unsigned char h160[20]) {
+    if (first >= NUM_BATCHES / g_chains) return 0;
+
+    /* Full scalar multiplication for the starting point: P = privkey * G */
+    uint64_t seek_hi = hi, seek_lo = lo;
+    key_step(&seek_hi, &seek_lo, (uint64_t)first * BATCH_SIZE);
+    batch_seek(st, seek_hi, seek_lo);
+    tstat_add(&ts->starts, 1);
+
+    /* Process NUM_BATCHES batches (NUM_BATCHES / g_chains per chain) */
+    for (int batch_num = first; batch_num < NUM_BATCHES / g_chains && !atomic_load(&g_found); batch_num++) {
+        if (slot && !job_take(slot, batch_num)) break;
+        int sample = g_stage_timing && !(batch_num & ((1 << STAGE_SAMPLE_SHIFT) - 1));
+        uint64_t t0 = sample ? read_tsc() : 0;
+
+        /* Steps 1+2: the next BATCH_SIZE points in affine form, then
+         * step 3: serialize, hash and check against the target set.  The
+         * fused and simd engines do all three at once (timed as generate). */
+        int hit;
+        uint64_t t1;
+        if (g_engine >= ENGINE_FUSED) {
+            hit = batch_scan(st, h160);
+            t1 = sample ? read_tsc() : 0;
+        } else {
+            batch_next(st);
+            t1 = sample ? read_tsc() : 0;
+            hit = batch_check(st->aff_batch, h160);
+        }
+        if (sample) {
+            tstat_add(&ts->ticks[TSTAGE_GENERATE], t1 - t0);
+            tstat_add(&ts->ticks[TSTAGE_HASH], read_tsc() - t1);
+            tstat_add(&ts->sampled_batches, 1);
+        }
+        if (__builtin_expect(hit >= 0, 0)) {
+            uint64_t offset = (uint64_t)(hit / BATCH_SIZE) * st->chain_stride +
+                              (uint64_t)batch_num * BATCH_SIZE + hit % BATCH_SIZE;
+            *found_hi = hi;
+            *found_lo = lo;
+            key_step(found_hi, found_lo, offset);
+            if (!ring) return 1;
+            cand_push(ring, *found_hi, *found_lo);
+        }
+        if (g_sample_every && batch_num % g_sample_every == 0) {
+            if (__builtin_expect(!sample_check(st, hi, lo, batch_num, rng), 0)) {
+                atomic_store(&g_sample_failed, 1);
+                atomic_store(&g_found, 1);
+                return 0;
+            }
+            atomic_fetch_add_explicit(&g_samples, 1, memory_order_relaxed);
+        }
+
+        *local_count += (uint64_t)BATCH_SIZE * g_chains;
+        tstat_add(&ts->keys, (uint64_t)BATCH_SIZE * g_chains);
+        tstat_add(&ts->batches, g_chains);
+        if (slot) job_scanned(slot, batch_num);
+
+        if (__builtin_expect(*local_count >= 500000, 0)) {
+            atomic_fetch_add(&g_total_keys, *local_count);
+            *local_count = 0;
+        }
+    }
+    return 0;
+}
+
+typedef struct {
+    int thread_id;
+} thread_arg_t;
+
+static void *scanner_thread(void *arg) {
+    thread_arg_t *ta = (thread_arg_t *)arg;
+    int tid = ta->thread_id;
+    thread_stats_t *ts = &g_thread_stats[tid];
+
+    /* Pin first so the arenas below are faulted in on this thread's node */
+    int node = pin_worker(tid);
+    if (node >= 0)
+        t_step_table = node_step_table(node);
+
+    batch_state_t st;
+    if (!batch_state_init(&st)) {
+        fprintf(stderr, "Thread %d: malloc failed\n", tid);
+        atomic_fetch_sub(&g_workers_live, 1);
+        return NULL;
+    }
+
+    xorshift64_t rng;
+    rng.s = read_urandom_u64() ^ ((uint64_t)(tid + 1) * 6364136223846793005ULL);
+    if (rng.s == 0) rng.s = 1;
+
+    uint64_t local_count = 0;
+
+    /* Random starts begin runs of at least one work unit; chunks shorter
+     * than that (--batches) continue the run, so they cost no seek */
+    const uint64_t run_chunks = CHUNK_SIZE >= UNIT_KEYS ? 1 : (UNIT_KEYS + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    uint64_t hi = 0, lo = 0, run_hi = 0, run_lo = 0, run_left = 0;
+
+    steal_slot_t *slot = g_units_mode && g_slots ? &g_slots[tid] : NULL;
+    while (!atomic_load(&g_found)) {
+        /* Parked by the co-scheduler: between chunks, so no range is held.
+         * Once the units run out nothing would wake it, so it stops with
+         * the workers that are still finishing theirs */
+        if (tid >= atomic_load(&g_cpu_active)) {
+            if (atomic_load(&g_units_exhausted)) break;
+            usleep(COSCHED_PARK_US);
+            continue;
+        }
+        int job = -1;
+        unsigned first = 0;
+        if (slot) {
+            /* Help finish the units in flight before opening another */
+            job = job_steal(tid, slot, &first);
+            if (job < 0) {
+                uint64_t unit_seq, unit_lease;
+                if (!claim_unit(&unit_lease, &unit_seq, &hi, &lo)) break;
+                job = job_begin(slot, unit_lease, unit_seq, hi, lo);
+                if (job < 0) continue;
+                first = atomic_load(&g_jobs[job].front);
+            }
+            hi = g_jobs[job].hi;
+            lo = g_jobs[job].lo;
+        } else if (run_left) {
+            key_step(&hi, &lo, CHUNK_SIZE);
+        } else {
+            next_random_start(&rng, &hi, &lo);
+            run_hi = hi;
+            run_lo = lo;
+            run_left = run_chunks;
+        }
+
+        uint64_t found_hi, found_lo;
+        unsigned char h160[20];
+        scan_chunk(&st, hi, lo, (int)first, slot, &g_cand_rings[tid], ts, &local_count, &rng,
+                   &found_hi, &found_lo, h160);
+
+        if (local_count > 0) {
+            atomic_fetch_add(&g_total_keys, local_count);
+            local_count = 0;
+        }
+
+        /* A unit cut short by a stop request resumes from its front */
+        if (slot && !atomic_load(&g_found))
+            job_range_done(slot, job);
+        else if (!g_units_mode && !atomic_load(&g_found) && --run_left == 0 && g_ledger_path) {
+            uint64_t u = start_unit(run_hi, run_lo);
+            ledger_add(u, u + run_chunks * CHUNK_SIZE / UNIT_KEYS);
+        }
+    }
+
+    if (local_count > 0)
+        atomic_fetch_add(&g_total_keys, local_count);
+
+    batch_state_free(&st);
+    atomic_fetch_sub(&g_workers_live, 1);
+    return NULL;
+}
+
+/* ======================== Planted-Key Self-Test ======================== */
+
+/*
+ * --selftest: targets planted in short chunks -- at the first and last key,
+ * at batch and chain edges, in a chunk that crosses 2^64 and at both ends of
+ * the range -- must come back from scan_chunk, the workers' own loop, as the
+ * exact key, for every engine this CPU runs.  Two chunks follow on from the
+ * one before, so their seeks are giant steps.  Sampling (--sample) is on for
+ * every batch while it runs.
+ */
+#define SELFTEST_BATCHES 16   /* per chunk; a multiple of SIMD_CHAINS */
+
+static int planted_selftest(void) {
+    int saved_engine = g_engine, saved_chains = g_chains, saved_batches = NUM_BATCHES;
+    int saved_sample = g_sample_every;
+    target_set_t saved = g_targets;
+    const secp256k1_ge *saved_giant = g_giant_table;
+    size_t saved_giant_len = g_giant_len;
+    uint64_t saved_stride = g_giant_stride;
+    g_giant_table = NULL;
+    NUM_BATCHES = SELFTEST_BATCHES;
+    g_sample_every = 1;
+    const uint64_t chunk = CHUNK_SIZE, lane = chunk / SIMD_CHAINS;
+    /* run > 0: the chunk starts run chunks after the previous case's, along
+     * the --stride progression, so the scan reaches it by giant steps */
+    struct { uint64_t hi, lo, off, run; } cases[] = {
+        { 0x40, 0, 0, 0 },
+        { 0x4A, 0x0123456789ABC000ULL, (uint64_t)BATCH_SIZE - 1, 0 },
+        { 0x4B, 0x0123456789ABC000ULL, (uint64_t)BATCH_SIZE, 0 },
+        { 0x5C, 0xFEDCBA9876540000ULL, lane - 1, 0 },
+        { 0x5D, 0xFEDCBA9876540000ULL, lane, 0 },
+        { 0x6E, 0x0000000100000000ULL, chunk - 1, 0 },
+        { 0, 0, chunk - 1, 1 },
+        { 0, 0, (uint64_t)BATCH_SIZE + 5, 3 },
+        { 0x5A, 0ULL - (uint64_t)BATCH_SIZE - 3, (uint64_t)BATCH_SIZE + 5, 0 },
+        { 0x7F, 0ULL - chunk, chunk - 1, 0 }
+    };
+    enum { NCASES = sizeof(cases) / sizeof(cases[0]) };
+    uint64_t key_hi[NCASES], key_lo[NCASES];
+    for (int k = 1; k < NCASES; k++) {
+        if (!cases[k].run) continue;
+        cases[k].hi = cases[k-1].hi;
+        cases[k].lo = cases[k-1].lo;
+        key_step(&cases[k].hi, &cases[k].lo, cases[k].run * chunk);
+    }
+    unsigned char (*th)[20] = malloc(NCASES * 20);
+    target_set_t ts = {0};
+    int ok = th != NULL;
+    for (int k = 0; k < NCASES && ok; k++) {
+        secp256k1_scalar s;
+        secp256k1_gej pj;
+        secp256k1_ge pa;
+        unsigned char pub[33];
+        key_hi[k] = cases[k].hi;
+        key_lo[k] = cases[k].lo;
+        key_step(&key_hi[k], &key_lo[k], cases[k].off);
+        make_scalar(&s, key_hi[k], key_lo[k]);
+        secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &pj, &s);
+        secp256k1_ge_set_gej_var(&pa, &pj);
+        secp256k1_eckey_pubkey_serialize33(&pa, pub);
+        hash160(pub, th[k]);
+    }
+    /* target_set_build sorts its array, so keep the order in want */
+    unsigned char want[NCASES][20];
+    if (ok) memcpy(want, th, sizeof(want));
+    ok = ok && target_set_build(&ts, th, NCASES);
+    if (!ok) free(th);
+    g_targets = ts;
+
+    for (int e = 0; e < NUM_ENGINES && ok; e++) {
+        if (e == ENGINE_SIMD && !g_simd_ifma) {
+            printf("  Planted-key test (%s): skipped (no AVX-512 IFMA)\n", ENGINE_NAMES[e]);
+            continue;
+        }
+        g_engine = e;
+        g_chains = e == ENGINE_SIMD ? SIMD_CHAINS : 1;
+        batch_state_t st;
+        thread_stats_t tst;
+        xorshift64_t rng = { 0x9E3779B97F4A7C15ULL };
+        uint64_t count = 0, samples = atomic_load(&g_samples), jumps = atomic_load(&g_seeks[1]);
+        memset(&tst, 0, sizeof(tst));
+        ok = giant_table_init(chunk / g_chains) && batch_state_init(&st);
+        for (int k = 0; k < NCASES && ok; k++) {
+            uint64_t fh, fl;
+            unsigned char h[20];
+            ok = scan_chunk(&st, cases[k].hi, cases[k].lo, 0, NULL, NULL, &tst, &count, &rng, &fh, &fl, h) &&
+                 fh == key_hi[k] && fl == key_lo[k] && memcmp(h, want[k], 20) == 0;
+            if (!ok)
+                fprintf(stderr, "  planted key 0x%02llx%016llx (+%llu) missed\n",
+                        (unsigned long long)key_hi[k], (unsigned long long)key_lo[k],
+                        (unsigned long long)cases[k].off);
+        }
+        if (st.arena) batch_state_free(&st);
+        jumps = atomic_load(&g_seeks[1]) - jumps;
+        ok = ok && !atomic_load(&g_sample_failed) && jumps >= 2;
+        printf("  Planted-key test (%s): %s (%d keys, %llu batches sampled, %llu giant-step seeks)\n",
+               ENGINE_NAMES[e], ok ? "PASSED" : "FAILED", NCASES,
+               (unsigned long long)(atomic_load(&g_samples) - samples), (unsigned long long)jumps);
+    }
+
+    ptable_release(g_giant_table, g_giant_len);
+    g_giant_table = saved_giant;
+    g_giant_len = saved_giant_len;
+    g_giant_stride = saved_stride;
+    g_targets = saved;
+    target_set_free(&ts);
+    g_engine = saved_engine;
+    g_chains = saved_chains;
+    NUM_BATCHES = saved_batches;
+    g_sample_every = saved_sample;
+    return ok;
 }
 
-static void report_found(uint64_t hi, uint64_t lo) {
-    char keystr[64];
-    format_privkey(keystr, hi, lo);
+/* ======================== GPU Workers ======================== */
 
-    printf("\n");
-    printf("============================================================\n");
-    printf("  PUZZLE #71 KEY FOUND!\n");
-    printf("  Private Key: %s\n", keystr);
-    printf("============================================================\n");
-    fflush(stdout);
+#ifdef WITH_CUDA
+_Static_assert(GPU_THREADS_PER_UNIT * GPU_THREAD_KEYS == UNIT_KEYS,
+               "gpu_engine.h must split exactly one work unit");
 
-    FILE *f = fopen("/root/puzzle71/FOUND_KEY.txt", "w");
-    if (f) {
-        fprintf(f, "PUZZLE #71 SOLUTION\n");
-        fprintf(f, "Private Key: %s\n", keystr);
-        fprintf(f, "Target: 1PWo3JeB9jrGwfHDNpdGK54CRas7fsVzXU\n");
-        fprintf(f, "Hash160: f6f5431d25bbf7b12e8add9af5e3475c44a0a5b8\n");
-        time_t now = time(NULL);
-        fprintf(f, "Found: %s", ctime(&now));
-        unsigned long long total = atomic_load(&g_total_keys);
-        fprintf(f, "Total keys checked: %llu\n", total);
-        fclose(f);
+static gpu_point_t  g_gpu_step[GPU_STEP];
+static gpu_point_t *g_gpu_stride;
+
+static void gpu_point_from_ge(gpu_point_t *out, const secp256k1_ge *p) {
+    secp256k1_fe x = p->x, y = p->y;
+    unsigned char bx[32], by[32];
+    secp256k1_fe_normalize_var(&x);
+    secp256k1_fe_normalize_var(&y);
+    secp256k1_fe_get_b32(bx, &x);
+    secp256k1_fe_get_b32(by, &y);
+    for (int k = 0; k < 8; k++) {
+        const unsigned char *qx = bx + (7 - k) * 4, *qy = by + (7 - k) * 4;
+        out->x[k] = (uint32_t)qx[0] << 24 | (uint32_t)qx[1] << 16 | (uint32_t)qx[2] << 8 | qx[3];
+        out->y[k] = (uint32_t)qy[0] << 24 | (uint32_t)qy[1] << 16 | (uint32_t)qy[2] << 8 | qy[3];
     }
+}
 
-    atomic_store(&g_found, 1);
+/* (hi[i], lo[i]) * G in gpu_engine's layout for one launch, n <=
+ * GPU_UNITS_PER_LAUNCH, sharing one inversion */
+static void gpu_start_points(gpu_point_t *out, const uint64_t *hi, const uint64_t *lo, int n) {
+    secp256k1_scalar s;
+    secp256k1_gej pj[GPU_UNITS_PER_LAUNCH];
+    secp256k1_ge p[GPU_UNITS_PER_LAUNCH];
+    for (int i = 0; i < n; i++) {
+        make_scalar(&s, hi[i], lo[i]);
+        secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &pj[i], &s);
+    }
+    secp256k1_scalar_clear(&s);
+    secp256k1_ge_set_all_gej_var(p, pj, n);
+    for (int i = 0; i < n; i++)
+        gpu_point_from_ge(&out[i], &p[i]);
 }
 
-/* ======================== Worker Thread ======================== */
+/* Step table 1G..GPU_STEP*G (from g_step_table) and the per-thread
+ * strides i * GPU_THREAD_KEYS * G, one batch inversion */
+static int gpu_tables_init(void) {
+    for (int i = 0; i < GPU_STEP; i++)
+        gpu_point_from_ge(&g_gpu_step[i], &g_step_table[i]);
+    free(g_gpu_stride);
+    g_gpu_stride = calloc(GPU_THREADS_PER_UNIT, sizeof(gpu_point_t));
+    size_t len;
+    const secp256k1_ge *sa = ptable_get((uint64_t)GPU_THREAD_KEYS * g_key_stride,
+                                        GPU_THREADS_PER_UNIT - 1, &len);
+    if (!g_gpu_stride || !sa) {
+        ptable_release(sa, len);
+        return 0;
+    }
+    for (int i = 1; i < GPU_THREADS_PER_UNIT; i++)
+        gpu_point_from_ge(&g_gpu_stride[i], &sa[i - 1]);
+    ptable_release(sa, len);
+    return 1;
+}
 
-typedef struct {
-    int thread_id;
-} thread_arg_t;
+/* One unit from 2^70 + 0x10123456 with keys planted at a thread boundary
+ * crossing, inside a sub-batch and at the unit's last key */
+static int gpu_selftest(int device) {
+    static const uint32_t offs[3] = {
+        3 * GPU_THREAD_KEYS - 1, 7 * GPU_THREAD_KEYS + GPU_STEP + 5, UNIT_KEYS - 1
+    };
+    uint64_t hi = 0x40, lo = 0x10123456;
+    unsigned char (*th)[20] = malloc(3 * 20);
+    target_set_t ts = {0};
+    if (!th) return 0;
+    for (int i = 0; i < 3; i++)
+        candidate_verify(hi, lo + offs[i], th[i]);
+    if (!target_set_build(&ts, th, 3)) {
+        free(th);
+        return 0;
+    }
+    char name[128];
+    gpu_ctx_t *ctx = gpu_open(device, g_gpu_step, g_gpu_stride, ts.filter, ts.filter_mask,
+                              (const unsigned char (*)[20])ts.h160, ts.count, 1, name, sizeof(name));
+    int found[3] = {0}, ok = ctx != NULL;
+    if (ctx) {
+        gpu_point_t start;
+        gpu_hit_t hits[GPU_MAX_HITS];
+        gpu_start_points(&start, &hi, &lo, 1);
+        int n = gpu_scan(ctx, &start, 1, hits, GPU_MAX_HITS);
+        ok = n == 3;
+        for (int i = 0; i < n && ok; i++) {
+            int j = 0;
+            while (j < 3 && offs[j] != hits[i].offset) j++;
+            if (j == 3 || hits[i].unit != 0 || found[j]++) ok = 0;
+        }
+        gpu_close(ctx);
+        printf("  GPU %d: %s\n", device, name);
+    }
+    target_set_free(&ts);
+    return ok;
+}
 
-static void *scanner_thread(void *arg) {
+static void *gpu_thread(void *arg) {
     thread_arg_t *ta = (thread_arg_t *)arg;
     int tid = ta->thread_id;
+    int device = g_gpu_ids[tid - NUM_THREADS];
+    thread_stats_t *ts = &g_thread_stats[tid];
+    pin_worker(tid);
 
-    /* Allocate batch buffers */
-    secp256k1_gej *jac_batch = (secp256k1_gej *)malloc(sizeof(secp256k1_gej) * BATCH_SIZE);
-    secp256k1_ge  *aff_batch = (secp256k1_ge *)malloc(sizeof(secp256k1_ge) * BATCH_SIZE);
-    if (!jac_batch || !aff_batch) {
-        fprintf(stderr, "Thread %d: malloc failed\n", tid);
+    char name[128];
+    gpu_ctx_t *ctx = gpu_open(device, g_gpu_step, g_gpu_stride, g_targets.filter,
+                              g_targets.filter_mask, (const unsigned char (*)[20])g_targets.h160,
+                              g_targets.count, GPU_UNITS_PER_LAUNCH, name, sizeof(name));
+    if (!ctx) {
+        fprintf(stderr, "GPU %d: initialization failed, worker not started\n", device);
+        cosched_gpu_lost(tid - NUM_THREADS);
+        atomic_fetch_sub(&g_workers_live, 1);
         return NULL;
     }
 
-    unsigned char pub33[33];
-    unsigned char h160_buf[20];
-
     xorshift64_t rng;
     rng.s = read_urandom_u64() ^ ((uint64_t)(tid + 1) * 6364136223846793005ULL);
     if (rng.s == 0) rng.s = 1;
 
-    uint64_t local_count = 0;
+    gpu_point_t starts[GPU_UNITS_PER_LAUNCH];
+    gpu_hit_t hits[GPU_MAX_HITS];
+    uint64_t hi[GPU_UNITS_PER_LAUNCH], lo[GPU_UNITS_PER_LAUNCH];
+    uint64_t seq[GPU_UNITS_PER_LAUNCH], lease[GPU_UNITS_PER_LAUNCH];
 
     while (!atomic_load(&g_found)) {
-        uint64_t hi, lo;
-        random_start(&rng, &hi, &lo);
-
-        /* Full scalar multiplication for the starting point: P = privkey * G */
-        secp256k1_scalar privkey_scalar;
-        make_scalar(&privkey_scalar, hi, lo);
+        int n = 0;
+        while (n < GPU_UNITS_PER_LAUNCH && !atomic_load(&g_found)) {
+            if (g_units_mode) {
+                if (!claim_unit(&lease[n], &seq[n], &hi[n], &lo[n])) break;
+            } else {
+                next_random_start(&rng, &hi[n], &lo[n]);
+            }
+            n++;
+        }
+        if (n == 0) break;
+        gpu_start_points(starts, hi, lo, n);
+        tstat_add(&ts->starts, n);
 
-        secp256k1_gej current_jac;
-        secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &current_jac, &privkey_scalar);
-        secp256k1_scalar_clear(&privkey_scalar);
+        /* Claimed units that are not completed are rescanned after resume */
+        int nhits = gpu_scan(ctx, starts, n, hits, GPU_MAX_HITS);
+        if (nhits < 0) {
+            fprintf(stderr, "GPU %d: scan failed, worker stopped\n", device);
+            cosched_gpu_lost(tid - NUM_THREADS);
+            break;
+        }
+        /* Hits are confirmed on the CPU by the verifier thread */
+        for (int i = 0; i < nhits; i++) {
+            uint64_t u = hits[i].unit;
+            uint64_t found_hi = hi[u], found_lo = lo[u];
+            key_step(&found_hi, &found_lo, hits[i].offset);
+            cand_push(&g_cand_rings[tid], found_hi, found_lo);
+        }
 
-        /* Process NUM_BATCHES batches */
-        for (int batch_num = 0; batch_num < NUM_BATCHES && !atomic_load(&g_found); batch_num++) {
+        atomic_fetch_add(&g_total_keys, (uint64_t)n * UNIT_KEYS);
+        tstat_add(&ts->keys, (uint64_t)n * UNIT_KEYS);
+        tstat_add(&ts->batches, 1);
 
-            /* Step 1: Generate BATCH_SIZE sequential Jacobian points */
-            jac_batch[0] = current_jac;
-            for (int i = 1; i < BATCH_SIZE; i++) {
-                secp256k1_gej_add_ge_var(&jac_batch[i], &jac_batch[i-1], &g_gen_affine, NULL);
+        /* The launch ran to the end, so its units are done even after a stop */
+        for (int i = 0; i < n; i++) {
+            if (g_units_mode) {
+                complete_unit(lease[i], seq[i]);
+            } else if (g_ledger_path) {
+                uint64_t u = start_unit(hi[i], lo[i]);
+                ledger_add(u, u + 1);
             }
+        }
+    }
 
-            /* Step 2: Batch convert Jacobian -> Affine (1 field inversion for all!) */
-            secp256k1_ge_set_all_gej_var(aff_batch, jac_batch, BATCH_SIZE);
+    gpu_close(ctx);
+    atomic_fetch_sub(&g_workers_live, 1);
+    return NULL;
+}
+#endif /* WITH_CUDA */
 
-            /* Step 3: Serialize, hash, and check each point */
-            for (int i = 0; i < BATCH_SIZE; i++) {
-                /* Direct serialization to 33-byte compressed pubkey */
-                secp256k1_eckey_pubkey_serialize33(&aff_batch[i], pub33);
+/* ======================== Telemetry ======================== */
 
-                /* Hash160 = RIPEMD160(SHA256(pub33)) */
-                hash160(pub33, h160_buf);
+static double  *g_thread_rate;   /* per-thread keys/s over the last interval */
+static double   g_inst_rate, g_peak_rate;
+static atomic_int g_stats_ready = 0;
 
-                /* Fast 4-byte prefix check before full compare */
-                if (__builtin_expect(*(uint32_t*)h160_buf == TARGET_PREFIX, 0)) {
-                    if (memcmp(h160_buf, TARGET_H160, 20) == 0) {
-                        uint64_t offset = (uint64_t)batch_num * BATCH_SIZE + i;
-                        uint64_t found_lo = lo + offset;
-                        uint64_t found_hi = hi + (found_lo < lo ? 1 : 0);
-                        report_found(found_hi, found_lo);
-                        goto done;
-                    }
-                }
-            }
+/* Stats file: written like turbo_scanner.py's write_stats_atomic
+ * (temp file + rename, so readers never see a partial document) */
+static void write_stats(const char *status) {
+    char tmp[4096];
+    int cancel_state;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancel_state);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", g_stats_path);
+    FILE *f = fopen(tmp, "w");
+    if (!f) {
+        pthread_setcancelstate(cancel_state, NULL);
+        return;
+    }
+    double elapsed = get_time_sec() - g_start_time_d;
+    unsigned long long total = atomic_load(&g_total_keys);
+    char updated[32];
+    time_t now = time(NULL);
+    strftime(updated, sizeof(updated), "%Y-%m-%dT%H:%M:%S", localtime(&now));
 
-            /* Advance current_jac past this batch */
-            secp256k1_gej_add_ge_var(&current_jac, &jac_batch[BATCH_SIZE-1], &g_gen_affine, NULL);
+    double rmin = 0, rmax = 0;
+    for (int i = 0; i < NUM_THREADS; i++) {
+        if (i == 0 || g_thread_rate[i] < rmin) rmin = g_thread_rate[i];
+        if (i == 0 || g_thread_rate[i] > rmax) rmax = g_thread_rate[i];
+    }
+    fprintf(f, "{\"checked\": %llu, \"rate\": %.0f, \"avg\": %.0f, \"peak\": %.0f, "
+               "\"prob\": %.6e, \"uptime_s\": %d, \"workers\": %d, \"status\": \"%s\", "
+               "\"engine\": \"%s\", \"batch\": %d, \"thread_rate_min\": %.0f, "
+               "\"thread_rate_max\": %.0f, \"cpu_active\": %d, \"cpu_max\": %d, "
+               "\"governor\": \"%s\", \"power_w\": %.1f, \"energy_j\": %.0f, "
+               "\"keys_per_joule\": %.0f, \"threads\": [",
+            total, g_inst_rate, elapsed > 0 ? total / elapsed : 0, g_peak_rate,
+            (double)total / 1180591620717411303424.0, (int)elapsed, g_num_workers, status,
+            ENGINE_NAMES[g_engine], BATCH_SIZE, rmin, rmax,
+            atomic_load(&g_cpu_active), atomic_load(&g_cpu_max), GOV_NAMES[g_governor],
+            g_power_w, g_energy_j, g_power_w > 0 ? g_inst_rate / g_power_w : 0);
+    for (int i = 0; i < g_num_workers; i++) {
+        thread_stats_t *ts = &g_thread_stats[i];
+        unsigned long long sampled = atomic_load_explicit(&ts->sampled_batches, memory_order_relaxed);
+        fprintf(f, "%s{\"id\": %d, \"kind\": \"%s\", \"keys\": %llu, \"rate\": %.0f, "
+                   "\"batches\": %llu, \"starts\": %llu",
+                i ? ", " : "", i, i < NUM_THREADS ? "cpu" : "gpu",
+                (unsigned long long)atomic_load_explicit(&ts->keys, memory_order_relaxed),
+                g_thread_rate[i],
+                (unsigned long long)atomic_load_explicit(&ts->batches, memory_order_relaxed),
+                (unsigned long long)atomic_load_explicit(&ts->starts, memory_order_relaxed));
+        if (sampled) {
+            double div = (double)sampled * BATCH_SIZE;
+            fprintf(f, ", \"generate_cycles_per_key\": %.1f, \"hash_cycles_per_key\": %.1f",
+                    atomic_load_explicit(&ts->ticks[TSTAGE_GENERATE], memory_order_relaxed) / div,
+                    atomic_load_explicit(&ts->ticks[TSTAGE_HASH], memory_order_relaxed) / div);
+        }
+        fprintf(f, "}");
+    }
+    fprintf(f, "], \"updated\": \"%s\"}\n", updated);
+    int ok = (fclose(f) == 0);
+    if (!ok || rename(tmp, g_stats_path) != 0)
+        unlink(tmp);
+    pthread_setcancelstate(cancel_state, NULL);
+}
 
-            local_count += BATCH_SIZE;
+/* Prometheus text exposition of the same counters */
+static void write_metrics(FILE *m) {
+    static const char *TSTAGE_NAMES[NUM_TSTAGES] = { "generate", "hash" };
+    fprintf(m, "# HELP c_scanner_keys_total Keys checked.\n# TYPE c_scanner_keys_total counter\n");
+    for (int i = 0; i < g_num_workers; i++)
+        fprintf(m, "c_scanner_keys_total{thread=\"%d\"} %llu\n", i,
+                (unsigned long long)atomic_load_explicit(&g_thread_stats[i].keys, memory_order_relaxed));
+    fprintf(m, "# HELP c_scanner_batches_total Batches of BATCH_SIZE keys processed.\n"
+               "# TYPE c_scanner_batches_total counter\n");
+    for (int i = 0; i < g_num_workers; i++)
+        fprintf(m, "c_scanner_batches_total{thread=\"%d\"} %llu\n", i,
+                (unsigned long long)atomic_load_explicit(&g_thread_stats[i].batches, memory_order_relaxed));
+    fprintf(m, "# HELP c_scanner_starts_total Start points computed (full scalar multiplications).\n"
+               "# TYPE c_scanner_starts_total counter\n");
+    for (int i = 0; i < g_num_workers; i++)
+        fprintf(m, "c_scanner_starts_total{thread=\"%d\"} %llu\n", i,
+                (unsigned long long)atomic_load_explicit(&g_thread_stats[i].starts, memory_order_relaxed));
+    if (g_stage_timing) {
+        fprintf(m, "# HELP c_scanner_stage_cycles_total TSC cycles in sampled batches.\n"
+                   "# TYPE c_scanner_stage_cycles_total counter\n");
+        for (int i = 0; i < g_num_workers; i++)
+            for (int s = 0; s < NUM_TSTAGES; s++)
+                fprintf(m, "c_scanner_stage_cycles_total{thread=\"%d\",stage=\"%s\"} %llu\n", i, TSTAGE_NAMES[s],
+                        (unsigned long long)atomic_load_explicit(&g_thread_stats[i].ticks[s], memory_order_relaxed));
+        fprintf(m, "# HELP c_scanner_stage_sampled_keys_total Keys in sampled batches.\n"
+                   "# TYPE c_scanner_stage_sampled_keys_total counter\n");
+        for (int i = 0; i < g_num_workers; i++)
+            fprintf(m, "c_scanner_stage_sampled_keys_total{thread=\"%d\"} %llu\n", i,
+                    (unsigned long long)atomic_load_explicit(&g_thread_stats[i].sampled_batches,
+                                                             memory_order_relaxed) * BATCH_SIZE);
+    }
+    fprintf(m, "# HELP c_scanner_rate_keys_per_second Keys/s over the last stats interval.\n"
+               "# TYPE c_scanner_rate_keys_per_second gauge\n"
+               "c_scanner_rate_keys_per_second %.0f\n", g_inst_rate);
+    if (g_num_meters)
+        fprintf(m, "# HELP c_scanner_energy_joules_total Package energy (RAPL / hwmon) since the scan started.\n"
+                   "# TYPE c_scanner_energy_joules_total counter\n"
+                   "c_scanner_energy_joules_total %.1f\n"
+                   "# HELP c_scanner_power_watts Power over the last stats interval.\n"
+                   "# TYPE c_scanner_power_watts gauge\n"
+                   "c_scanner_power_watts %.1f\n", g_energy_j, g_power_w);
+    fprintf(m, "# HELP c_scanner_uptime_seconds Seconds since the scan started.\n"
+               "# TYPE c_scanner_uptime_seconds gauge\n"
+               "c_scanner_uptime_seconds %.1f\n", get_time_sec() - g_start_time_d);
+}
 
-            if (__builtin_expect(local_count >= 500000, 0)) {
-                atomic_fetch_add(&g_total_keys, local_count);
-                local_count = 0;
+static void *metrics_thread(void *arg) {
+    int lfd = (int)(intptr_t)arg;
+    for (;;) {
+        int fd = accept(lfd, NULL, NULL);
+        if (fd < 0) continue;
+        /* Any request path gets the metrics page */
+        struct timeval tv = { 1, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        char req[1024];
+        if (recv(fd, req, sizeof(req), 0) > 0 && atomic_load(&g_stats_ready)) {
+            char *body = NULL, hdr[192];
+            size_t len = 0;
+            FILE *m = open_memstream(&body, &len);
+            if (m) {
+                write_metrics(m);
+                fclose(m);
+                int hl = snprintf(hdr, sizeof(hdr),
+                                  "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                  "Content-Length: %zu\r\nConnection: close\r\n\r\n", len);
+                if (send(fd, hdr, hl, MSG_NOSIGNAL) == hl)
+                    for (size_t off = 0; off < len; ) {
+                        ssize_t w = send(fd, body + off, len - off, MSG_NOSIGNAL);
+                        if (w <= 0) break;
+                        off += (size_t)w;
+                    }
             }
+            free(body);
         }
+        close(fd);
+    }
+    return NULL;
+}
 
-        if (local_count > 0) {
-            atomic_fetch_add(&g_total_keys, local_count);
-            local_count = 0;
-        }
+/* Serve Prometheus text on 0.0.0.0:port from a detached thread */
+static int metrics_start(int port) {
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (lfd < 0) return 0;
+    int one = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_ANY);
+    sa.sin_port = htons((uint16_t)port);
+    if (bind(lfd, (struct sockaddr *)&sa, sizeof(sa)) != 0 || listen(lfd, 16) != 0) {
+        close(lfd);
+        return 0;
+    }
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, metrics_thread, (void *)(intptr_t)lfd) != 0) {
+        close(lfd);
+        return 0;
     }
+    pthread_detach(tid);
+    return 1;
+}
 
-done:
-    if (local_count > 0)
-        atomic_fetch_add(&g_total_keys, local_count);
+/*
+ * Co-scheduler step, run by the stats thread every interval.  GPU keys are
+ * counted when a launch finishes, so each GPU's rate is taken over the time
+ * since its count last moved; until every live GPU has finished a launch
+ * (or COSCHED_STALL intervals pass without one) there is nothing to judge.
+ */
+#define COSCHED_STALL 3
+static void cosched_tick(void) {
+    static int hold = 2, backoff = 1, probe = 0;
+    static double gpu_ref[MAX_GPUS], gpu_t[MAX_GPUS];
+    static unsigned long long gpu_k[MAX_GPUS];
+    double now = get_time_sec(), rate[MAX_GPUS];
+    int active = atomic_load(&g_cpu_active), cpu_max = atomic_load(&g_cpu_max);
+    int starved = 0, live = 0;
+    for (int g = 0; g < g_num_gpus; g++) {
+        unsigned long long k = atomic_load_explicit(&g_thread_stats[NUM_THREADS + g].keys,
+                                                    memory_order_relaxed);
+        if (atomic_load(&g_gpu_lost[g])) continue;
+        live++;
+        if (!gpu_t[g]) {
+            gpu_t[g] = now;
+            gpu_k[g] = k;
+            return;
+        }
+        if (k == gpu_k[g] && now - gpu_t[g] < COSCHED_STALL * STATS_INTERVAL - 1) return;
+        rate[g] = (double)(k - gpu_k[g]) / (now - gpu_t[g]);
+    }
+    if (!live) return;
+    for (int g = 0; g < g_num_gpus; g++) {
+        if (atomic_load(&g_gpu_lost[g])) continue;
+        gpu_k[g] = atomic_load_explicit(&g_thread_stats[NUM_THREADS + g].keys, memory_order_relaxed);
+        gpu_t[g] = now;
+        if (gpu_ref[g] > 0 && rate[g] < gpu_ref[g] * (100 - COSCHED_STARVE_PCT) / 100) starved = 1;
+        /* Recent level: follows rises at once, drifts down slowly */
+        gpu_ref[g] = rate[g] > gpu_ref[g] ? rate[g] : 0.75 * gpu_ref[g] + 0.25 * rate[g];
+    }
+    if (active > cpu_max) active = cpu_max;
 
-    free(jac_batch);
-    free(aff_batch);
-    return NULL;
+    if (starved) {
+        /* A failed probe takes back what it added; otherwise shed one */
+        active -= probe ? probe : active > 0;
+        if (probe) backoff = backoff * 2 > COSCHED_MAX_HOLD ? COSCHED_MAX_HOLD : backoff * 2;
+        probe = 0;
+        hold = backoff;
+    } else if (probe) {
+        probe = 0;
+        backoff = 1;
+        hold = 1;
+    } else if (hold > 0) {
+        hold--;
+    } else if (active < cpu_max) {
+        /* Halve the gap while probes succeed, single workers after a failure */
+        probe = backoff == 1 ? (cpu_max - active + 1) / 2 : 1;
+        active += probe;
+    }
+    atomic_store(&g_cpu_active, active);
 }
 
 /* ======================== Stats Thread ======================== */
@@ -293,6 +4249,7 @@ static void *stats_thread(void *arg) {
     (void)arg;
     unsigned long long prev_total = 0;
     double prev_time = get_time_sec();
+    unsigned long long *prev_keys = calloc(g_num_workers, sizeof(*prev_keys));
 
     while (!atomic_load(&g_found)) {
         sleep(STATS_INTERVAL);
@@ -304,14 +4261,49 @@ static void *stats_thread(void *arg) {
         unsigned long long total = atomic_load(&g_total_keys);
         double avg_rate = (elapsed > 0) ? (double)total / elapsed : 0;
         double inst_rate = (dt > 0) ? (double)(total - prev_total) / dt : 0;
+        g_inst_rate = inst_rate;
+        if (inst_rate > g_peak_rate) g_peak_rate = inst_rate;
+        for (int i = 0; i < g_num_workers && prev_keys; i++) {
+            unsigned long long k = atomic_load_explicit(&g_thread_stats[i].keys, memory_order_relaxed);
+            g_thread_rate[i] = (dt > 0) ? (double)(k - prev_keys[i]) / dt : 0;
+            prev_keys[i] = k;
+        }
+        double joules = energy_sample();
+        if (joules >= 0) {
+            g_energy_j += joules;
+            g_power_w = dt > 0 ? joules / dt : 0;
+        }
+        if (g_num_gpus && g_cosched) cosched_tick();
+        if (g_governor) governor_tick(g_power_w);
+        if (g_coord_addr && inst_rate > 0) {
+            double units = inst_rate * COORD_LEASE_SECS / UNIT_KEYS;
+            int floor_units = NUM_THREADS * 8 + g_num_gpus * 2 * GPU_UNITS_PER_LAUNCH;
+            atomic_store(&g_coord_lease_auto, units < floor_units ? floor_units :
+                                              units > COORD_LEASE_MAX ? COORD_LEASE_MAX : (int)units);
+        }
+        write_stats("running");
 
-        printf("[%7.1fs] Checked: %14llu | Avg: %8.2f Mk/s | Now: %8.2f Mk/s\n",
+        printf("[%7.1fs] Checked: %14llu | Avg: %8.2f Mk/s | Now: %8.2f Mk/s",
                elapsed, total, avg_rate / 1e6, inst_rate / 1e6);
+        if (g_coord_addr) {
+            printf(" | Lease #%llu", (unsigned long long)g_lease_id);
+        } else if (g_units_mode) {
+            printf(" | Units done: %llu", (unsigned long long)atomic_load(&g_unit_done_below));
+            write_checkpoint();
+        }
+        if ((g_num_gpus && NUM_THREADS) || g_governor)
+            printf(" | CPU workers %d/%d", atomic_load(&g_cpu_active), atomic_load(&g_cpu_max));
+        if (g_power_w > 0)
+            printf(" | %.1f W, %.4f Mk/J", g_power_w, inst_rate / g_power_w / 1e6);
+        printf("\n");
         fflush(stdout);
+        if (g_coord_addr)
+            coord_heartbeat(total, inst_rate);
 
         prev_total = total;
         prev_time = now;
     }
+    free(prev_keys);
     return NULL;
 }
 
@@ -325,6 +4317,8 @@ static void signal_handler(int sig) {
 
 /* ======================== Initialization ======================== */
 
+static int step_tables_fill(void);
+
 static int init_secp256k1(void) {
     /* Initialize ecmult_gen context (precomputed tables for k*G) */
     secp256k1_ecmult_gen_context_build(&g_ecmult_gen_ctx);
@@ -337,42 +4331,622 @@ static int init_secp256k1(void) {
     secp256k1_ge_set_gej_var(&g_gen_affine, &gj);
     secp256k1_scalar_clear(&one);
 
+    if (g_simd_ifma) {
+        g_simd_step = (simd_step_t *)arena_alloc(sizeof(simd_step_t) * g_step_table_size, &g_simd_step_len);
+        if (!g_simd_step) return 0;
+    }
+    return step_tables_fill();
+}
+
+/* The affine step table, 1..n times g_key_stride * G, and its limb copy
+ * for the simd engine's broadcasts */
+static int step_tables_fill(void) {
+    int n = g_step_table_size;
+    ptable_release(g_step_table, g_step_table_len);
+    g_step_table = ptable_get(g_key_stride, n, &g_step_table_len);
+    if (!g_step_table) return 0;
+
+    if (g_simd_step) {
+        for (int i = 0; i < n; i++) {
+            secp256k1_fe x = g_step_table[i].x, y = g_step_table[i].y;
+            secp256k1_fe_normalize_var(&x);
+            secp256k1_fe_normalize_var(&y);
+            memcpy(g_simd_step[i].x, x.n, sizeof(g_simd_step[i].x));
+            memcpy(g_simd_step[i].y, y.n, sizeof(g_simd_step[i].y));
+        }
+    }
+
     return 1;
 }
 
 static void cleanup_secp256k1(void) {
     secp256k1_ecmult_gen_context_clear(&g_ecmult_gen_ctx);
+    ptable_release(g_giant_table, g_giant_len);
+    g_giant_table = NULL;
+    ptable_release(g_step_table, g_step_table_len);
+    g_step_table = NULL;
+    arena_free(g_simd_step, g_simd_step_len);
+    for (int i = 0; i < MAX_NODES; i++)
+        arena_free((void *)g_node_step_table[i], g_node_step_len[i]);
+}
+
+/* ======================== Engine Library ======================== */
+
+#ifdef SCANNER_LIBRARY
+/* scanner_engine.h on top of the scan pipeline.  Every scan thread keeps
+ * its batch_state_t from init to shutdown; a scan call hands out
+ * LIB_SEGMENT_BATCHES-batch segments of the range through one atomic
+ * counter, so there is no allocation or copy per batch or per call. */
+#define LIB_SEGMENT_BATCHES 256
+#define LIB_EXPORT __attribute__((visibility("default")))
+
+static int             g_lib_ready = 0;
+static batch_state_t  *g_lib_states;
+static atomic_int      g_lib_stop;
+static atomic_ullong   g_lib_next;          /* next unclaimed offset in the scan */
+static atomic_ullong   g_lib_matches, g_lib_scans;
+static pthread_mutex_t g_lib_cb_lock = PTHREAD_MUTEX_INITIALIZER;
+static char            g_lib_info[160];
+
+typedef struct {
+    int              tid;
+    uint64_t         hi, lo, count;
+    scanner_match_fn fn;
+    void            *user;
+    uint64_t         checked;
+} lib_scan_t;
+
+static void *lib_scan_thread(void *arg) {
+    lib_scan_t *sc = (lib_scan_t *)arg;
+    batch_state_t *st = &g_lib_states[sc->tid];
+    const uint64_t seg = (uint64_t)BATCH_SIZE * LIB_SEGMENT_BATCHES * g_chains;
+    st->chain_stride = seg / g_chains;
+
+    while (!atomic_load(&g_lib_stop)) {
+        uint64_t off = atomic_fetch_add(&g_lib_next, seg);
+        if (off >= sc->count) break;
+        uint64_t seg_lo = sc->lo + off;
+        uint64_t seg_hi = sc->hi + (seg_lo < sc->lo ? 1 : 0);
+        uint64_t n = sc->count - off < seg ? sc->count - off : seg;
+
+        batch_seek(st, seg_hi, seg_lo);
+        for (uint64_t done = 0; done < st->chain_stride && !atomic_load(&g_lib_stop); done += BATCH_SIZE) {
+            /* Chain c covers [c * chain_stride, (c + 1) * chain_stride) of
+             * the segment; keys past the range end in it are ignored */
+            uint64_t keys = 0;
+            for (int c = 0; c < g_chains; c++) {
+                uint64_t first = c * st->chain_stride + done;
+                if (first < n) keys += n - first < (uint64_t)BATCH_SIZE ? n - first : (uint64_t)BATCH_SIZE;
+            }
+            if (!keys) break;
+            unsigned char h160[20];
+            int hit = batch_scan(st, h160);
+            uint64_t hit_off = hit < 0 ? 0 : (uint64_t)(hit / BATCH_SIZE) * st->chain_stride + done + hit % BATCH_SIZE;
+            if (__builtin_expect(hit >= 0, 0) && hit_off < n && sc->fn) {
+                uint64_t found_lo = seg_lo + hit_off;
+                uint64_t found_hi = seg_hi + (found_lo < seg_lo ? 1 : 0);
+                pthread_mutex_lock(&g_lib_cb_lock);
+                sc->fn(sc->user, found_hi, found_lo, h160);
+                pthread_mutex_unlock(&g_lib_cb_lock);
+                atomic_fetch_add(&g_lib_matches, 1);
+            }
+            sc->checked += keys;
+            atomic_fetch_add_explicit(&g_total_keys, keys, memory_order_relaxed);
+        }
+    }
+    return NULL;
+}
+
+LIB_EXPORT int scanner_engine_init(int threads, int batch, const char *engine, const char *isa) {
+    if (g_lib_ready) return -1;
+    int isa_id = HASH160_ISA_AUTO;
+    if (isa && strcmp(isa, "auto")) {
+        for (isa_id = HASH160_ISA_SCALAR; isa_id < HASH160_ISA_AUTO; isa_id++)
+            if (!strcmp(isa, HASH160_ISA_NAMES[isa_id])) break;
+        if (isa_id == HASH160_ISA_AUTO) return -1;
+    }
+    if (engine) {
+        g_engine = -1;
+        for (int i = 0; i < NUM_ENGINES; i++)
+            if (!strcmp(engine, ENGINE_NAMES[i])) g_engine = i;
+        if (g_engine < 0) {
+            g_engine = ENGINE_AFFINE;
+            return -1;
+        }
+    }
+    if (batch) {
+        if (batch < MIN_BATCH_SIZE || batch > MAX_BATCH_SIZE || (batch & (batch - 1))) return -1;
+        BATCH_SIZE = batch;
+    }
+    NUM_THREADS = threads < 1 ? 1 : threads > 256 ? 256 : threads;
+
+    const char *sha_impl = sha256_rmd160_init(-1);
+    if (!sha_impl || !hash160_select(isa_id)) return -1;
+#if FIELD_DISPATCH
+    __builtin_cpu_init();
+    g_field_bmi2 = isa_id != HASH160_ISA_SCALAR && __builtin_cpu_supports("bmi2");
+#endif
+#if SIMD_FIELD
+    g_simd_ifma = __builtin_cpu_supports("avx512ifma");
+#endif
+    if (g_engine == ENGINE_SIMD) {
+        if (!g_simd_ifma) {
+            g_engine = ENGINE_AFFINE;
+            return -1;
+        }
+        g_chains = SIMD_CHAINS;
+    }
+    select_batch_check();
+    snprintf(g_lib_info, sizeof(g_lib_info), "%s engine | hash %s (SHA256 %s) | field %s",
+             ENGINE_NAMES[g_engine], hash160_kernel_name(), sha_impl,
+             g_field_bmi2 ? "BMI2 (mulx)" : "generic");
+
+    if (!g_targets.count) {
+        unsigned char (*one)[20] = malloc(20);
+        if (!one) return -1;
+        memcpy(one[0], TARGET_H160, 20);
+        if (!target_set_build(&g_targets, one, 1)) return -1;
+    }
+    g_step_table_size = BATCH_SIZE;
+    if (!init_secp256k1()) return -1;
+    /* Segments handed to a thread are usually a few segments apart */
+    if (!giant_table_init((uint64_t)BATCH_SIZE * LIB_SEGMENT_BATCHES)) {
+        cleanup_secp256k1();
+        return -1;
+    }
+
+    /* Same known-answer check as c_scanner's startup: hash160(G) */
+    static const unsigned char expected[20] = {
+        0x75,0x1e,0x76,0xe8,0x19,0x91,0x96,0xd4,0x54,0x94,
+        0x1c,0x45,0xd1,0xb3,0xa3,0x23,0xf1,0x43,0x3b,0xd6
+    };
+    unsigned char gs[33], gh[20];
+    secp256k1_eckey_pubkey_serialize33(&g_gen_affine, gs);
+    hash160(gs, gh);
+    g_lib_states = calloc(NUM_THREADS, sizeof(batch_state_t));
+    int ok = memcmp(gh, expected, 20) == 0 && g_lib_states;
+    for (int i = 0; i < NUM_THREADS && ok; i++)
+        ok = batch_state_init(&g_lib_states[i]);
+    if (!ok) {
+        for (int i = 0; g_lib_states && i < NUM_THREADS; i++)
+            batch_state_free(&g_lib_states[i]);
+        free(g_lib_states);
+        g_lib_states = NULL;
+        cleanup_secp256k1();
+        return -1;
+    }
+    g_lib_ready = 1;
+    return 0;
+}
+
+LIB_EXPORT int scanner_engine_set_targets(const unsigned char *h160, size_t n) {
+    if (n == 0) return -1;
+    unsigned char (*copy)[20] = malloc(n * 20);
+    if (!copy) return -1;
+    memcpy(copy, h160, n * 20);
+    target_set_t ts = {0};
+    if (!target_set_build(&ts, copy, n)) {
+        free(copy);
+        return -1;
+    }
+    target_set_free(&g_targets);
+    g_targets = ts;
+    return 0;
 }
 
+LIB_EXPORT int64_t scanner_engine_scan(uint64_t hi, uint64_t lo, uint64_t count,
+                                       scanner_match_fn fn, void *user) {
+    if (!g_lib_ready) return -1;
+    pthread_t tids[256];
+    lib_scan_t sc[256];
+    atomic_store(&g_lib_stop, 0);
+    atomic_store(&g_lib_next, 0);
+    int started = 0;
+    for (int i = 0; i < NUM_THREADS; i++) {
+        sc[i] = (lib_scan_t){ .tid = i, .hi = hi, .lo = lo, .count = count, .fn = fn, .user = user };
+        if (pthread_create(&tids[i], NULL, lib_scan_thread, &sc[i]) != 0) break;
+        started++;
+    }
+    int64_t checked = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+        checked += (int64_t)sc[i].checked;
+    }
+    if (!started) return -1;
+    atomic_fetch_add(&g_lib_scans, 1);
+    return checked;
+}
+
+LIB_EXPORT void scanner_engine_stop(void) {
+    atomic_store(&g_lib_stop, 1);
+}
+
+LIB_EXPORT void scanner_engine_counters(scanner_counters_t *out) {
+    out->keys = atomic_load(&g_total_keys);
+    out->matches = atomic_load(&g_lib_matches);
+    out->scans = atomic_load(&g_lib_scans);
+    out->threads = NUM_THREADS;
+    out->batch = BATCH_SIZE;
+}
+
+LIB_EXPORT const char *scanner_engine_info(void) {
+    return g_lib_info;
+}
+
+LIB_EXPORT void scanner_engine_shutdown(void) {
+    if (!g_lib_ready) return;
+    for (int i = 0; i < NUM_THREADS; i++)
+        batch_state_free(&g_lib_states[i]);
+    free(g_lib_states);
+    g_lib_states = NULL;
+    cleanup_secp256k1();
+    target_set_free(&g_targets);
+    g_lib_ready = 0;
+}
+#endif /* SCANNER_LIBRARY */
+
 /* ======================== Main ======================== */
 
+#ifndef SCANNER_LIBRARY
 int main(int argc, char *argv[]) {
-    memcpy(&TARGET_PREFIX, TARGET_H160, 4);
-
     printf("============================================================\n");
     printf("  Bitcoin Puzzle #71 Scanner v4 - BATCH INVERSION MODE\n");
     printf("  Target: 1PWo3JeB9jrGwfHDNpdGK54CRas7fsVzXU\n");
     printf("  Hash160: f6f5431d25bbf7b12e8add9af5e3475c44a0a5b8\n");
     printf("  Range: 0x400000000000000000 - 0x7FFFFFFFFFFFFFFFFF\n");
-    printf("  Batch: %d pts | %d batches/chunk | %llu keys/chunk\n",
-           BATCH_SIZE, NUM_BATCHES, (unsigned long long)CHUNK_SIZE);
     printf("============================================================\n");
 
-    if (argc > 1) {
-        NUM_THREADS = atoi(argv[1]);
+    static const struct option long_opts[] = {
+        { "engine",     required_argument, NULL, 'e' },
+        { "units",      no_argument,       NULL, 'u' },
+        { "checkpoint", required_argument, NULL, 'c' },
+        { "seed",       required_argument, NULL, 's' },
+        { "coordinator", required_argument, NULL, 'C' },
+        { "node",       required_argument, NULL, 'n' },
+        { "lease",      required_argument, NULL, 'l' },
+        { "targets",    required_argument, NULL, 't' },
+        { "batch",      required_argument, NULL, 'b' },
+        { "batches",    required_argument, NULL, 'B' },
+        { "autotune",   no_argument,       NULL, 'a' },
+        { "bench",      optional_argument, NULL, 'x' },
+        { "stats",      required_argument, NULL, 'S' },
+        { "stage-timing", no_argument,     NULL, 'T' },
+        { "metrics-port", required_argument, NULL, 'P' },
+        { "pin",        required_argument, NULL, 'p' },
+        { "isa",        required_argument, NULL, 'i' },
+        { "sha",        required_argument, NULL, 'H' },
+        { "gpu",        required_argument, NULL, 'g' },
+        { "selftest",   no_argument,       NULL, 'Z' },
+        { "sample",     required_argument, NULL, 'm' },
+        { "ledger",     optional_argument, NULL, 'L' },
+        { "stride",     required_argument, NULL, 'D' },
+        { "gpu-cores",  required_argument, NULL, 'G' },
+        { "no-cosched", no_argument,       NULL, 'Q' },
+        { "table-cache", required_argument, NULL, 'K' },
+        { "governor",   optional_argument, NULL, 'O' },
+        { "power-cap",  required_argument, NULL, 'W' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt, seed_given = 0, autotune = 0, selftest = 0, batch_given = 0, engine_given = 0;
+    unsigned long long stride_residue = 0, stride_n = 1;
+    int isa = HASH160_ISA_AUTO, sha_mode = -1;
+    const char *bench_path = NULL;
+    while ((opt = getopt_long(argc, argv, "e:uc:s:C:n:l:t:b:B:aS:TP:p:i:H:g:Zm:L::D:G:QK:O::W:", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'e':
+            g_engine = -1;
+            for (int i = 0; i < NUM_ENGINES; i++)
+                if (strcmp(optarg, ENGINE_NAMES[i]) == 0) g_engine = i;
+            if (g_engine < 0) {
+                fprintf(stderr, "Unknown engine '%s'\n", optarg);
+                return 1;
+            }
+            engine_given = 1;
+            break;
+        case 'u':
+            g_units_mode = 1;
+            break;
+        case 'c':
+            g_units_mode = 1;
+            g_checkpoint_path = optarg;
+            break;
+        case 's':
+            g_unit_seed = strtoull(optarg, NULL, 16);
+            seed_given = 1;
+            break;
+        case 'C':
+            g_units_mode = 1;
+            g_coord_addr = optarg;
+            break;
+        case 'n':
+            snprintf(g_node_name, sizeof(g_node_name), "%s", optarg);
+            break;
+        case 'l':
+            g_coord_lease_units = atoi(optarg);
+            if (g_coord_lease_units < 1) g_coord_lease_units = 1;
+            break;
+        case 't':
+            g_targets_path = optarg;
+            break;
+        case 'b':
+            BATCH_SIZE = atoi(optarg);
+            batch_given = 1;
+            if (BATCH_SIZE < MIN_BATCH_SIZE || BATCH_SIZE > MAX_BATCH_SIZE ||
+                (BATCH_SIZE & (BATCH_SIZE - 1))) {
+                fprintf(stderr, "--batch must be a power of two in %d..%d\n",
+                        MIN_BATCH_SIZE, MAX_BATCH_SIZE);
+                return 1;
+            }
+            break;
+        case 'B':
+            NUM_BATCHES = atoi(optarg);
+            if (NUM_BATCHES < 1) NUM_BATCHES = 1;
+            break;
+        case 'a':
+            autotune = 1;
+            break;
+        case 'Z':
+            selftest = 1;
+            break;
+        case 'm':
+            g_sample_every = atoi(optarg);
+            if (g_sample_every < 1) {
+                fprintf(stderr, "--sample needs N >= 1\n");
+                return 1;
+            }
+            break;
+        case 'L':
+            g_ledger_path = optarg ? optarg : LEDGER_FILE;
+            break;
+        case 'G':
+            g_gpu_cores = atoi(optarg);
+            if (g_gpu_cores < 0) g_gpu_cores = 0;
+            break;
+        case 'Q':
+            g_cosched = 0;
+            break;
+        case 'K':
+            g_table_dir = strcmp(optarg, "off") ? optarg : NULL;
+            break;
+        case 'O':
+            if (!optarg || !strcmp(optarg, "energy")) g_governor = GOV_ENERGY;
+            else if (!strcmp(optarg, "rate")) g_governor = GOV_RATE;
+            else {
+                fprintf(stderr, "Unknown --governor '%s' (rate, energy)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'W':
+            g_power_cap = atof(optarg);
+            if (g_power_cap <= 0) {
+                fprintf(stderr, "--power-cap needs watts > 0\n");
+                return 1;
+            }
+            if (!g_governor) g_governor = GOV_RATE;
+            break;
+        case 'D':
+            if (sscanf(optarg, "%llu/%llu", &stride_residue, &stride_n) != 2 ||
+                stride_n < 1 || stride_n > 0xFFFFFFFFULL || stride_residue >= stride_n) {
+                fprintf(stderr, "--stride needs I/N with 0 <= I < N <= 2^32-1\n");
+                return 1;
+            }
+            break;
+        case 'x':
+            bench_path = optarg ? optarg : BENCH_FILE;
+            break;
+        case 'S':
+            g_stats_path = optarg;
+            break;
+        case 'T':
+            g_stage_timing = 1;
+            break;
+        case 'P':
+            g_metrics_port = atoi(optarg);
+            break;
+        case 'i':
+            for (isa = HASH160_ISA_SCALAR; isa < HASH160_ISA_AUTO; isa++)
+                if (!strcmp(optarg, HASH160_ISA_NAMES[isa])) break;
+            if (isa == HASH160_ISA_AUTO && strcmp(optarg, "auto")) {
+                fprintf(stderr, "Unknown --isa '%s' (auto, scalar, avx2, avx512)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'H':
+            if (!strcmp(optarg, "auto")) sha_mode = -1;
+            else if (!strcmp(optarg, "generic")) sha_mode = 0;
+            else if (!strcmp(optarg, "shani")) sha_mode = 1;
+            else {
+                fprintf(stderr, "Unknown --sha '%s' (auto, shani, generic)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'p':
+            if (!strcmp(optarg, "core")) g_pin_mode = PIN_CORE;
+            else if (!strcmp(optarg, "smt")) g_pin_mode = PIN_SMT;
+            else if (!strcmp(optarg, "none")) g_pin_mode = PIN_NONE;
+            else {
+                fprintf(stderr, "Unknown --pin '%s' (core, smt, none)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'g': {
+#ifdef WITH_CUDA
+            char *tok, *save = NULL;
+            g_num_gpus = 0;
+            for (tok = strtok_r(optarg, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+                if (g_num_gpus == MAX_GPUS || !isdigit((unsigned char)tok[0])) {
+                    fprintf(stderr, "--gpu takes up to %d device ids, e.g. --gpu=0,1\n", MAX_GPUS);
+                    return 1;
+                }
+                g_gpu_ids[g_num_gpus++] = atoi(tok);
+            }
+#else
+            fprintf(stderr, "--gpu: this build has no GPU backend (compile with -DWITH_CUDA)\n");
+            return 1;
+#endif
+            break;
+        }
+        default:
+            fprintf(stderr, "Usage: %s [threads] [--engine=affine|center|fused|jacobian|simd]\n"
+                            "          [--units] [--checkpoint=FILE] [--seed=HEX]\n"
+                            "          [--coordinator=HOST:PORT] [--node=NAME] [--lease=UNITS]\n"
+                            "          [--targets=FILE] [--batch=N] [--batches=N] [--autotune]\n"
+                            "          [--bench[=FILE]] [--stats=FILE] [--stage-timing]\n"
+                            "          [--metrics-port=PORT] [--pin=core|smt]\n"
+                            "          [--isa=auto|scalar|avx2|avx512] [--sha=auto|shani|generic]\n"
+                            "          [--gpu=ID[,ID...]] [--selftest] [--sample=N]\n"
+                            "          [--ledger[=FILE]] [--stride=I/N] [--gpu-cores=N] [--no-cosched]\n"
+                            "          [--table-cache=DIR|off] [--governor[=rate|energy]] [--power-cap=W]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (stride_n > 1) {
+        /* Ledger runs and coordinator leases are unit ranges of the full
+         * keyspace; a strided node only ever covers 1/N of each */
+        if (g_ledger_path || g_coord_addr) {
+            fprintf(stderr, "--stride splits the range without a coordinator or ledger; drop %s\n",
+                    g_ledger_path ? "--ledger" : "--coordinator");
+            return 1;
+        }
+        unsigned __int128 count = (((unsigned __int128)1 << 70) - stride_residue + stride_n - 1) / stride_n;
+        g_stride_units = (uint64_t)((count + UNIT_KEYS - 1) / UNIT_KEYS);
+    }
+
+    if (optind < argc) {
+        NUM_THREADS = atoi(argv[optind]);
         if (NUM_THREADS < 1) NUM_THREADS = 1;
         if (NUM_THREADS > 256) NUM_THREADS = 256;
     }
     printf("  Threads: %d\n", NUM_THREADS);
+    detect_topology();
+    {
+        int cores = 0, pkgs = 0, nodes = 0;
+        for (int i = 0; i < g_num_cpus; i++) {
+            if (g_cpus[i].smt == 0) cores++;
+            if (g_cpus[i].pkg + 1 > pkgs) pkgs = g_cpus[i].pkg + 1;
+            if (g_cpus[i].node + 1 > nodes) nodes = g_cpus[i].node + 1;
+        }
+        printf("  Topology: %d CPUs, %d cores, %d package%s, %d NUMA node%s | pin: %s\n",
+               g_num_cpus, cores, pkgs, pkgs == 1 ? "" : "s", nodes, nodes == 1 ? "" : "s",
+               g_pin_mode == PIN_CORE ? "core" : g_pin_mode == PIN_SMT ? "smt" : "none");
+    }
+    printf("  Engine: %s\n", ENGINE_NAMES[g_engine]);
+
+    if (g_targets_path) {
+        if (!target_set_load(&g_targets, g_targets_path)) return 1;
+    } else {
+        unsigned char (*one)[20] = malloc(20);
+        if (!one) return 1;
+        memcpy(one[0], TARGET_H160, 20);
+        if (!target_set_build(&g_targets, one, 1)) return 1;
+    }
+    printf("  Targets: %zu%s%s | filter %d KB\n", g_targets.count,
+           g_targets_path ? " from " : " (puzzle #71)",
+           g_targets_path ? g_targets_path : "", (1 << g_targets.filter_bits) / 8192);
+
+    if (g_coord_addr) {
+        if (!g_node_name[0] && gethostname(g_node_name, sizeof(g_node_name) - 1) != 0)
+            snprintf(g_node_name, sizeof(g_node_name), "node-%d", (int)getpid());
+        pthread_mutex_lock(&g_coord_lock);
+        int connected = coord_connect();
+        pthread_mutex_unlock(&g_coord_lock);
+        if (!connected) return 1;
+        printf("  Coordinator: %s as '%s' | seed 0x%016llx\n",
+               g_coord_addr, g_node_name, (unsigned long long)g_unit_seed);
+    } else if (g_units_mode) {
+        if (!seed_given) g_unit_seed = read_urandom_u64();
+        if (!load_checkpoint(seed_given, stride_residue, stride_n)) return 1;
+        unsigned ahead = 0;
+        for (int i = 0; i < UNIT_WINDOW; i++) ahead += atomic_load(&g_unit_done[i]);
+        printf("  Work units: %llu x %llu keys | seed 0x%016llx\n",
+               (unsigned long long)g_stride_units, (unsigned long long)UNIT_KEYS,
+               (unsigned long long)g_unit_seed);
+        printf("  Checkpoint: %s (resuming at unit #%llu, %u done ahead, %d mid-unit)\n",
+               g_checkpoint_path, (unsigned long long)atomic_load(&g_unit_done_below), ahead,
+               g_unit_nresume);
+    } else {
+        printf("  Starts: random %schunks\n", g_ledger_path ? "unit-aligned " : "");
+    }
+    if (g_ledger_path) {
+        if (!ledger_open()) return 1;
+        printf("  Ledger: %s (%llu units covered, %zu + %zu runs)\n", g_ledger_path,
+               (unsigned long long)ledger_units(), g_ledger_nsorted, g_ledger_ntail);
+    }
 
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
+    /* Kernels for this CPU: every variant is in the binary, CPUID decides */
+    const char *sha_impl = sha256_rmd160_init(sha_mode);
+    if (!sha_impl) {
+        fprintf(stderr, "FATAL: --sha=shani but this CPU has no SHA extensions\n");
+        return 1;
+    }
+    if (!hash160_select(isa)) {
+        fprintf(stderr, "FATAL: --isa=%s is not supported by this CPU\n", HASH160_ISA_NAMES[isa]);
+        return 1;
+    }
+#if FIELD_DISPATCH
+    __builtin_cpu_init();
+    g_field_bmi2 = isa != HASH160_ISA_SCALAR && __builtin_cpu_supports("bmi2");
+#endif
+#if SIMD_FIELD
+    g_simd_ifma = __builtin_cpu_supports("avx512ifma");
+#endif
+    if (g_engine == ENGINE_SIMD) {
+        if (!g_simd_ifma) {
+            fprintf(stderr, "FATAL: --engine=simd needs AVX-512 IFMA\n");
+            return 1;
+        }
+        g_chains = SIMD_CHAINS;
+    }
+    select_batch_check();
+    printf("  Hash kernel: %s (SHA256 single-block: %s)%s\n", hash160_kernel_name(), sha_impl,
+           isa == HASH160_ISA_AUTO && sha_mode < 0 ? "" : " [forced]");
+    printf("  Field code: %s%s\n", g_field_bmi2 ? "BMI2 (mulx)" : "generic",
+           g_chains > 1 ? " + AVX-512 IFMA x8 chains" : "");
+
     printf("  Initializing secp256k1 internals...\n");
+    g_step_table_size = BATCH_SIZE;
+    if (autotune && g_step_table_size < AUTOTUNE_MAX_BATCH) g_step_table_size = AUTOTUNE_MAX_BATCH;
+    if (bench_path && g_step_table_size < BENCH_MAX_BATCH) g_step_table_size = BENCH_MAX_BATCH;
     if (!init_secp256k1()) {
         fprintf(stderr, "FATAL: Failed to initialize secp256k1\n");
         return 1;
     }
+    if (autotune)
+        autotune_batch_size();
+
+    /* Work units are fixed at UNIT_KEYS keys, whatever the batch size */
+    if (g_units_mode) {
+        if (NUM_BATCHES && CHUNK_SIZE != UNIT_KEYS)
+            fprintf(stderr, "  --batches ignored: work units are %llu keys\n",
+                    (unsigned long long)UNIT_KEYS);
+        NUM_BATCHES = (int)(UNIT_KEYS / BATCH_SIZE);
+    } else if (!NUM_BATCHES) {
+        NUM_BATCHES = (int)(UNIT_KEYS / BATCH_SIZE);
+    }
+    if (energy_init())
+        printf("  Energy: %s, %d meter%s\n", g_meter_kind, g_num_meters, g_num_meters == 1 ? "" : "s");
+    if (g_governor && (g_num_gpus || selftest || bench_path)) {
+        /* The co-scheduler owns the CPU pool next to GPUs */
+        fprintf(stderr, "  --governor ignored with %s\n", g_num_gpus ? "--gpu" : selftest ? "--selftest" : "--bench");
+        g_governor = GOV_OFF;
+    }
+    /* On the chunk geometry of the scan (gov_apply rounds it per engine) */
+    if (g_governor && !governor_sweep(engine_given, isa != HASH160_ISA_AUTO))
+        return 1;
+    /* Every chain scans the same number of batches */
+    NUM_BATCHES = (NUM_BATCHES + g_chains - 1) / g_chains * g_chains;
+    printf("  Batch: %d pts | %d batches/chunk | %llu keys/chunk\n",
+           BATCH_SIZE, NUM_BATCHES, (unsigned long long)CHUNK_SIZE);
+    if (g_kernel)
+        printf("  Kernel: %s x%d%s, %s\n", ENGINE_NAMES[g_kernel->engine], g_kernel->lanes,
+               g_kernel->bmi2 ? " bmi2" : "", g_kernel->batch ? "specialized for this batch" : "generic batch");
+    if (!giant_table_init(CHUNK_SIZE / g_chains))
+        fprintf(stderr, "  Giant steps: table allocation failed, every seek multiplies\n");
 
     /* Verify setup */
     {
@@ -393,6 +4967,105 @@ int main(int argc, char *argv[]) {
                memcmp(gh, expected, 20) == 0 ? "PASSED" : "FAILED");
         if (memcmp(gh, expected, 20) != 0) return 1;
 
+        /* Verify every kernel this CPU runs (and the scalar tail) against hash160 */
+        unsigned char mp[16 + 16 + 5][33], mh[16 + 16 + 5][20], sh[20];
+        for (int i = 0; i < 37; i++) {
+            memcpy(mp[i], gs, 33);
+            mp[i][1 + (i % 32)] ^= (unsigned char)(i + 1);
+        }
+        int lanes_ok = 1, scan_isa = hash160_isa;
+        char tested[64] = "";
+        for (int k = HASH160_ISA_SCALAR; k < HASH160_ISA_AUTO && lanes_ok; k++) {
+            if (!hash160_select(k)) continue;
+            memset(mh, 0, sizeof(mh));
+            hash160_fast_many(mp, mh, 37);
+            for (int i = 0; i < 37; i++) {
+                unsigned char d1[32], d2[32];
+                sha256_33(mp[i], d1);
+                sha256_33_generic(mp[i], d2);
+                hash160(mp[i], sh);
+                if (memcmp(sh, mh[i], 20) != 0 || memcmp(d1, d2, 32) != 0) { lanes_ok = 0; break; }
+            }
+            snprintf(tested + strlen(tested), sizeof(tested) - strlen(tested), "%s%s",
+                     tested[0] ? ", " : "", HASH160_ISA_NAMES[k]);
+        }
+        hash160_select(scan_isa);
+        printf("  Hash160 kernel test: %s (%s; %d lanes in scan)\n",
+               lanes_ok ? "PASSED" : "FAILED", tested, hash160_lanes);
+        if (!lanes_ok) return 1;
+
+        /* Verify the scan path: field element -> words -> hash160_xw_lanes
+         * must agree with serialize33 + hash160 for points of both parities */
+        {
+            secp256k1_gej wj;
+            secp256k1_ge  wp[HASH160_MAX_LANES];
+            uint32_t wpre[HASH160_MAX_LANES], wx[8 * HASH160_MAX_LANES], wh[5 * HASH160_MAX_LANES];
+            secp256k1_gej_set_ge(&wj, &g_gen_affine);
+            for (int l = 0; l < hash160_lanes; l++) {
+                secp256k1_ge_set_gej_var(&wp[l], &wj);
+                secp256k1_gej next;
+                secp256k1_gej_add_ge_var(&next, &wj, &g_gen_affine, NULL);
+                wj = next;
+                ge_hash_words(&wp[l], wpre, wx, hash160_lanes, l);
+            }
+            hash160_xw_lanes(wpre, wx, wh);
+            int words_ok = 1;
+            for (int l = 0; l < hash160_lanes; l++) {
+                unsigned char ps[33], wb[20];
+                secp256k1_eckey_pubkey_serialize33(&wp[l], ps);
+                hash160(ps, sh);
+                for (int w = 0; w < 5; w++)
+                    put_le32(wb + w * 4, wh[w * hash160_lanes + l]);
+                if (memcmp(sh, wb, 20) != 0) words_ok = 0;
+            }
+#ifdef SECP256K1_WIDEMUL_INT128
+            /* Weakly normalized values at p + 3 and 2^256 - 1 (the slow path) */
+            {
+                static const secp256k1_fe weak[2] = {
+                    {{ 0xFFFFEFFFFFC32ULL, 0xFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFULL,
+                       0xFFFFFFFFFFFFFULL, 0x0FFFFFFFFFFFFULL }},
+                    {{ 0xFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFULL,
+                       0xFFFFFFFFFFFFFULL, 0x0FFFFFFFFFFFFULL }}
+                };
+                static const uint64_t canon[2] = { 3, 0x1000003D0ULL };
+                for (int k = 0; k < 2; k++) {
+                    secp256k1_fe tmp;
+                    const uint64_t *n = fe_hash_limbs(&weak[k], &tmp);
+                    if (n[0] != canon[k] || (n[1] | n[2] | n[3] | n[4])) words_ok = 0;
+                }
+            }
+#endif
+            printf("  Hash160 word-input test: %s\n", words_ok ? "PASSED" : "FAILED");
+            if (!words_ok) return 1;
+        }
+
+        /* Verify the target set: G's address decodes to Hash160(G), which is
+         * found in a set with TARGET_H160 and a decoy; near misses rejected */
+        {
+            target_set_t ts = {0};
+            unsigned char (*th)[20] = malloc(3 * 20);
+            unsigned char miss[20];
+            int set_ok = th && p2pkh_to_h160("1BgGZ9tcN4rm9KBzDn7KprQz87SZ26SAMH", th[0]) &&
+                         memcmp(th[0], gh, 20) == 0;
+            if (th) {
+                memcpy(th[1], TARGET_H160, 20);
+                memcpy(th[2], gh, 20);
+                th[2][19] ^= 0x5A;
+            }
+            set_ok = set_ok && target_set_build(&ts, th, 3);
+            memcpy(miss, gh, 20);
+            miss[10] ^= 1;
+            if (set_ok) {
+                set_ok = target_filter_hit(&ts, h160_word0(gh)) &&
+                         target_set_contains(&ts, gh) &&
+                         target_set_contains(&ts, TARGET_H160) &&
+                         !target_set_contains(&ts, miss);
+            }
+            printf("  Target set test: %s\n", set_ok ? "PASSED" : "FAILED");
+            target_set_free(&ts);
+            if (!set_ok) return 1;
+        }
+
         /* Verify EC addition: 2G == G+G */
         secp256k1_scalar two_s;
         secp256k1_scalar_set_int(&two_s, 2);
@@ -439,32 +5112,315 @@ int main(int argc, char *argv[]) {
         }
         printf("  Batch inversion test: %s\n", batch_ok ? "PASSED" : "FAILED");
         if (!batch_ok) return 1;
+
+        /* Verify the affine engines: two batches from the range start 2^70
+         * against the Jacobian chain */
+        secp256k1_ge *ref_a = malloc(sizeof(secp256k1_ge) * BATCH_SIZE);
+        secp256k1_ge *step_a = malloc(sizeof(secp256k1_ge) * BATCH_SIZE);
+        secp256k1_fe *step_s = malloc(sizeof(secp256k1_fe) * BATCH_SIZE);
+        secp256k1_gej *ref_j = malloc(sizeof(secp256k1_gej) * BATCH_SIZE);
+        if (!ref_a || !step_a || !step_s || !ref_j) {
+            fprintf(stderr, "FATAL: stepping test allocation failed\n");
+            return 1;
+        }
+        for (int engine = ENGINE_AFFINE; engine <= ENGINE_CENTER; engine++) {
+            int affine_ok = 1;
+            secp256k1_scalar base_s;
+            secp256k1_gej cur_j;
+            make_scalar(&base_s, 0x4ULL, engine == ENGINE_CENTER ? HALF_BATCH : 0);
+            secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &cur_j, &base_s);
+            secp256k1_ge cur;
+            secp256k1_ge_set_gej_var(&cur, &cur_j);
+            make_scalar(&base_s, 0x4ULL, 0);
+            secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &ref_j[0], &base_s);
+            for (int b = 0; b < 2 && affine_ok; b++) {
+                if (b > 0)
+                    secp256k1_gej_add_ge_var(&ref_j[0], &ref_j[BATCH_SIZE-1], &g_gen_affine, NULL);
+                for (int i = 1; i < BATCH_SIZE; i++)
+                    secp256k1_gej_add_ge_var(&ref_j[i], &ref_j[i-1], &g_gen_affine, NULL);
+                secp256k1_ge_set_all_gej_var(ref_a, ref_j, BATCH_SIZE);
+                if (engine == ENGINE_CENTER)
+                    center_batch(step_a, &cur, step_s);
+                else
+                    affine_batch(step_a, &cur, step_s);
+                for (int i = 0; i < BATCH_SIZE; i++) {
+                    unsigned char a1[33], a2[33];
+                    secp256k1_eckey_pubkey_serialize33(&ref_a[i], a1);
+                    secp256k1_eckey_pubkey_serialize33(&step_a[i], a2);
+                    if (memcmp(a1, a2, 33) != 0) { affine_ok = 0; break; }
+                }
+            }
+            printf("  %s stepping test: %s\n",
+                   engine == ENGINE_CENTER ? "Center-out" : "Affine",
+                   affine_ok ? "PASSED" : "FAILED");
+            if (!affine_ok) return 1;
+        }
+
+        /* Verify the fused engine: targets planted at the first and last key
+         * of the batch and at tile edges are reported at their offsets, and
+         * the stream advances like the affine engine */
+        {
+            int fused_ok = 1;
+            const int offs[] = { 0, 1, hash160_lanes - 1, hash160_lanes, BATCH_SIZE / 2 + 3, BATCH_SIZE - 1 };
+            target_set_t saved = g_targets;
+            secp256k1_scalar base_s;
+            secp256k1_gej base_j;
+            secp256k1_ge base, cur, next;
+            make_scalar(&base_s, 0x4ULL, 0);
+            secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &base_j, &base_s);
+            secp256k1_ge_set_gej_var(&base, &base_j);
+            if (fused_ok) {
+                /* ref_a still holds the affine test's last reference batch;
+                 * rebuild batch 0 from 2^70 */
+                ref_j[0] = base_j;
+                for (int i = 1; i < BATCH_SIZE; i++)
+                    secp256k1_gej_add_ge_var(&ref_j[i], &ref_j[i-1], &g_gen_affine, NULL);
+                secp256k1_ge_set_all_gej_var(ref_a, ref_j, BATCH_SIZE);
+                next = base;
+                affine_batch(step_a, &next, step_s);
+            }
+            for (size_t k = 0; k < sizeof(offs) / sizeof(offs[0]) && fused_ok; k++) {
+                unsigned char pub[33], (*th)[20] = malloc(20), h[20];
+                target_set_t ts = {0};
+                secp256k1_eckey_pubkey_serialize33(&ref_a[offs[k]], pub);
+                if (!th) { fused_ok = 0; break; }
+                hash160(pub, th[0]);
+                if (!target_set_build(&ts, th, 1)) { free(th); fused_ok = 0; break; }
+                g_targets = ts;
+                cur = base;
+                int hit = fused_batch(&cur, step_s, h);
+                unsigned char n1[33], n2[33];
+                secp256k1_eckey_pubkey_serialize33(&cur, n1);
+                secp256k1_eckey_pubkey_serialize33(&next, n2);
+                fused_ok = hit == offs[k] && memcmp(h, ts.h160[0], 20) == 0 && memcmp(n1, n2, 33) == 0;
+                g_targets = saved;
+                target_set_free(&ts);
+            }
+            printf("  Fused pipeline test: %s\n", fused_ok ? "PASSED" : "FAILED");
+            if (!fused_ok) return 1;
+        }
+
+#if SIMD_FIELD
+        /* Verify the simd engine: IFMA field ops lane by lane, then targets
+         * planted across chains and batch edges (the second batch checks
+         * that every chain advanced by BATCH_SIZE) */
+        if (g_simd_ifma) {
+            int simd_ok = simd_field_selftest();
+            printf("  SIMD field test: %s\n", simd_ok ? "PASSED" : "FAILED");
+            if (!simd_ok) return 1;
+
+            const int chain_offs[][2] = {
+                { 0, 0 }, { 0, BATCH_SIZE - 1 }, { 1, 1 }, { 3, hash160_lanes },
+                { 5, BATCH_SIZE / 2 + 3 }, { SIMD_CHAINS - 1, BATCH_SIZE - 1 },
+                { 2, BATCH_SIZE }, { SIMD_CHAINS - 1, 2 * BATCH_SIZE - 1 }
+            };
+            int saved_engine = g_engine, saved_chains = g_chains;
+            target_set_t saved = g_targets;
+            batch_state_t sst;
+            g_engine = ENGINE_SIMD;
+            g_chains = SIMD_CHAINS;
+            simd_ok = batch_state_init(&sst);
+            sst.chain_stride = UNIT_KEYS / SIMD_CHAINS;
+            for (size_t k = 0; k < sizeof(chain_offs) / sizeof(chain_offs[0]) && simd_ok; k++) {
+                int c = chain_offs[k][0], off = chain_offs[k][1];
+                unsigned char pub[33], (*th)[20] = malloc(20), h[20];
+                target_set_t ts = {0};
+                secp256k1_scalar ks;
+                secp256k1_gej kj;
+                secp256k1_ge kp;
+                make_scalar(&ks, 0x4ULL, c * sst.chain_stride + off);
+                secp256k1_ecmult_gen(&g_ecmult_gen_ctx, &kj, &ks);
+                secp256k1_ge_set_gej_var(&kp, &kj);
+                secp256k1_eckey_pubkey_serialize33(&kp, pub);
+                if (!th) { simd_ok = 0; break; }
+                hash160(pub, th[0]);
+                if (!target_set_build(&ts, th, 1)) { free(th); simd_ok = 0; break; }
+                g_targets = ts;
+                batch_seek(&sst, 0x4ULL, 0);
+                int hit = batch_scan(&sst, h);
+                if (off >= BATCH_SIZE) {
+                    simd_ok = hit < 0;
+                    hit = batch_scan(&sst, h);
+                    off -= BATCH_SIZE;
+                }
+                simd_ok = simd_ok && hit == c * BATCH_SIZE + off && memcmp(h, ts.h160[0], 20) == 0;
+                g_targets = saved;
+                target_set_free(&ts);
+            }
+            if (sst.arena) batch_state_free(&sst);
+            g_engine = saved_engine;
+            g_chains = saved_chains;
+            printf("  SIMD chains test: %s\n", simd_ok ? "PASSED" : "FAILED");
+            if (!simd_ok) return 1;
+        }
+#endif
+        free(ref_a); free(step_a); free(step_s); free(ref_j);
+
+        /* Verify the unit permutation: distinct units, inside the range */
+        {
+            enum { NP = 4096 };
+            static uint64_t pu[NP];
+            int perm_ok = 1;
+            uint64_t hi, lo;
+            for (int i = 0; i < NP && perm_ok; i++) {
+                pu[i] = unit_permute(NUM_UNITS - 1 - i, 0x0123456789ABCDEFULL);
+                if (pu[i] >= NUM_UNITS) perm_ok = 0;
+                for (int j = 0; j < i; j++)
+                    if (pu[j] == pu[i]) { perm_ok = 0; break; }
+            }
+            unit_start(NUM_UNITS - 1, &hi, &lo);
+            if (hi != 0x7F || lo + (UNIT_KEYS - 1) != ~0ULL) perm_ok = 0;
+            printf("  Work-unit permutation test: %s\n", perm_ok ? "PASSED" : "FAILED");
+            if (!perm_ok) return 1;
+        }
+
+#ifdef WITH_CUDA
+        /* Verify every GPU: planted keys found at their exact offsets */
+        if (g_num_gpus && !bench_path) {
+            if (!gpu_tables_init()) {
+                fprintf(stderr, "FATAL: GPU table allocation failed\n");
+                return 1;
+            }
+            for (int i = 0; i < g_num_gpus; i++) {
+                int gpu_ok = gpu_selftest(g_gpu_ids[i]);
+                printf("  GPU %d scan test: %s\n", g_gpu_ids[i], gpu_ok ? "PASSED" : "FAILED");
+                if (!gpu_ok) return 1;
+            }
+        }
+#endif
+    }
+
+    /* The startup tests above check the stride-1 tables; switch them to the
+     * progression only now */
+    if (stride_n > 1) {
+        g_key_stride = stride_n;
+        g_key_residue = stride_residue;
+        if (!step_tables_fill()) {
+            fprintf(stderr, "FATAL: strided step table allocation failed\n");
+            return 1;
+        }
+        if (!giant_table_init(CHUNK_SIZE / g_chains))
+            fprintf(stderr, "  Giant steps: table allocation failed, every seek multiplies\n");
+#ifdef WITH_CUDA
+        if (g_num_gpus && !bench_path && !gpu_tables_init()) {
+            fprintf(stderr, "FATAL: GPU table allocation failed\n");
+            return 1;
+        }
+#endif
+        printf("  Stride: node %llu of %llu (keys 2^70 + %llu + j*%llu)\n", stride_residue, stride_n,
+               stride_residue, stride_n);
+    }
+
+    if (selftest) {
+        int ok = planted_selftest();
+        printf("  Self-test: %s\n", ok ? "PASSED" : "FAILED");
+        cleanup_secp256k1();
+        target_set_free(&g_targets);
+        return ok ? 0 : 1;
+    }
+    if (g_sample_every)
+        printf("  Sampling: 1 batch in %d re-derived with libsecp256k1\n", g_sample_every);
+
+    if (bench_path) {
+        int rc = run_bench(bench_path, batch_given ? BATCH_SIZE : 0);
+        cleanup_secp256k1();
+        target_set_free(&g_targets);
+        return rc;
     }
 
+    printf("  Arenas: 2MB %s\n", atomic_load(&g_arena_hugetlb) ? "MAP_HUGETLB" : "THP-advised (no reserved huge pages)");
+    printf("  Point tables: %d mapped, %d built in %.1f ms | cache %s\n", g_tables_mapped, g_tables_built,
+           g_tables_secs * 1e3, g_table_dir ? g_table_dir : "off");
+    cosched_init();
+    /* No more CPU workers than can ever run next to the GPU feeders */
+    if (NUM_THREADS > atomic_load(&g_cpu_max))
+        NUM_THREADS = atomic_load(&g_cpu_max) > 1 ? atomic_load(&g_cpu_max) : 1;
+    if (g_governor)
+        atomic_store(&g_cpu_active, g_gov_threads < atomic_load(&g_cpu_max) ? g_gov_threads
+                                                                          : atomic_load(&g_cpu_max));
+    if (g_num_gpus && NUM_THREADS)
+        printf("  Co-scheduler: %s, up to %d CPU workers, %d CPUs kept for %d GPU feeder%s\n",
+               g_cosched ? "on" : "off (--no-cosched)", atomic_load(&g_cpu_max), g_cpu_reserved,
+               g_num_gpus, g_num_gpus == 1 ? "" : "s");
+    printf("  Stats: %s%s", g_stats_path, g_stage_timing ? " (stage timing on)" : "");
+    if (g_metrics_port) printf(" | metrics on :%d", g_metrics_port);
+    printf("\n");
+
     printf("============================================================\n");
     printf("  Starting scan...\n");
     printf("============================================================\n\n");
     fflush(stdout);
 
     g_start_time_d = get_time_sec();
+    energy_sample();
+
+    g_num_workers = NUM_THREADS + g_num_gpus;
+    g_thread_stats = aligned_alloc(64, sizeof(thread_stats_t) * g_num_workers);
+    g_thread_rate = calloc(g_num_workers, sizeof(double));
+    g_njobs = 2 * NUM_THREADS;
+    g_jobs = calloc(g_njobs, sizeof(unit_job_t));
+    g_slots = aligned_alloc(64, sizeof(steal_slot_t) * NUM_THREADS);
+    g_cand_rings = aligned_alloc(64, sizeof(cand_ring_t) * g_num_workers);
+    if (!g_thread_stats || !g_thread_rate || !g_jobs || !g_slots || !g_cand_rings) {
+        fprintf(stderr, "FATAL: telemetry allocation failed\n");
+        return 1;
+    }
+    memset(g_thread_stats, 0, sizeof(thread_stats_t) * g_num_workers);
+    memset(g_slots, 0, sizeof(steal_slot_t) * NUM_THREADS);
+    memset(g_cand_rings, 0, sizeof(cand_ring_t) * g_num_workers);
+    atomic_store(&g_stats_ready, 1);
+    if (g_metrics_port && !metrics_start(g_metrics_port))
+        fprintf(stderr, "  Metrics: cannot listen on port %d\n", g_metrics_port);
 
-    pthread_t stats_tid;
+    pthread_t stats_tid, verifier_tid;
     pthread_create(&stats_tid, NULL, stats_thread, NULL);
+    pthread_create(&verifier_tid, NULL, verifier_thread, NULL);
 
-    pthread_t *workers = malloc(sizeof(pthread_t) * NUM_THREADS);
-    thread_arg_t *args = malloc(sizeof(thread_arg_t) * NUM_THREADS);
+    pthread_t *workers = malloc(sizeof(pthread_t) * g_num_workers);
+    thread_arg_t *args = malloc(sizeof(thread_arg_t) * g_num_workers);
 
+    atomic_store(&g_workers_live, g_num_workers);
     for (int i = 0; i < NUM_THREADS; i++) {
         args[i].thread_id = i;
         pthread_create(&workers[i], NULL, scanner_thread, &args[i]);
     }
+#ifdef WITH_CUDA
+    for (int i = NUM_THREADS; i < g_num_workers; i++) {
+        args[i].thread_id = i;
+        pthread_create(&workers[i], NULL, gpu_thread, &args[i]);
+    }
+#endif
 
-    for (int i = 0; i < NUM_THREADS; i++) {
-        pthread_join(workers[i], NULL);
+    /* Once a stop is requested (SIGTERM on a spot instance leaves seconds)
+     * workers get DRAIN_DEADLINE_MS to finish their batch; the checkpoint
+     * then goes out from whatever they last published */
+    double drain_by = 0;
+    while (atomic_load(&g_workers_live) > 0) {
+        if (g_interrupted && !drain_by)
+            drain_by = get_time_sec() + DRAIN_DEADLINE_MS / 1000.0;
+        if (drain_by && get_time_sec() >= drain_by) break;
+        usleep(g_interrupted ? 1000 : 20000);
+    }
+    int drained = atomic_load(&g_workers_live) == 0;
+    /* Every candidate pushed so far is verified before the summary */
+    atomic_store(&g_cand_stop, 1);
+    pthread_join(verifier_tid, NULL);
+    int partial = 0;
+    if (g_units_mode && !g_coord_addr)
+        partial = write_checkpoint();
+    if (drained) {
+        for (int i = 0; i < g_num_workers; i++)
+            pthread_join(workers[i], NULL);
     }
 
     pthread_cancel(stats_tid);
     pthread_join(stats_tid, NULL);
+    /* The part of the last stats interval the stats thread did not see */
+    double tail_j = energy_sample();
+    if (tail_j > 0) g_energy_j += tail_j;
+    write_stats(atomic_load(&g_sample_failed) ? "failed" : g_interrupted ? "stopped" :
+                atomic_load(&g_found) ? "found" :
+                atomic_load(&g_units_exhausted) ? "done" : "stopped");
 
     double end_time = get_time_sec();
     double elapsed = end_time - g_start_time_d;
@@ -472,18 +5428,63 @@ int main(int argc, char *argv[]) {
     double rate = (elapsed > 0) ? (double)total / elapsed : 0;
 
     printf("\n============================================================\n");
-    if (g_interrupted) {
+    if (atomic_load(&g_sample_failed)) {
+        printf("  SAMPLE CHECK FAILED: this build's engine disagrees with libsecp256k1.\n");
+    } else if (g_interrupted) {
         printf("  Scan interrupted by user.\n");
     } else if (atomic_load(&g_found)) {
         printf("  KEY FOUND! Check /root/puzzle71/FOUND_KEY.txt\n");
+    } else if (atomic_load(&g_units_exhausted)) {
+        printf("  All work units scanned.\n");
     }
     printf("  Total keys checked: %llu\n", total);
     printf("  Elapsed: %.1f seconds\n", elapsed);
     printf("  Average rate: %.0f keys/sec (%.2f Mkeys/sec)\n", rate, rate / 1e6);
+    if (g_sample_every)
+        printf("  Sample checks: %llu\n", (unsigned long long)atomic_load(&g_samples));
+    if (atomic_load(&g_cand_pushed))
+        printf("  Candidates: %llu verified, %llu confirmed, %llu not confirmed\n",
+               (unsigned long long)atomic_load(&g_cand_pushed),
+               (unsigned long long)atomic_load(&g_cand_confirmed),
+               (unsigned long long)atomic_load(&g_cand_rejected));
+    printf("  Start points: %llu by giant step, %llu by scalar multiplication\n",
+           (unsigned long long)atomic_load(&g_seeks[1]), (unsigned long long)atomic_load(&g_seeks[0]));
+    if (g_ledger_path)
+        printf("  Ledger: %llu covered units skipped\n",
+               (unsigned long long)atomic_load(&g_ledger_skipped));
+    if (g_units_mode)
+        printf("  Work stealing: %llu ranges split off slower workers\n",
+               (unsigned long long)atomic_load(&g_steals));
+    if (g_units_mode && !g_coord_addr)
+        printf("  Checkpoint: %d units saved mid-unit\n", partial);
+    if (g_num_gpus && NUM_THREADS)
+        printf("  Co-scheduler: %d of %d CPU workers running at the end\n",
+               atomic_load(&g_cpu_active), atomic_load(&g_cpu_max));
+    if (g_governor)
+        printf("  Governor (%s): %s engine, %s hash, %d of %d CPU workers at the end\n",
+               GOV_NAMES[g_governor], ENGINE_NAMES[g_engine], hash160_kernel_name(),
+               atomic_load(&g_cpu_active), g_gov_threads);
+    if (g_energy_j > 0)
+        printf("  Energy: %.1f kJ, %.4f Mkeys/J (sweep measured %.4f)\n", g_energy_j / 1e3,
+               total / g_energy_j / 1e6, g_gov_kpj / 1e6);
+    if (!drained)
+        printf("  Drain: %d workers still busy after %d ms, not waited for\n",
+               atomic_load(&g_workers_live), DRAIN_DEADLINE_MS);
     printf("============================================================\n");
+    fflush(stdout);
+    /* Workers still running hold the state freed below */
+    if (!drained) _exit(atomic_load(&g_sample_failed) ? 2 : 0);
 
     cleanup_secp256k1();
+    target_set_free(&g_targets);
+    ledger_close();
     free(workers);
     free(args);
-    return 0;
+    free(g_thread_stats);
+    free(g_thread_rate);
+    free(g_jobs);
+    free(g_slots);
+    free(g_cand_rings);
+    return atomic_load(&g_sample_failed) ? 2 : 0;
 }
+#endif /* !SCANNER_LIBRARY */
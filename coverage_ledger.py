@@ -0,0 +1,364 @@
+#!/usr/bin/env python3
+"""
+coverage_ledger.py -- Shared coverage ledger for every puzzle #71 engine
+========================================================================
+
+One append-only binary file records which work units have been scanned,
+whoever scanned them: c_scanner (--units, coordinator or random chunks
+with --ledger), turbo_scanner.py (--ledger), work_coordinator.py, and
+BitCrack runs imported from their checkpoint.  Every scheduler reads it to
+skip ranges that are already covered.
+
+Work units are the same as `c_scanner --units`: unit u covers the keys
+2^70 + u*2^22 .. 2^70 + (u+1)*2^22 - 1.  Only whole units are recorded;
+partial coverage is rounded inward.
+
+File format (little-endian, memory-mappable):
+  header  32 bytes: magic "P71LEDG1", u32 version (1), u32 unit_bits (22),
+                    u64 sorted, u64 reserved
+  records 16 bytes each: u64 first, u64 end   (units [first, end))
+The first `sorted` records are sorted, merged and disjoint (written by
+compaction) and can be binary-searched in place; records after them are
+appends in any order, possibly overlapping.  Appenders write one record
+per write() on an O_APPEND descriptor under a shared flock; compaction
+holds the exclusive lock, rewrites the file and renames it over the old
+one, and appenders reopen the path when its inode changes.
+
+Usage:
+  python coverage_ledger.py status  [--ledger FILE]
+  python coverage_ledger.py add     START_HEX END_HEX [--ledger FILE]
+  python coverage_ledger.py check   KEY_HEX [--ledger FILE]
+  python coverage_ledger.py next-free KEY_HEX [--ledger FILE]
+  python coverage_ledger.py compact [OTHER_LEDGER ...] [--ledger FILE]
+  python coverage_ledger.py import-jsonl coverage_ledger.jsonl [--ledger FILE]
+  python coverage_ledger.py import-bitcrack checkpoint.txt [--start HEX] [--end HEX] [--ledger FILE]
+"""
+
+import argparse
+import bisect
+import fcntl
+import json
+import mmap
+import os
+import struct
+import sys
+import tempfile
+
+# =============================================================================
+# Constants
+# =============================================================================
+
+UNIT_BITS = 22
+UNIT_KEYS = 1 << UNIT_BITS
+NUM_UNITS = 1 << (70 - UNIT_BITS)
+RANGE_START = 1 << 70
+RANGE_END = (1 << 71) - 1
+
+LEDGER_FILE = "/root/puzzle71/data/coverage.ledger"
+MAGIC = b"P71LEDG1"
+VERSION = 1
+HEADER = struct.Struct("<8sIIQQ")
+RECORD = struct.Struct("<QQ")
+
+# =============================================================================
+# Keys <-> units
+# =============================================================================
+
+def key_unit(key):
+    """Work unit holding a private key."""
+    return (key - RANGE_START) >> UNIT_BITS
+
+
+def unit_key(unit):
+    """First key of a work unit."""
+    return RANGE_START + (unit << UNIT_BITS)
+
+
+def keys_to_units(first_key, end_key):
+    """Whole units inside the keys [first_key, end_key): (first, end)."""
+    first_key = max(first_key, RANGE_START)
+    end_key = min(end_key, RANGE_END + 1)
+    first = -(-(first_key - RANGE_START) >> UNIT_BITS)
+    end = (end_key - RANGE_START) >> UNIT_BITS
+    return first, max(first, end)
+
+
+def merge_runs(runs):
+    """Sort and merge [first, end) runs into disjoint ones."""
+    out = []
+    for first, end in sorted(r for r in runs if r[1] > r[0]):
+        if out and first <= out[-1][1]:
+            if end > out[-1][1]:
+                out[-1][1] = end
+        else:
+            out.append([first, end])
+    return [tuple(r) for r in out]
+
+# =============================================================================
+# Ledger file
+# =============================================================================
+
+def _header(sorted_count):
+    return HEADER.pack(MAGIC, VERSION, UNIT_BITS, sorted_count, 0)
+
+
+def read_ledger(path):
+    """All runs of a ledger file, merged (empty for a missing file)."""
+    try:
+        with open(path, "rb") as f:
+            data = f.read()
+    except FileNotFoundError:
+        return []
+    if not data:
+        return []
+    magic, version, unit_bits, _, _ = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION or unit_bits != UNIT_BITS:
+        raise ValueError(f"{path}: not a v{VERSION} coverage ledger with {UNIT_BITS}-bit units")
+    n = (len(data) - HEADER.size) // RECORD.size
+    return merge_runs(RECORD.unpack_from(data, HEADER.size + i * RECORD.size) for i in range(n))
+
+
+class Ledger:
+    """
+    A ledger opened for lookups and appends.  The sorted prefix is used
+    straight from the mapping; appended records (and this process's own
+    additions) are kept merged in memory.
+    """
+
+    def __init__(self, path=LEDGER_FILE):
+        self.path = path
+        self.fd = -1
+        self.map = None
+        self.sorted = 0
+        self.tail = []
+        self.reload()
+
+    def _open(self):
+        os.makedirs(os.path.dirname(os.path.abspath(self.path)), exist_ok=True)
+        fd = os.open(self.path, os.O_RDWR | os.O_CREAT | os.O_APPEND, 0o644)
+        fcntl.flock(fd, fcntl.LOCK_EX)
+        try:
+            if os.fstat(fd).st_size == 0:
+                os.write(fd, _header(0))
+        finally:
+            fcntl.flock(fd, fcntl.LOCK_UN)
+        return fd
+
+    def reload(self):
+        """(Re)read the file, picking up other processes' appends."""
+        self.close()
+        self.fd = self._open()
+        size = os.fstat(self.fd).st_size
+        self.map = mmap.mmap(self.fd, size, prot=mmap.PROT_READ)
+        magic, version, unit_bits, self.sorted, _ = HEADER.unpack_from(self.map)
+        if magic != MAGIC or version != VERSION or unit_bits != UNIT_BITS:
+            raise ValueError(f"{self.path}: not a v{VERSION} coverage ledger with {UNIT_BITS}-bit units")
+        n = (size - HEADER.size) // RECORD.size
+        self.sorted = min(self.sorted, n)
+        self.tail = merge_runs(RECORD.unpack_from(self.map, HEADER.size + i * RECORD.size)
+                               for i in range(self.sorted, n))
+
+    def close(self):
+        if self.map is not None:
+            self.map.close()
+            self.map = None
+        if self.fd >= 0:
+            os.close(self.fd)
+            self.fd = -1
+
+    def _sorted_run(self, i):
+        return RECORD.unpack_from(self.map, HEADER.size + i * RECORD.size)
+
+    def _find(self, unit):
+        """End of the run covering unit, or None."""
+        lo, hi = 0, self.sorted
+        while lo < hi:
+            mid = (lo + hi) // 2
+            first, end = self._sorted_run(mid)
+            if end <= unit:
+                lo = mid + 1
+            elif first > unit:
+                hi = mid
+            else:
+                return end
+        i = bisect.bisect_right(self.tail, (unit, NUM_UNITS + 1)) - 1
+        if i >= 0 and unit < self.tail[i][1]:
+            return self.tail[i][1]
+        return None
+
+    def covered(self, unit):
+        """True if the unit has been scanned by anyone."""
+        return self._find(unit) is not None
+
+    def next_free(self, unit):
+        """First uncovered unit >= unit (NUM_UNITS when none is left)."""
+        while unit < NUM_UNITS:
+            end = self._find(unit)
+            if end is None:
+                return unit
+            unit = end
+        return NUM_UNITS
+
+    def add(self, first, end):
+        """Record units [first, end) as scanned."""
+        if end <= first:
+            return
+        rec = RECORD.pack(first, end)
+        fcntl.flock(self.fd, fcntl.LOCK_SH)
+        try:
+            # Compaction renamed a new file over ours: append to that one
+            if os.stat(self.path).st_ino != os.fstat(self.fd).st_ino:
+                fcntl.flock(self.fd, fcntl.LOCK_UN)
+                self.reload()
+                fcntl.flock(self.fd, fcntl.LOCK_SH)
+            os.write(self.fd, rec)
+        finally:
+            fcntl.flock(self.fd, fcntl.LOCK_UN)
+        # Splice into the sorted tail: swallow every run it overlaps or touches
+        lo = bisect.bisect_right(self.tail, (first, NUM_UNITS + 1))
+        if lo and self.tail[lo - 1][1] >= first:
+            lo -= 1
+        hi = bisect.bisect_right(self.tail, (end, NUM_UNITS + 1))
+        if lo < hi:
+            first = min(first, self.tail[lo][0])
+            end = max(end, self.tail[hi - 1][1])
+        self.tail[lo:hi] = [(first, end)]
+
+    def runs(self):
+        """Every run, merged."""
+        return merge_runs([self._sorted_run(i) for i in range(self.sorted)] + self.tail)
+
+    def units_covered(self):
+        return sum(end - first for first, end in self.runs())
+
+
+def compact(path, others=()):
+    """Rewrite the ledger as sorted, merged runs, folding in other ledgers."""
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    fd = os.open(path, os.O_RDWR | os.O_CREAT, 0o644)
+    try:
+        fcntl.flock(fd, fcntl.LOCK_EX)
+        runs = read_ledger(path)
+        for other in others:
+            runs += read_ledger(other)
+        runs = merge_runs(runs)
+        tfd, tmp_path = tempfile.mkstemp(dir=os.path.dirname(os.path.abspath(path)), suffix=".tmp")
+        with os.fdopen(tfd, "wb") as f:
+            f.write(_header(len(runs)))
+            for first, end in runs:
+                f.write(RECORD.pack(first, end))
+            f.flush()
+            os.fsync(f.fileno())
+        os.chmod(tmp_path, 0o644)
+        os.replace(tmp_path, path)
+        return runs
+    finally:
+        os.close(fd)
+
+# =============================================================================
+# Importers
+# =============================================================================
+
+def import_jsonl(ledger, path):
+    """work_coordinator.py's coverage_ledger.jsonl: one completed unit per line."""
+    runs = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if line:
+                unit = json.loads(line)["unit"]
+                runs.append((unit, unit + 1))
+    for first, end in merge_runs(runs):
+        ledger.add(first, end)
+    return sum(end - first for first, end in merge_runs(runs))
+
+
+def import_bitcrack(ledger, path, start_key, end_key=RANGE_END):
+    """A BitCrack checkpoint (gpu_deploy.sh / multi_gpu_launch.sh): the key
+    it has reached, scanned sequentially from start_key.  A key outside
+    [start_key, end_key] is not this run's and is refused."""
+    with open(path) as f:
+        reached = int(f.read().split()[0], 16)
+    if not start_key <= reached <= end_key:
+        raise ValueError(f"checkpoint {reached:x} is outside the run's range "
+                         f"{start_key:x}..{end_key:x}")
+    first, end = keys_to_units(start_key, reached)
+    ledger.add(first, end)
+    return end - first
+
+# =============================================================================
+# Entry point
+# =============================================================================
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Shared work-unit coverage ledger (c_scanner, turbo_scanner.py, "
+                    "work_coordinator.py, BitCrack checkpoints).",
+    )
+    parser.add_argument("--ledger", default=LEDGER_FILE,
+                        help=f"Ledger file (default: {LEDGER_FILE})")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    sub.add_parser("status", help="Covered units, runs and file layout")
+    p = sub.add_parser("add", help="Record the whole units inside keys START..END (inclusive)")
+    p.add_argument("start")
+    p.add_argument("end")
+    p = sub.add_parser("check", help="Is the unit holding KEY covered?")
+    p.add_argument("key")
+    p = sub.add_parser("next-free", help="First key >= KEY in an uncovered unit")
+    p.add_argument("key")
+    p = sub.add_parser("compact", help="Sort and merge the ledger, folding in other ledgers")
+    p.add_argument("others", nargs="*")
+    p = sub.add_parser("import-jsonl", help="Import work_coordinator.py's coverage_ledger.jsonl")
+    p.add_argument("path")
+    p = sub.add_parser("import-bitcrack", help="Import a BitCrack checkpoint (key reached)")
+    p.add_argument("path")
+    p.add_argument("--start", default=f"{RANGE_START:x}",
+                   help="Key the run started from (default: range start)")
+    p.add_argument("--end", default=f"{RANGE_END:x}",
+                   help="Last key of the run's range (default: range end)")
+    args = parser.parse_args()
+
+    if args.cmd == "compact":
+        runs = compact(args.ledger, args.others)
+        print(f"{args.ledger}: {len(runs)} runs, "
+              f"{sum(e - f for f, e in runs):,} units after compaction")
+        return 0
+
+    ledger = Ledger(args.ledger)
+    try:
+        if args.cmd == "status":
+            runs = ledger.runs()
+            units = sum(end - first for first, end in runs)
+            print(f"Ledger:         {args.ledger}")
+            print(f"Records:        {ledger.sorted:,} sorted + {len(ledger.tail):,} appended runs")
+            print(f"Units covered:  {units:,} / {NUM_UNITS:,} ({100.0 * units / NUM_UNITS:.9f}%)")
+            print(f"Keys covered:   {units * UNIT_KEYS:,}")
+            print(f"Merged runs:    {len(runs):,}")
+        elif args.cmd == "add":
+            first, end = keys_to_units(int(args.start, 16), int(args.end, 16) + 1)
+            ledger.add(first, end)
+            print(f"Recorded {end - first:,} units")
+        elif args.cmd == "check":
+            unit = key_unit(int(args.key, 16))
+            covered = ledger.covered(unit)
+            print(f"unit {unit}: {'covered' if covered else 'not covered'}")
+            return 0 if covered else 1
+        elif args.cmd == "next-free":
+            key = int(args.key, 16)
+            unit = key_unit(key)
+            free = ledger.next_free(unit)
+            if free >= NUM_UNITS:
+                print("exhausted", file=sys.stderr)
+                return 1
+            print(f"{key if free == unit else unit_key(free):x}")
+        elif args.cmd == "import-jsonl":
+            print(f"Imported {import_jsonl(ledger, args.path):,} units")
+        elif args.cmd == "import-bitcrack":
+            print(f"Imported {import_bitcrack(ledger, args.path, int(args.start, 16), int(args.end, 16)):,} units")
+    finally:
+        ledger.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
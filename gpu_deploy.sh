@@ -40,6 +40,8 @@ LOGDIR="${WORKDIR}/logs"
 FOUND_FILE="${WORKDIR}/FOUND_KEY.txt"
 PROGRESS_LOG="${LOGDIR}/bitcrack_progress.log"
 CHECKPOINT_FILE="${WORKDIR}/checkpoint.txt"
+LEDGER_FILE="${WORKDIR}/data/coverage.ledger"
+LEDGER_TOOL="${WORKDIR}/coverage_ledger.py"
 
 BITCRACK_REPO="https://github.com/brichard19/BitCrack.git"
 BITCRACK2_REPO="https://github.com/secp8x32/BitCrack2.git"
@@ -542,6 +544,16 @@ configure_launch_params() {
     echo "${threads} ${blocks} ${points}"
 }
 
+# key_in_range KEY LO HI: hex keys (no 0x), LO <= KEY <= HI
+key_in_range() {
+    [[ "$1" =~ ^[0-9A-Fa-f]{1,24}$ ]] || return 1
+    local k lo hi
+    k="$(printf '%024s' "${1^^}" | tr ' ' 0)"
+    lo="$(printf '%024s' "${2^^}" | tr ' ' 0)"
+    hi="$(printf '%024s' "${3^^}" | tr ' ' 0)"
+    [[ ! "$k" < "$lo" && ! "$k" > "$hi" ]]
+}
+
 launch_bitcrack() {
     log_header "Phase 4: Launching BitCrack"
 
@@ -550,12 +562,27 @@ launch_bitcrack() {
     if [[ -f "$CHECKPOINT_FILE" && "$start_key" == "$DEFAULT_START" ]]; then
         local saved_key
         saved_key="$(cat "$CHECKPOINT_FILE" | xargs)"
-        if [[ -n "$saved_key" ]]; then
+        if [[ -n "$saved_key" ]] && key_in_range "$saved_key" "$START_KEY" "$END_KEY"; then
             log_info "Resuming from checkpoint: 0x${saved_key}"
             start_key="$saved_key"
         fi
     fi
 
+    # Skip work units the shared coverage ledger already has (c_scanner,
+    # turbo_scanner.py, earlier BitCrack runs).  Strided runs are sparse and
+    # neither skip nor record.
+    local record_ledger=0
+    if [[ -z "${BITCRACK_STRIDE:-}" && -f "$LEDGER_TOOL" ]] && command -v python3 &>/dev/null; then
+        record_ledger=1
+        local free_key
+        if free_key="$(python3 "$LEDGER_TOOL" --ledger "$LEDGER_FILE" next-free "$start_key" 2>/dev/null)"; then
+            if [[ "${free_key^^}" != "${start_key^^}" ]]; then
+                log_info "Coverage ledger: skipping covered units up to 0x${free_key}"
+                start_key="$free_key"
+            fi
+        fi
+    fi
+
     local params
     params="$(configure_launch_params)"
     local threads blocks points
@@ -616,6 +643,20 @@ set -uo pipefail
 FOUND_FILE="__FOUND_FILE__"
 CHECKPOINT_FILE="__CHECKPOINT_FILE__"
 PROGRESS_LOG="__PROGRESS_LOG__"
+LEDGER_FILE="__LEDGER_FILE__"
+LEDGER_TOOL="__LEDGER_TOOL__"
+RECORD_LEDGER=__RECORD_LEDGER__
+START_KEY="__START_KEY__"
+END_KEY="__END_KEY__"
+
+# This run's own progress: the last key reported, and the one before it
+# (BitCrack has moved past that one, so it holds even after a crash).  Only
+# these go into the ledger; checkpoint.txt may be left by an earlier run.
+RUN_LAST="${CHECKPOINT_FILE}.run-last"
+RUN_CONFIRMED="${CHECKPOINT_FILE}.run-confirmed"
+rm -f "$RUN_LAST" "$RUN_CONFIRMED"
+
+__KEY_IN_RANGE__
 
 # Run BitCrack and process output line by line
 "$@" 2>&1 | while IFS= read -r line; do
@@ -625,8 +666,10 @@ PROGRESS_LOG="__PROGRESS_LOG__"
     # Save checkpoint from progress updates (extract current key position)
     if echo "$line" | grep -qiE '^\[.*\].*[0-9a-fA-F]{16,}'; then
         local_key="$(echo "$line" | grep -oP '[0-9A-Fa-f]{18,20}' | tail -1)"
-        if [[ -n "$local_key" ]]; then
+        if [[ -n "$local_key" ]] && key_in_range "$local_key" "$START_KEY" "$END_KEY"; then
             echo "$local_key" > "$CHECKPOINT_FILE"
+            [[ -f "$RUN_LAST" ]] && mv -f "$RUN_LAST" "$RUN_CONFIRMED"
+            echo "$local_key" > "$RUN_LAST"
         fi
     fi
 
@@ -639,6 +682,16 @@ done
 
 # After BitCrack exits, check if key was found
 exit_code=${PIPESTATUS[0]}
+
+# Record the whole units between the start and the last key this run
+# confirmed: its final report after a clean exit, the one before after a crash
+reached="$RUN_CONFIRMED"
+[[ $exit_code -eq 0 ]] && reached="$RUN_LAST"
+if [[ "$RECORD_LEDGER" == 1 && -f "$reached" ]]; then
+    python3 "$LEDGER_TOOL" --ledger "$LEDGER_FILE" import-bitcrack "$reached" \
+        --start "$START_KEY" --end "$END_KEY" >> "$PROGRESS_LOG" 2>&1 || true
+fi
+rm -f "$RUN_LAST" "$RUN_CONFIRMED"
 if [[ -f "$FOUND_FILE" ]] && [[ -s "$FOUND_FILE" ]]; then
     echo ""
     echo "================================================================"
@@ -659,6 +712,15 @@ WRAPPER_EOF
     sed -i "s|__FOUND_FILE__|${FOUND_FILE}|g" "$wrapper"
     sed -i "s|__CHECKPOINT_FILE__|${CHECKPOINT_FILE}|g" "$wrapper"
     sed -i "s|__PROGRESS_LOG__|${PROGRESS_LOG}|g" "$wrapper"
+    sed -i "s|__LEDGER_FILE__|${LEDGER_FILE}|g" "$wrapper"
+    sed -i "s|__LEDGER_TOOL__|${LEDGER_TOOL}|g" "$wrapper"
+    sed -i "s|__RECORD_LEDGER__|${record_ledger}|g" "$wrapper"
+    sed -i "s|__START_KEY__|${start_key}|g" "$wrapper"
+    sed -i "s|__END_KEY__|${END_KEY}|g" "$wrapper"
+    # The range check, shared with the resume check above
+    declare -f key_in_range > "${wrapper}.fn"
+    sed -i -e "/__KEY_IN_RANGE__/r ${wrapper}.fn" -e "/__KEY_IN_RANGE__/d" "$wrapper"
+    rm -f "${wrapper}.fn"
     chmod +x "$wrapper"
 
     # Launch in a screen session so it survives SSH disconnects
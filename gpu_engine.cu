@@ -0,0 +1,491 @@
+/*
+ * CUDA backend for c_scanner (--gpu): see gpu_engine.h.
+ *
+ * Field elements are 8x32-bit limbs kept fully reduced mod p.  Without
+ * __CUDACC__ the device code compiles as plain C++ (GPU_FN = static
+ * inline), so the field, stepping and hash code can be checked against
+ * the CPU engine on hosts without a GPU.
+ *
+ * Compile:
+ *   nvcc -O3 -arch=sm_86 -c /root/puzzle71/gpu_engine.cu -o /root/puzzle71/gpu_engine.o
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gpu_engine.h"
+
+#ifdef __CUDACC__
+#define GPU_FN     __device__ __forceinline__
+#define GPU_CONST  __constant__
+#else
+#define GPU_FN     static inline
+#define GPU_CONST  static const
+static inline uint32_t atomicAdd(uint32_t *p, uint32_t v) {
+    return __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+}
+#endif
+
+/* ======================== Field Arithmetic ======================== */
+
+typedef struct { uint32_t v[8]; } fe_t;
+
+/* 2^256 - p */
+#define FE_C 0x1000003D1ULL
+
+GPU_FN int fe_ge_p(const fe_t *a) {
+    for (int i = 7; i >= 2; i--)
+        if (a->v[i] != 0xFFFFFFFFu) return 0;
+    if (a->v[1] != 0xFFFFFFFEu) return a->v[1] > 0xFFFFFFFEu;
+    return a->v[0] >= 0xFFFFFC2Fu;
+}
+
+/* r += 2^256 - p, dropping the carry out (used to subtract p mod 2^256) */
+GPU_FN void fe_add_c(fe_t *r) {
+    uint64_t c = (uint64_t)r->v[0] + (FE_C & 0xFFFFFFFFu);
+    r->v[0] = (uint32_t)c; c >>= 32;
+    c += (uint64_t)r->v[1] + (FE_C >> 32);
+    r->v[1] = (uint32_t)c; c >>= 32;
+    for (int i = 2; i < 8 && c; i++) {
+        c += r->v[i];
+        r->v[i] = (uint32_t)c; c >>= 32;
+    }
+}
+
+GPU_FN void fe_add(fe_t *r, const fe_t *a, const fe_t *b) {
+    uint64_t c = 0;
+    for (int i = 0; i < 8; i++) {
+        c += (uint64_t)a->v[i] + b->v[i];
+        r->v[i] = (uint32_t)c; c >>= 32;
+    }
+    if (c || fe_ge_p(r)) fe_add_c(r);
+}
+
+GPU_FN void fe_sub(fe_t *r, const fe_t *a, const fe_t *b) {
+    int64_t c = 0;
+    for (int i = 0; i < 8; i++) {
+        c += (int64_t)a->v[i] - b->v[i];
+        r->v[i] = (uint32_t)c; c >>= 32;
+    }
+    if (c) {
+        /* wrapped: r + p - 2^256 = r - (2^256 - p), no further borrow */
+        uint64_t d = (uint64_t)r->v[0] - (FE_C & 0xFFFFFFFFu);
+        r->v[0] = (uint32_t)d; d = (uint64_t)((int64_t)d >> 32);
+        d += (uint64_t)r->v[1] - (FE_C >> 32);
+        r->v[1] = (uint32_t)d; d = (uint64_t)((int64_t)d >> 32);
+        for (int i = 2; i < 8; i++) {
+            d += r->v[i];
+            r->v[i] = (uint32_t)d; d = (uint64_t)((int64_t)d >> 32);
+        }
+    }
+}
+
+/* 512-bit product t -> t mod p, folding the high half with 2^256 = FE_C */
+GPU_FN void fe_reduce(fe_t *r, const uint32_t t[16]) {
+    uint64_t c = 0;
+    for (int i = 0; i < 8; i++) {
+        c += (uint64_t)t[i] + (uint64_t)t[8 + i] * 977;
+        if (i > 0) c += t[7 + i];
+        r->v[i] = (uint32_t)c; c >>= 32;
+    }
+    uint64_t hi = c + t[15];                /* < 2^34 */
+    c = (uint64_t)r->v[0] + hi * 977;
+    r->v[0] = (uint32_t)c; c >>= 32;
+    c += (uint64_t)r->v[1] + hi;
+    r->v[1] = (uint32_t)c; c >>= 32;
+    for (int i = 2; i < 8; i++) {
+        c += r->v[i];
+        r->v[i] = (uint32_t)c; c >>= 32;
+    }
+    if (c) fe_add_c(r);                     /* r is tiny here, no carry */
+    if (fe_ge_p(r)) fe_add_c(r);
+}
+
+GPU_FN void fe_mul(fe_t *r, const fe_t *a, const fe_t *b) {
+    uint32_t t[16];
+    for (int i = 0; i < 16; i++) t[i] = 0;
+    for (int i = 0; i < 8; i++) {
+        uint64_t c = 0;
+        for (int j = 0; j < 8; j++) {
+            c += (uint64_t)a->v[i] * b->v[j] + t[i + j];
+            t[i + j] = (uint32_t)c; c >>= 32;
+        }
+        t[i + 8] = (uint32_t)c;
+    }
+    fe_reduce(r, t);
+}
+
+GPU_FN void fe_sqr(fe_t *r, const fe_t *a) {
+    fe_mul(r, a, a);
+}
+
+GPU_FN void fe_sqr_n(fe_t *r, const fe_t *a, int n) {
+    fe_sqr(r, a);
+    while (--n > 0) fe_sqr(r, r);
+}
+
+/* a^(p-2), with libsecp256k1's addition chain */
+GPU_FN void fe_inv(fe_t *r, const fe_t *a) {
+    fe_t x2, x3, x6, x9, x11, x22, x44, x88, x176, x220, x223, t;
+    fe_sqr(&x2, a);           fe_mul(&x2, &x2, a);
+    fe_sqr(&x3, &x2);         fe_mul(&x3, &x3, a);
+    fe_sqr_n(&x6, &x3, 3);    fe_mul(&x6, &x6, &x3);
+    fe_sqr_n(&x9, &x6, 3);    fe_mul(&x9, &x9, &x3);
+    fe_sqr_n(&x11, &x9, 2);   fe_mul(&x11, &x11, &x2);
+    fe_sqr_n(&x22, &x11, 11); fe_mul(&x22, &x22, &x11);
+    fe_sqr_n(&x44, &x22, 22); fe_mul(&x44, &x44, &x22);
+    fe_sqr_n(&x88, &x44, 44); fe_mul(&x88, &x88, &x44);
+    fe_sqr_n(&x176, &x88, 88); fe_mul(&x176, &x176, &x88);
+    fe_sqr_n(&x220, &x176, 44); fe_mul(&x220, &x220, &x44);
+    fe_sqr_n(&x223, &x220, 3); fe_mul(&x223, &x223, &x3);
+    fe_sqr_n(&t, &x223, 23);  fe_mul(&t, &t, &x22);
+    fe_sqr_n(&t, &t, 5);      fe_mul(&t, &t, a);
+    fe_sqr_n(&t, &t, 3);      fe_mul(&t, &t, &x2);
+    fe_sqr_n(&t, &t, 2);      fe_mul(r, &t, a);
+}
+
+/* ======================== Point Addition ======================== */
+
+typedef struct { fe_t x, y; } pt_t;
+
+/* r = p + q given inv = 1 / (q.x - p.x); r may alias p */
+GPU_FN void pt_add_inv(pt_t *r, const pt_t *p, const pt_t *q, const fe_t *inv) {
+    fe_t lam, x3, t;
+    fe_sub(&lam, &q->y, &p->y);
+    fe_mul(&lam, &lam, inv);
+    fe_sqr(&x3, &lam);
+    fe_sub(&x3, &x3, &p->x);
+    fe_sub(&x3, &x3, &q->x);
+    fe_sub(&t, &p->x, &x3);
+    fe_mul(&t, &t, &lam);
+    fe_sub(&r->y, &t, &p->y);
+    r->x = x3;
+}
+
+GPU_FN void pt_load(pt_t *r, const gpu_point_t *p) {
+    for (int i = 0; i < 8; i++) { r->x.v[i] = p->x[i]; r->y.v[i] = p->y[i]; }
+}
+
+/* ======================== Hash160 ======================== */
+
+GPU_CONST uint32_t c_sha_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+GPU_CONST uint8_t c_rmd_r[80] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
+    3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
+    1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
+    4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13,
+};
+GPU_CONST uint8_t c_rmd_rp[80] = {
+    5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
+    6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
+    15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
+    8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
+    12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11,
+};
+GPU_CONST uint8_t c_rmd_s[80] = {
+    11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
+    7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
+    11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
+    11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
+    9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6,
+};
+GPU_CONST uint8_t c_rmd_sp[80] = {
+    8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
+    9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
+    9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
+    15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
+    8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11,
+};
+
+GPU_FN uint32_t rotr32(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+GPU_FN uint32_t rotl32(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+GPU_FN uint32_t bswap32(uint32_t x) {
+    return (x >> 24) | ((x >> 8) & 0xFF00) | ((x << 8) & 0xFF0000) | (x << 24);
+}
+
+/* SHA256 of the 33-byte compressed pubkey, one padded block */
+GPU_FN void sha256_pubkey(uint32_t h[8], const pt_t *p) {
+    uint32_t w[64];
+    uint32_t prefix = 0x02 | (p->y.v[0] & 1);
+    w[0] = (prefix << 24) | (p->x.v[7] >> 8);
+    for (int i = 1; i < 8; i++)
+        w[i] = (p->x.v[8 - i] << 24) | (p->x.v[7 - i] >> 8);
+    w[8] = (p->x.v[0] << 24) | 0x800000;
+    for (int i = 9; i < 15; i++) w[i] = 0;
+    w[15] = 33 * 8;
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = 0x6a09e667, b = 0xbb67ae85, c = 0x3c6ef372, d = 0xa54ff53a;
+    uint32_t e = 0x510e527f, f = 0x9b05688c, g = 0x1f83d9ab, hh = 0x5be0cd19;
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = hh + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) +
+                      ((e & f) ^ (~e & g)) + c_sha_k[i] + w[i];
+        uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) +
+                      ((a & b) ^ (a & c) ^ (b & c));
+        hh = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    h[0] = a + 0x6a09e667; h[1] = b + 0xbb67ae85; h[2] = c + 0x3c6ef372; h[3] = d + 0xa54ff53a;
+    h[4] = e + 0x510e527f; h[5] = f + 0x9b05688c; h[6] = g + 0x1f83d9ab; h[7] = hh + 0x5be0cd19;
+}
+
+GPU_FN uint32_t rmd_f(int j, uint32_t x, uint32_t y, uint32_t z) {
+    switch (j >> 4) {
+    case 0:  return x ^ y ^ z;
+    case 1:  return (x & y) | (~x & z);
+    case 2:  return (x | ~y) ^ z;
+    case 3:  return (x & z) | (y & ~z);
+    default: return x ^ (y | ~z);
+    }
+}
+
+/* RIPEMD160 of the 32-byte SHA256 digest; h[] little-endian words */
+GPU_FN void rmd160_digest(uint32_t h[5], const uint32_t sha[8]) {
+    const uint32_t K[5]  = {0x00000000, 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xA953FD4E};
+    const uint32_t KP[5] = {0x50A28BE6, 0x5C4DD124, 0x6D703EF3, 0x7A6D76E9, 0x00000000};
+    uint32_t x[16];
+    for (int i = 0; i < 8; i++) x[i] = bswap32(sha[i]);
+    x[8] = 0x80;
+    for (int i = 9; i < 16; i++) x[i] = 0;
+    x[14] = 32 * 8;
+    uint32_t al = 0x67452301, bl = 0xEFCDAB89, cl = 0x98BADCFE, dl = 0x10325476, el = 0xC3D2E1F0;
+    uint32_t ar = al, br = bl, cr = cl, dr = dl, er = el;
+    for (int j = 0; j < 80; j++) {
+        uint32_t t = rotl32(al + rmd_f(j, bl, cl, dl) + x[c_rmd_r[j]] + K[j >> 4], c_rmd_s[j]) + el;
+        al = el; el = dl; dl = rotl32(cl, 10); cl = bl; bl = t;
+        t = rotl32(ar + rmd_f(79 - j, br, cr, dr) + x[c_rmd_rp[j]] + KP[j >> 4], c_rmd_sp[j]) + er;
+        ar = er; er = dr; dr = rotl32(cr, 10); cr = br; br = t;
+    }
+    uint32_t t = 0xEFCDAB89 + cl + dr;
+    h[1] = 0x98BADCFE + dl + er;
+    h[2] = 0x10325476 + el + ar;
+    h[3] = 0xC3D2E1F0 + al + br;
+    h[4] = 0x67452301 + bl + cr;
+    h[0] = t;
+}
+
+/* ======================== Scan Kernel ======================== */
+
+typedef struct {
+    const gpu_point_t   *starts;
+    const gpu_point_t   *stride;
+    const uint32_t      *filter;
+    uint32_t             filter_mask;
+    const unsigned char *targets;      /* sorted, 20 bytes each */
+    uint32_t             ntargets;
+    gpu_hit_t           *hits;
+    uint32_t            *nhits;
+    uint32_t             max_hits;
+} scan_args_t;
+
+#ifdef __CUDACC__
+__constant__ gpu_point_t c_step[GPU_STEP];
+#else
+static gpu_point_t c_step[GPU_STEP];
+#endif
+
+GPU_FN int h160_cmp_words(const unsigned char *t, const uint32_t h[5]) {
+    for (int i = 0; i < 20; i++) {
+        unsigned char b = (unsigned char)(h[i >> 2] >> ((i & 3) * 8));
+        if (t[i] != b) return t[i] < b ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Bit filter on the first little-endian word, then binary search */
+GPU_FN int target_match(const scan_args_t *a, const uint32_t h[5]) {
+    uint32_t i = h[0] & a->filter_mask;
+    if (!((a->filter[i >> 5] >> (i & 31)) & 1)) return 0;
+    uint32_t lo = 0, hi = a->ntargets;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) >> 1;
+        int c = h160_cmp_words(a->targets + (size_t)mid * 20, h);
+        if (c == 0) return 1;
+        if (c < 0) lo = mid + 1; else hi = mid;
+    }
+    return 0;
+}
+
+GPU_FN void check_key(const scan_args_t *a, const pt_t *p, uint32_t unit, uint32_t offset) {
+    uint32_t sha[8], h[5];
+    sha256_pubkey(sha, p);
+    rmd160_digest(h, sha);
+    if (target_match(a, h)) {
+        uint32_t n = atomicAdd(a->nhits, 1u);
+        if (n < a->max_hits) {
+            a->hits[n].unit = unit;
+            a->hits[n].offset = offset;
+        }
+    }
+}
+
+/*
+ * Thread g scans keys [i * GPU_THREAD_KEYS, (i + 1) * GPU_THREAD_KEYS) of
+ * unit g / GPU_THREADS_PER_UNIT.  Each GPU_STEP sub-batch checks P and
+ * P + 1G .. P + (GPU_STEP-1)G, then moves P to P + GPU_STEP*G; all GPU_STEP
+ * denominators share one inversion (prefix products, backward pass).
+ */
+GPU_FN void scan_thread(uint32_t g, const scan_args_t *a) {
+    uint32_t unit = g / GPU_THREADS_PER_UNIT;
+    uint32_t i = g % GPU_THREADS_PER_UNIT;
+    pt_t p, q;
+    fe_t d, inv;
+    pt_load(&p, &a->starts[unit]);
+    if (i) {
+        pt_load(&q, &a->stride[i]);
+        fe_sub(&d, &q.x, &p.x);
+        fe_inv(&inv, &d);
+        pt_add_inv(&p, &p, &q, &inv);
+    }
+    uint32_t base = i * GPU_THREAD_KEYS;
+    fe_t prod[GPU_STEP];
+    for (int k = 0; k < GPU_THREAD_KEYS; k += GPU_STEP) {
+        for (int j = 0; j < GPU_STEP; j++) {
+            pt_load(&q, &c_step[j]);
+            fe_sub(&d, &q.x, &p.x);
+            if (j) fe_mul(&prod[j], &prod[j - 1], &d);
+            else   prod[0] = d;
+        }
+        fe_inv(&inv, &prod[GPU_STEP - 1]);
+        check_key(a, &p, unit, base + k);
+        pt_t next;
+        for (int j = GPU_STEP - 1; j >= 0; j--) {
+            fe_t dj;
+            pt_load(&q, &c_step[j]);
+            if (j) fe_mul(&dj, &inv, &prod[j - 1]);
+            else   dj = inv;
+            fe_sub(&d, &q.x, &p.x);
+            fe_mul(&inv, &inv, &d);
+            pt_t r;
+            pt_add_inv(&r, &p, &q, &dj);
+            if (j == GPU_STEP - 1) next = r;
+            else check_key(a, &r, unit, base + k + j + 1);
+        }
+        p = next;
+    }
+}
+
+/* ======================== Host API ======================== */
+
+#ifdef __CUDACC__
+
+#define GPU_BLOCK 128
+
+__global__ void scan_kernel(scan_args_t a, uint32_t nthreads) {
+    uint32_t g = blockIdx.x * blockDim.x + threadIdx.x;
+    if (g < nthreads) scan_thread(g, &a);
+}
+
+struct gpu_ctx {
+    int            device;
+    int            max_units;
+    gpu_point_t   *d_stride;
+    uint32_t      *d_filter;
+    unsigned char *d_targets;
+    uint32_t       ntargets;
+    uint32_t       filter_mask;
+    gpu_point_t   *d_starts;
+    gpu_hit_t     *d_hits;
+    uint32_t      *d_nhits;
+};
+
+static int gpu_check(cudaError_t e, const char *what) {
+    if (e == cudaSuccess) return 1;
+    fprintf(stderr, "GPU: %s: %s\n", what, cudaGetErrorString(e));
+    return 0;
+}
+
+extern "C" gpu_ctx_t *gpu_open(int device, const gpu_point_t *step, const gpu_point_t *stride,
+                               const uint32_t *filter, uint32_t filter_mask,
+                               const unsigned char (*targets)[20], size_t ntargets,
+                               int max_units, char *name, size_t name_len) {
+    cudaDeviceProp prop;
+    if (!gpu_check(cudaSetDevice(device), "cudaSetDevice") ||
+        !gpu_check(cudaGetDeviceProperties(&prop, device), "cudaGetDeviceProperties"))
+        return NULL;
+    snprintf(name, name_len, "%s (sm_%d%d, %d SMs)", prop.name, prop.major, prop.minor,
+             prop.multiProcessorCount);
+    gpu_ctx_t *c = (gpu_ctx_t *)calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    c->device = device;
+    c->max_units = max_units;
+    c->ntargets = (uint32_t)ntargets;
+    c->filter_mask = filter_mask;
+    size_t filter_len = ((size_t)filter_mask + 1) / 8;
+    if (!gpu_check(cudaMemcpyToSymbol(c_step, step, sizeof(gpu_point_t) * GPU_STEP), "step table") ||
+        !gpu_check(cudaMalloc(&c->d_stride, sizeof(gpu_point_t) * GPU_THREADS_PER_UNIT), "cudaMalloc") ||
+        !gpu_check(cudaMalloc(&c->d_filter, filter_len), "cudaMalloc") ||
+        !gpu_check(cudaMalloc(&c->d_targets, ntargets * 20), "cudaMalloc") ||
+        !gpu_check(cudaMalloc(&c->d_starts, sizeof(gpu_point_t) * max_units), "cudaMalloc") ||
+        !gpu_check(cudaMalloc(&c->d_hits, sizeof(gpu_hit_t) * GPU_MAX_HITS), "cudaMalloc") ||
+        !gpu_check(cudaMalloc(&c->d_nhits, sizeof(uint32_t)), "cudaMalloc") ||
+        !gpu_check(cudaMemcpy(c->d_stride, stride, sizeof(gpu_point_t) * GPU_THREADS_PER_UNIT,
+                              cudaMemcpyHostToDevice), "stride table") ||
+        !gpu_check(cudaMemcpy(c->d_filter, filter, filter_len, cudaMemcpyHostToDevice), "filter") ||
+        !gpu_check(cudaMemcpy(c->d_targets, targets, ntargets * 20, cudaMemcpyHostToDevice), "targets")) {
+        gpu_close(c);
+        return NULL;
+    }
+    return c;
+}
+
+extern "C" int gpu_scan(gpu_ctx_t *c, const gpu_point_t *starts, int nunits,
+                        gpu_hit_t *hits, int max_hits) {
+    if (nunits > c->max_units) nunits = c->max_units;
+    if (max_hits > GPU_MAX_HITS) max_hits = GPU_MAX_HITS;
+    scan_args_t a;
+    a.starts = c->d_starts;
+    a.stride = c->d_stride;
+    a.filter = c->d_filter;
+    a.filter_mask = c->filter_mask;
+    a.targets = c->d_targets;
+    a.ntargets = c->ntargets;
+    a.hits = c->d_hits;
+    a.nhits = c->d_nhits;
+    a.max_hits = GPU_MAX_HITS;
+    uint32_t nthreads = (uint32_t)nunits * GPU_THREADS_PER_UNIT;
+    uint32_t n = 0;
+    if (!gpu_check(cudaSetDevice(c->device), "cudaSetDevice") ||
+        !gpu_check(cudaMemcpy(c->d_starts, starts, sizeof(gpu_point_t) * nunits,
+                              cudaMemcpyHostToDevice), "starts") ||
+        !gpu_check(cudaMemset(c->d_nhits, 0, sizeof(uint32_t)), "cudaMemset"))
+        return -1;
+    scan_kernel<<<(nthreads + GPU_BLOCK - 1) / GPU_BLOCK, GPU_BLOCK>>>(a, nthreads);
+    if (!gpu_check(cudaGetLastError(), "scan_kernel") ||
+        !gpu_check(cudaMemcpy(&n, c->d_nhits, sizeof(n), cudaMemcpyDeviceToHost), "hit count"))
+        return -1;
+    if ((int)n > max_hits) n = (uint32_t)max_hits;
+    if (n && !gpu_check(cudaMemcpy(hits, c->d_hits, sizeof(gpu_hit_t) * n,
+                                   cudaMemcpyDeviceToHost), "hits"))
+        return -1;
+    return (int)n;
+}
+
+extern "C" void gpu_close(gpu_ctx_t *c) {
+    if (!c) return;
+    cudaSetDevice(c->device);
+    cudaFree(c->d_stride);
+    cudaFree(c->d_filter);
+    cudaFree(c->d_targets);
+    cudaFree(c->d_starts);
+    cudaFree(c->d_hits);
+    cudaFree(c->d_nhits);
+    free(c);
+}
+
+#endif /* __CUDACC__ */
@@ -0,0 +1,68 @@
+/*
+ * CUDA backend for c_scanner (--gpu): the affine stepping engine, hash160
+ * and the target filter + set lookup, run on the GPU.
+ *
+ * The GPU only scans; c_scanner's GPU worker threads claim work units,
+ * compute their start points with libsecp256k1, and complete / checkpoint
+ * / report exactly like the CPU workers, so CPU cores and GPUs share one
+ * unit sequence, checkpoint file and coordinator lease.
+ *
+ * One unit (UNIT_KEYS keys) is split over GPU_THREADS_PER_UNIT threads of
+ * GPU_THREAD_KEYS consecutive keys.  Each thread steps in affine
+ * coordinates from its start point with one batched inversion per
+ * GPU_STEP keys, like affine_batch() on the CPU.
+ *
+ * Build (CUDA toolkit), then link into c_scanner with -DWITH_CUDA:
+ *   nvcc -O3 -arch=sm_86 -c /root/puzzle71/gpu_engine.cu -o /root/puzzle71/gpu_engine.o
+ */
+
+#ifndef GPU_ENGINE_H
+#define GPU_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GPU_STEP              64      /* keys per batched inversion */
+#define GPU_THREAD_KEYS       256     /* keys per GPU thread per unit */
+#define GPU_THREADS_PER_UNIT  ((1 << 22) / GPU_THREAD_KEYS)
+#define GPU_MAX_HITS          64
+
+/* Affine point, coordinates as little-endian 32-bit limbs (v[0] lowest) */
+typedef struct {
+    uint32_t x[8], y[8];
+} gpu_point_t;
+
+/* Target match: key = start of unit `unit` in the launch + offset */
+typedef struct {
+    uint32_t unit, offset;
+} gpu_hit_t;
+
+typedef struct gpu_ctx gpu_ctx_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Open `device` with the step table (1G..GPU_STEP*G), the per-thread
+ * stride table (i * GPU_THREAD_KEYS * G for i < GPU_THREADS_PER_UNIT;
+ * entry 0 unused), the target filter bitmap and the sorted hash160 set.
+ * Launches take up to max_units start points.  NULL on failure.
+ */
+gpu_ctx_t *gpu_open(int device, const gpu_point_t *step, const gpu_point_t *stride,
+                    const uint32_t *filter, uint32_t filter_mask,
+                    const unsigned char (*targets)[20], size_t ntargets,
+                    int max_units, char *name, size_t name_len);
+
+/* Scan nunits units from starts[]; returns the number of hits written
+ * (at most max_hits), or -1 on a CUDA error */
+int gpu_scan(gpu_ctx_t *ctx, const gpu_point_t *starts, int nunits,
+             gpu_hit_t *hits, int max_hits);
+
+void gpu_close(gpu_ctx_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GPU_ENGINE_H */
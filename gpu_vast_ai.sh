@@ -21,6 +21,9 @@
 #   ./gpu_vast_ai.sh --list              # List your running instances
 #   ./gpu_vast_ai.sh --estimate          # Cost estimate for running 24h/7d/30d
 #   ./gpu_vast_ai.sh --dry-run           # Show what would happen
+#   ./gpu_vast_ai.sh --node 2/8          # Node 2 of 8: BitCrack scans only the
+#                                        # keys 2^70 + 2 + j*8, so 8 instances
+#                                        # split the range with no coordinator
 #
 # Instance requirements:
 #   - NVIDIA GPU with >= 8GB VRAM (RTX 3090/4090 preferred)
@@ -53,6 +56,8 @@ MAX_COST="$DEFAULT_MAX_COST"
 MODE="full"      # full, search, deploy, destroy, list, estimate
 INSTANCE_ID=""
 DRY_RUN=false
+NODE_INDEX=""    # --node I/N: residue class I of N
+NODE_COUNT=""
 
 # ─── Color Output ────────────────────────────────────────────────────────────
 RED='\033[0;31m'
@@ -87,8 +92,14 @@ while [[ $# -gt 0 ]]; do
             MAX_COST="$2"; shift 2 ;;
         --dry-run)
             DRY_RUN=true; shift ;;
+        --node)
+            if [[ ! "$2" =~ ^([0-9]+)/([0-9]+)$ ]] || (( BASH_REMATCH[1] >= BASH_REMATCH[2] )) \
+                || (( BASH_REMATCH[2] > 4294967295 )); then
+                log_error "--node needs I/N with 0 <= I < N <= 2^32-1"; exit 1
+            fi
+            NODE_INDEX="${BASH_REMATCH[1]}"; NODE_COUNT="${BASH_REMATCH[2]}"; shift 2 ;;
         -h|--help)
-            head -35 "$0" | tail -30; exit 0 ;;
+            head -38 "$0" | tail -33; exit 0 ;;
         *)
             log_error "Unknown argument: $1"; exit 1 ;;
     esac
@@ -385,10 +396,18 @@ deploy_to_instance() {
     }
     log_ok "Scripts uploaded"
 
+    # Node I of N starts at 2^70 + I and steps by N (I < 2^32, so the
+    # low 64 bits carry all of it)
+    local deploy_args=""
+    if [[ -n "$NODE_COUNT" ]]; then
+        deploy_args="--start 40$(printf '%016X' "$NODE_INDEX") --stride ${NODE_COUNT}"
+        log_info "Node ${NODE_INDEX} of ${NODE_COUNT}: ${deploy_args}"
+    fi
+
     # Execute deploy script remotely
     log_info "Executing gpu_deploy.sh on remote instance..."
     ssh ${ssh_opts} -p "${ssh_port}" "${ssh_host}" \
-        "chmod +x /root/gpu_deploy.sh /root/multi_gpu_launch.sh && bash /root/gpu_deploy.sh" 2>&1 | \
+        "chmod +x /root/gpu_deploy.sh /root/multi_gpu_launch.sh && bash /root/gpu_deploy.sh ${deploy_args}" 2>&1 | \
         tee "${SCRIPT_DIR}/logs/vastai_deploy_${inst_id}.log" || {
         log_warn "Remote execution may have been interrupted. Check instance directly."
     }
@@ -17,6 +17,11 @@
 #   ./multi_gpu_launch.sh --status         # Show status of running instances
 #   ./multi_gpu_launch.sh --stop           # Stop all running BitCrack instances
 #   ./multi_gpu_launch.sh --binary /path   # Use specific cuBitCrack binary
+#   ./multi_gpu_launch.sh --coordinator HOST:7171
+#                                          # Also run c_scanner on the CPU cores,
+#                                          # leasing work units from work_coordinator.py
+#   ./multi_gpu_launch.sh --host-scanner   # One c_scanner process for all GPUs and
+#                                          # the CPU cores, co-scheduled (no BitCrack)
 #
 # Each GPU runs in its own screen session: bitcrack_gpu0, bitcrack_gpu1, etc.
 # Progress and logs are saved per-GPU in /root/puzzle71/logs/
@@ -48,6 +53,9 @@ MODE="launch"    # launch, status, stop
 GPU_LIST=""      # Comma-separated GPU indices, or empty for auto-detect
 BITCRACK_BIN=""
 POINTS_PER_THREAD=512
+COORDINATOR=""   # HOST:PORT of work_coordinator.py, or empty for no CPU client
+CPU_THREADS=""   # c_scanner threads, or empty for nproc
+HOST_SCANNER=false  # c_scanner --gpu drives every GPU and the CPU in one process
 
 # ─── Color Output ────────────────────────────────────────────────────────────
 RED='\033[0;31m'
@@ -78,8 +86,14 @@ while [[ $# -gt 0 ]]; do
             BITCRACK_BIN="$2"; shift 2 ;;
         --points|-p)
             POINTS_PER_THREAD="$2"; shift 2 ;;
+        --coordinator)
+            COORDINATOR="$2"; shift 2 ;;
+        --cpu-threads)
+            CPU_THREADS="$2"; shift 2 ;;
+        --host-scanner)
+            HOST_SCANNER=true; shift ;;
         -h|--help)
-            head -30 "$0" | tail -25; exit 0 ;;
+            head -31 "$0" | tail -26; exit 0 ;;
         *)
             log_error "Unknown argument: $1"; exit 1 ;;
     esac
@@ -95,6 +109,75 @@ cleanup() {
 }
 trap cleanup EXIT
 
+###############################################################################
+# CPU Client (c_scanner leasing work units from the coordinator)
+###############################################################################
+launch_cpu_client() {
+    [[ -z "$COORDINATOR" ]] && return 0
+
+    local scanner_bin="${WORKDIR}/c_scanner"
+    local threads="${CPU_THREADS:-$(nproc)}"
+    local session_name="bitcrack_cpu_client"
+    local log_file="${LOGDIR}/cpu_client_$(date +%Y%m%d_%H%M%S).log"
+    local cmd="${scanner_bin} ${threads} --coordinator=${COORDINATOR} --node=$(hostname)"
+
+    log_info "CPU client:"
+    log_info "  Coordinator: ${COORDINATOR}"
+    log_info "  Session:     ${session_name}"
+    log_info "  Cmd:         ${cmd}"
+
+    if $DRY_RUN; then
+        log_warn "  [DRY-RUN] Would launch the above command"
+        return 0
+    fi
+    if [[ ! -x "$scanner_bin" ]]; then
+        log_warn "  ${scanner_bin} not built -- skipping CPU client"
+        return 0
+    fi
+
+    screen -X -S "$session_name" quit 2>/dev/null || true
+    screen -dmS "$session_name" bash -c "${cmd} 2>&1 | tee -a ${log_file}"
+    log_ok "  CPU client started (${threads} threads)"
+}
+
+###############################################################################
+# Host Scanner (one c_scanner for every GPU and the CPU cores)
+###############################################################################
+# c_scanner measures each GPU and the CPU pool, keeps a core per GPU for its
+# feeder thread and parks CPU workers while they cost the GPUs more than
+# they add, so the box's total rate is what gets tuned.
+launch_host_scanner() {
+    local gpus="$1"
+    local scanner_bin="${WORKDIR}/c_scanner"
+    local threads="${CPU_THREADS:-$(nproc)}"
+    local session_name="bitcrack_host"
+    local log_file="${LOGDIR}/host_scanner_$(date +%Y%m%d_%H%M%S).log"
+    local work="--units"
+    [[ -n "$COORDINATOR" ]] && work="--coordinator=${COORDINATOR} --node=$(hostname)"
+    local cmd="${scanner_bin} ${threads} --gpu=${gpus} --pin=core ${work} --ledger"
+
+    log_header "Launching Host Scanner"
+    log_info "  Session:     ${session_name}"
+    log_info "  Cmd:         ${cmd}"
+
+    if $DRY_RUN; then
+        log_warn "  [DRY-RUN] Would launch the above command"
+        return 0
+    fi
+    if [[ ! -x "$scanner_bin" ]]; then
+        log_error "  ${scanner_bin} not built (needs -DWITH_CUDA, see c_scanner.c)"
+        exit 1
+    fi
+
+    screen -X -S "$session_name" quit 2>/dev/null || true
+    screen -dmS "$session_name" bash -c "${cmd} 2>&1 | tee -a ${log_file}"
+    log_ok "  Host scanner started (GPUs ${gpus}, ${threads} CPU threads)"
+    echo ""
+    echo "    Attach:      screen -r ${session_name}"
+    echo "    Stats:       cat ${WORKDIR}/data/c_scanner_stats.json"
+    echo "    Stop all:    ./multi_gpu_launch.sh --stop"
+}
+
 ###############################################################################
 # Hex Arithmetic (using Python for big number support)
 ###############################################################################
@@ -647,6 +730,13 @@ main() {
 
     log_ok "Will use ${num_gpus} GPU(s): ${gpu_indices[*]}"
 
+    if $HOST_SCANNER; then
+        local gpu_csv
+        gpu_csv="$(IFS=','; echo "${gpu_indices[*]}")"
+        launch_host_scanner "$gpu_csv"
+        return 0
+    fi
+
     # Find BitCrack binary
     find_bitcrack
 
@@ -695,6 +785,9 @@ main() {
 
     echo ""
 
+    # CPU cores take coordinator leases alongside the GPUs
+    launch_cpu_client
+
     # Launch monitor
     launch_monitor
 
@@ -708,6 +801,9 @@ main() {
     echo "  Commands:"
     echo "    Monitor:     screen -r bitcrack_monitor"
     echo "    GPU 0:       screen -r bitcrack_gpu0"
+    if [[ -n "$COORDINATOR" ]]; then
+        echo "    CPU client:  screen -r bitcrack_cpu_client"
+    fi
     echo "    Status:      ./multi_gpu_launch.sh --status"
     echo "    Stop all:    ./multi_gpu_launch.sh --stop"
     echo "    Found key:   cat ${FOUND_FILE}"
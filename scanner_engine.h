@@ -0,0 +1,67 @@
+/*
+ * c_scanner as an embeddable library: the same engines, hash kernels and
+ * target set, driven through a small C API instead of main().
+ *
+ * Build (from the secp256k1_src directory, flags as for c_scanner):
+ *   gcc -O3 -march=x86-64-v2 -fPIC -shared -DSCANNER_LIBRARY \
+ *       -I/root/secp256k1_src/include -I/root/secp256k1_src/src -I/root/secp256k1_src \
+ *       -Wno-deprecated-declarations -Wno-unused-function \
+ *       -o /root/puzzle71/libc_scanner.so /root/puzzle71/c_scanner.c -lcrypto -lpthread
+ *
+ * c_engine.py is the Python binding.  scanner_engine_scan() blocks until
+ * the range is done, so callers that want to keep running (stats, signal
+ * handling) call it with the GIL released, as ctypes does.
+ */
+
+#ifndef SCANNER_ENGINE_H
+#define SCANNER_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Called from a scan thread for every key whose hash160 is in the target
+ * set; calls are serialized.  May call scanner_engine_stop(). */
+typedef void (*scanner_match_fn)(void *user, uint64_t key_hi, uint64_t key_lo,
+                                 const unsigned char h160[20]);
+
+typedef struct {
+    uint64_t keys;       /* keys checked since init */
+    uint64_t matches;    /* callbacks made since init */
+    uint64_t scans;      /* scanner_engine_scan() calls finished */
+    int32_t  threads;
+    int32_t  batch;
+} scanner_counters_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Start the engine with `threads` scan threads and batch size `batch`
+ * (0: default).  engine and isa are c_scanner's --engine / --isa names, or
+ * NULL for the defaults.  Targets default to puzzle #71.  0 on success. */
+int scanner_engine_init(int threads, int batch, const char *engine, const char *isa);
+
+/* Replace the target set with n hash160s (20 bytes each, copied); not
+ * while a scan runs.  0 on success. */
+int scanner_engine_set_targets(const unsigned char *h160, size_t n);
+
+/* Check count keys from (hi, lo) on all threads.  Returns the number of
+ * keys checked (less than count after scanner_engine_stop()) or -1. */
+int64_t scanner_engine_scan(uint64_t hi, uint64_t lo, uint64_t count,
+                            scanner_match_fn fn, void *user);
+
+/* Make a running scan return early; safe from any thread or a signal */
+void scanner_engine_stop(void);
+
+void scanner_engine_counters(scanner_counters_t *out);
+
+/* Hash kernel / field code / engine, as c_scanner prints them */
+const char *scanner_engine_info(void);
+
+void scanner_engine_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCANNER_ENGINE_H */
@@ -4,10 +4,24 @@
  * SHA256 of exactly 33 bytes (compressed pubkey):
  *   - Input is always 33 bytes -> 1 SHA256 block (64 bytes with padding)
  *   - Pre-compute the padding once
- *   - Use SHA-NI intrinsics if available
+ *   - Use SHA-NI intrinsics if available: sha256_rmd160_init() checks CPUID
+ *     once at startup, so the same binary still runs without SHA extensions
  *
  * RIPEMD160 of exactly 32 bytes (SHA256 output):
  *   - Input is always 32 bytes -> 1 RIPEMD160 block (64 bytes with padding)
+ *
+ * Multi-buffer hash160 (hash160_fast_x8 / hash160_fast_x16):
+ *   - 8 or 16 pubkeys hashed in parallel lanes (AVX2 ymm / AVX-512 zmm)
+ *   - every kernel is compiled for its own ISA (#pragma GCC target), so a
+ *     baseline -march=x86-64 build carries all of them; hash160_select()
+ *     picks one at startup from CPUID, or the one a caller forces
+ *   - hash160_fast_many() runs the selected kernel plus a scalar tail
+ *   - both compressions are specialized for a compressed pubkey, and the
+ *     hash160_xw_* entry points take the prefix and X coordinate as words
+ *     so the scanner can skip the 33-byte serialization
+ *
+ * hash160_fast() / sha256_33_generic() / rmd160_32() are the byte-oriented
+ * reference implementations the startup self-tests check against.
  */
 
 #ifndef SHA256_RMD160_FAST_H
@@ -16,6 +30,14 @@
 #include <stdint.h>
 #include <string.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA256_HAVE_SHANI 1
+#else
+#define SHA256_HAVE_SHANI 0
+#endif
+
 /* ========== SHA256 for exactly 33 bytes ========== */
 
 /* SHA256 initial hash values */
@@ -64,8 +86,15 @@ static inline void put_be32(unsigned char *p, uint32_t v) {
     p[3] = v & 0xFF;
 }
 
-/* SHA256 of exactly 33 bytes -> 32-byte hash */
-static inline void sha256_33(const unsigned char input[33], unsigned char output[32]) {
+static inline void put_le32(unsigned char *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+/* SHA256 of exactly 33 bytes -> 32-byte hash (portable C) */
+static inline void sha256_33_generic(const unsigned char input[33], unsigned char output[32]) {
     /* Prepare the single 64-byte block:
      * bytes 0-32: input data (33 bytes)
      * byte 33: 0x80 (padding start)
@@ -113,6 +142,133 @@ static inline void sha256_33(const unsigned char input[33], unsigned char output
     put_be32(output + 28, h + sha256_H0[7]);
 }
 
+/* ========== SHA256 for exactly 33 bytes, SHA-NI ========== */
+
+/* Set by sha256_rmd160_init() when the CPU supports SHA extensions */
+static int sha256_use_shani = 0;
+
+#if SHA256_HAVE_SHANI
+/*
+ * SHA-NI compress of the single padded block m[0..3] (W[0..15]) -> state
+ * words a..h.
+ *
+ * sha256rnds2 / msg1 / msg2 only have legacy SSE encodings, so the entry
+ * points below are kept out of line, touch nothing wider than xmm and clear
+ * any dirty upper ymm/zmm state (from the multi-lane kernels) on entry.
+ * Otherwise every one of those instructions pays an SSE/AVX transition.
+ */
+__attribute__((target("sha,sse4.1"), always_inline))
+static inline void sha256_shani_block(__m128i m[4], uint32_t state[8]) {
+    /* Rearrange H0 into the ABEF / CDGH layout sha256rnds2 expects */
+    __m128i tmp = _mm_loadu_si128((const __m128i *)&sha256_H0[0]);
+    __m128i st1 = _mm_loadu_si128((const __m128i *)&sha256_H0[4]);
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    st1 = _mm_shuffle_epi32(st1, 0x1B);
+    __m128i st0 = _mm_alignr_epi8(tmp, st1, 8);
+    st1 = _mm_blend_epi16(st1, tmp, 0xF0);
+    const __m128i abef = st0, cdgh = st1;
+
+    /* 16 x 4 rounds; m[j & 3] holds W[4j-16..4j-13] before being replaced */
+    for (int j = 0; j < 16; j++) {
+        if (j >= 4) {
+            __m128i prev = m[(j + 3) & 3];
+            __m128i t = _mm_sha256msg1_epu32(m[j & 3], m[(j + 1) & 3]);
+            t = _mm_add_epi32(t, _mm_alignr_epi8(prev, m[(j + 2) & 3], 4));
+            m[j & 3] = _mm_sha256msg2_epu32(t, prev);
+        }
+        __m128i msg = _mm_add_epi32(m[j & 3], _mm_loadu_si128((const __m128i *)&sha256_K[j * 4]));
+        st1 = _mm_sha256rnds2_epu32(st1, st0, msg);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        st0 = _mm_sha256rnds2_epu32(st0, st1, msg);
+    }
+
+    st0 = _mm_add_epi32(st0, abef);
+    st1 = _mm_add_epi32(st1, cdgh);
+
+    /* Back to a,b,c,d / e,f,g,h order */
+    tmp = _mm_shuffle_epi32(st0, 0x1B);
+    st1 = _mm_shuffle_epi32(st1, 0xB1);
+    st0 = _mm_blend_epi16(tmp, st1, 0xF0);
+    st1 = _mm_alignr_epi8(st1, tmp, 8);
+    _mm_storeu_si128((__m128i *)&state[0], st0);
+    _mm_storeu_si128((__m128i *)&state[4], st1);
+}
+
+/* SHA-NI SHA256 of 33 bytes -> state words */
+__attribute__((target("sha,sse4.1"), noinline))
+static void sha256_33_shani_words(const unsigned char input[33], uint32_t state[8]) {
+#ifdef __AVX__
+    _mm256_zeroupper();
+#endif
+    const __m128i bswap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m128i m[4];
+    m[0] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)input), bswap);
+    m[1] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(input + 16)), bswap);
+    m[2] = _mm_set_epi32(0, 0, 0, (int)(((uint32_t)input[32] << 24) | 0x00800000));
+    m[3] = _mm_set_epi32(264, 0, 0, 0);   /* length in bits = 33*8 */
+    sha256_shani_block(m, state);
+}
+
+/* SHA-NI SHA256 of prefix || X, X given as 8 big-endian words -> state words */
+__attribute__((target("sha,sse4.1"), noinline))
+static void sha256_33_shani_xw(uint32_t prefix, const uint32_t x[8], uint32_t state[8]) {
+#ifdef __AVX__
+    _mm256_zeroupper();
+#endif
+    /* Shift X right by the prefix byte: w[i] = x[i-1] low byte || x[i] >> 8 */
+    __m128i lo = _mm_loadu_si128((const __m128i *)x);
+    __m128i hi = _mm_loadu_si128((const __m128i *)(x + 4));
+    __m128i lo_prev = _mm_insert_epi32(_mm_slli_si128(lo, 4), (int)prefix, 0);
+    __m128i hi_prev = _mm_alignr_epi8(hi, lo, 12);
+    __m128i m[4];
+    m[0] = _mm_or_si128(_mm_slli_epi32(lo_prev, 24), _mm_srli_epi32(lo, 8));
+    m[1] = _mm_or_si128(_mm_slli_epi32(hi_prev, 24), _mm_srli_epi32(hi, 8));
+    m[2] = _mm_set_epi32(0, 0, 0, (int)((x[7] << 24) | 0x00800000));
+    m[3] = _mm_set_epi32(264, 0, 0, 0);   /* length in bits = 33*8 */
+    sha256_shani_block(m, state);
+}
+
+/* CPUID leaf 7 EBX bit 29 (SHA), plus the SSSE3 / SSE4.1 shuffles used above */
+static inline int sha256_cpu_has_shani(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+    if (!(ecx & (1u << 9)) || !(ecx & (1u << 19)))
+        return 0;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return 0;
+    return (ebx >> 29) & 1;
+}
+#endif
+
+/* SHA256 of exactly 33 bytes -> 32-byte hash, on the path chosen at init */
+static inline void sha256_33(const unsigned char input[33], unsigned char output[32]) {
+#if SHA256_HAVE_SHANI
+    if (sha256_use_shani) {
+        uint32_t state[8];
+        sha256_33_shani_words(input, state);
+        for (int i = 0; i < 8; i++)
+            put_be32(output + i * 4, state[i]);
+        return;
+    }
+#endif
+    sha256_33_generic(input, output);
+}
+
+/*
+ * Pick the SHA256 implementation: mode -1 = SHA-NI if the CPU has it,
+ * 0 = generic C, 1 = SHA-NI required.  Returns its name for logging, or
+ * NULL when SHA-NI was required but is not available.
+ */
+static inline const char *sha256_rmd160_init(int mode) {
+#if SHA256_HAVE_SHANI
+    sha256_use_shani = mode != 0 && sha256_cpu_has_shani();
+#endif
+    if (mode == 1 && !sha256_use_shani)
+        return NULL;
+    return sha256_use_shani ? "SHA-NI" : "generic C";
+}
+
 /* ========== RIPEMD160 for exactly 32 bytes ========== */
 
 static const uint32_t rmd160_H0[5] = {
@@ -367,4 +523,148 @@ static inline void hash160_fast(const unsigned char input[33], unsigned char out
     rmd160_32(sha, output);
 }
 
+/* ========== Multi-buffer hash160 (8 / 16 lanes) ========== */
+
+typedef uint32_t hv8_u32  __attribute__((vector_size(32)));
+typedef uint32_t hv16_u32 __attribute__((vector_size(64)));
+
+/* Byte-swap each lane: SHA256 state words (big-endian) -> RIPEMD160 input
+ * words (little-endian) without a round-trip through bytes */
+#define BSWAP32_LANES(x) \
+    (((x) >> 24) | (((x) >> 8) & 0xFF00) | (((x) << 8) & 0xFF0000) | ((x) << 24))
+
+/* Per-ISA instances need function-level target switching (x86 GCC / Clang) */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HASH160_DISPATCH      1
+#define HASH160_TARGET_AVX2   __attribute__((target("avx2")))
+#define HASH160_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define HASH160_DISPATCH      0
+#define HASH160_TARGET_AVX2
+#define HASH160_TARGET_AVX512
+#endif
+
+#define HV_LANES     1
+#define HV_T         uint32_t
+#define HV_FN(name)  name##_x1
+#include "/root/puzzle71/sha256_rmd160_simd.h"
+#undef HV_LANES
+#undef HV_T
+#undef HV_FN
+
+#if HASH160_DISPATCH
+#ifdef __clang__
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+#endif
+#define HV_LANES     8
+#define HV_T         hv8_u32
+#define HV_FN(name)  name##_x8
+#include "/root/puzzle71/sha256_rmd160_simd.h"
+#undef HV_LANES
+#undef HV_T
+#undef HV_FN
+#if HASH160_DISPATCH
+#ifdef __clang__
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif
+
+#if HASH160_DISPATCH
+#ifdef __clang__
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+#endif
+#define HV_LANES     16
+#define HV_T         hv16_u32
+#define HV_FN(name)  name##_x16
+#include "/root/puzzle71/sha256_rmd160_simd.h"
+#undef HV_LANES
+#undef HV_T
+#undef HV_FN
+#if HASH160_DISPATCH
+#ifdef __clang__
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif
+
+/* ========== Runtime kernel selection ========== */
+
+enum { HASH160_ISA_SCALAR, HASH160_ISA_AVX2, HASH160_ISA_AVX512, HASH160_ISA_AUTO };
+static const char *const HASH160_ISA_NAMES[] = { "scalar", "avx2", "avx512" };
+
+#define HASH160_MAX_LANES 16
+
+/*
+ * The selected kernel.  The *_lanes entry points take flat lane-interleaved
+ * arrays: prefix[l], x[i * hash160_lanes + l], h[i * hash160_lanes + l].
+ */
+static int hash160_isa = HASH160_ISA_SCALAR;
+static int hash160_lanes = 1;
+static void (*hash160_xw_lanes)(const uint32_t *prefix, const uint32_t *x, uint32_t *h) = hash160_xw_flat_x1;
+static void (*hash160_fast_lanes)(const unsigned char in[][33], unsigned char out[][20]) = hash160_fast_x1;
+
+static inline int hash160_isa_supported(int isa) {
+#if HASH160_DISPATCH
+    __builtin_cpu_init();
+    if (isa == HASH160_ISA_AVX2) return __builtin_cpu_supports("avx2");
+    if (isa == HASH160_ISA_AVX512) return __builtin_cpu_supports("avx512f");
+#endif
+    return isa == HASH160_ISA_SCALAR;
+}
+
+/* Select the kernel for isa (HASH160_ISA_AUTO = widest the CPU runs);
+ * returns 0, leaving the selection unchanged, if the CPU can't run it */
+static inline int hash160_select(int isa) {
+    if (isa == HASH160_ISA_AUTO) {
+        isa = hash160_isa_supported(HASH160_ISA_AVX512) ? HASH160_ISA_AVX512 :
+              hash160_isa_supported(HASH160_ISA_AVX2)   ? HASH160_ISA_AVX2 : HASH160_ISA_SCALAR;
+    } else if (!hash160_isa_supported(isa)) {
+        return 0;
+    }
+    hash160_isa = isa;
+    if (isa == HASH160_ISA_AVX512) {
+        hash160_lanes = 16;
+        hash160_xw_lanes = hash160_xw_flat_x16;
+        hash160_fast_lanes = hash160_fast_x16;
+    } else if (isa == HASH160_ISA_AVX2) {
+        hash160_lanes = 8;
+        hash160_xw_lanes = hash160_xw_flat_x8;
+        hash160_fast_lanes = hash160_fast_x8;
+    } else {
+        hash160_lanes = 1;
+        hash160_xw_lanes = hash160_xw_flat_x1;
+        hash160_fast_lanes = hash160_fast_x1;
+    }
+    return 1;
+}
+
+/* Human-readable description of the hash path in use (after init) */
+static inline const char *hash160_kernel_name(void) {
+    if (hash160_isa == HASH160_ISA_AVX512)
+        return "x16 AVX-512";
+    if (hash160_isa == HASH160_ISA_AVX2)
+        return sha256_use_shani ? "x8 AVX2 RIPEMD160 + SHA-NI" : "x8 AVX2";
+    return sha256_use_shani ? "scalar + SHA-NI" : "scalar";
+}
+
+/* hash160 of n pubkeys: full hash160_lanes groups, then a scalar tail */
+static inline void hash160_fast_many(const unsigned char in[][33], unsigned char out[][20], int n) {
+    int i = 0;
+    for (; i + hash160_lanes <= n; i += hash160_lanes)
+        hash160_fast_lanes(in + i, out + i);
+    for (; i < n; i++)
+        hash160_fast_x1(in + i, out + i);
+}
+
 #endif /* SHA256_RMD160_FAST_H */
@@ -0,0 +1,370 @@
+/*
+ * Multi-lane hash160 kernel body, instantiated by sha256_rmd160_fast.h.
+ *
+ * Hashes HV_LANES independent compressed pubkeys at once: lane l of every
+ * vector word belongs to pubkey l, so each SHA256 / RIPEMD160 round is one
+ * vector instruction across all lanes.  Written with GCC vector extensions;
+ * the 8 / 16 lane instances are compiled for AVX2 / AVX-512 (target pragmas
+ * in sha256_rmd160_fast.h) so the lane types map onto ymm / zmm registers,
+ * the 1-lane instance is plain scalar code, and the scalar round macros are
+ * reused unchanged.
+ *
+ * Both compressions are specialized for hash160 of a compressed pubkey:
+ *   - SHA256 input is prefix byte || X (32 bytes) || fixed padding, taken as
+ *     the prefix and 8 big-endian X words, so W[9..15] are constants and the
+ *     zero terms of W[16..31] drop out of the schedule; round 0 only adds W[0]
+ *     to a precomputed constant
+ *   - RIPEMD160 input words 8..15 are fixed padding, folded into the round
+ *     constants below
+ *
+ * When the CPU has SHA extensions (sha256_use_shani, see sha256_rmd160_fast.h)
+ * the 1- and 8-lane kernels run the SHA256 half per lane on the SHA-NI unit
+ * and only RIPEMD160 uses the vector lanes.  16 AVX-512 lanes out-run
+ * SHA-NI, so the x16 kernel always hashes in vectors.
+ *
+ * Before including, define:
+ *   HV_LANES     number of lanes (1, 8 or 16)
+ *   HV_T         uint32_t, or vector type of HV_LANES uint32_t
+ *   HV_FN(name)  lane-suffixed function name
+ */
+
+#define HV_SHA_RND(a, b, c, d, e, f, g, h, kw) { \
+    HV_T t1_ = h + EP1(e) + CH(e, f, g) + (kw); \
+    d += t1_; \
+    h = t1_ + EP0(a) + MAJ(a, b, c); \
+}
+
+#define HV_SHA_RND8(i, w0, w1, w2, w3, w4, w5, w6, w7) { \
+    HV_SHA_RND(a, b, c, d, e, f, g, h, (w0) + sha256_K[(i) + 0]); \
+    HV_SHA_RND(h, a, b, c, d, e, f, g, (w1) + sha256_K[(i) + 1]); \
+    HV_SHA_RND(g, h, a, b, c, d, e, f, (w2) + sha256_K[(i) + 2]); \
+    HV_SHA_RND(f, g, h, a, b, c, d, e, (w3) + sha256_K[(i) + 3]); \
+    HV_SHA_RND(e, f, g, h, a, b, c, d, (w4) + sha256_K[(i) + 4]); \
+    HV_SHA_RND(d, e, f, g, h, a, b, c, (w5) + sha256_K[(i) + 5]); \
+    HV_SHA_RND(c, d, e, f, g, h, a, b, (w6) + sha256_K[(i) + 6]); \
+    HV_SHA_RND(b, c, d, e, f, g, h, a, (w7) + sha256_K[(i) + 7]); \
+}
+
+/* SHA256 of prefix || X -> state words st[0..7] */
+static inline void HV_FN(sha256_pubkey)(const HV_T *prefix, const HV_T x[8], HV_T st[8]) {
+    const HV_T zero = { 0 };
+    HV_T W[64];
+
+    /* Block words: the 33 bytes are X shifted right by the prefix byte */
+    W[0] = (*prefix << 24) | (x[0] >> 8);
+    for (int i = 1; i < 8; i++)
+        W[i] = (x[i-1] << 24) | (x[i] >> 8);
+    W[8] = (x[7] << 24) | 0x00800000;
+    /* W[9..14] = 0, W[15] = 264 (length in bits = 33*8) */
+
+    W[16] = SIG0(W[1]) + W[0];
+    W[17] = SIG1(264u) + SIG0(W[2]) + W[1];
+    W[18] = SIG1(W[16]) + SIG0(W[3]) + W[2];
+    W[19] = SIG1(W[17]) + SIG0(W[4]) + W[3];
+    W[20] = SIG1(W[18]) + SIG0(W[5]) + W[4];
+    W[21] = SIG1(W[19]) + SIG0(W[6]) + W[5];
+    W[22] = SIG1(W[20]) + 264u + SIG0(W[7]) + W[6];
+    W[23] = SIG1(W[21]) + W[16] + SIG0(W[8]) + W[7];
+    W[24] = SIG1(W[22]) + W[17] + W[8];
+    W[25] = SIG1(W[23]) + W[18];
+    W[26] = SIG1(W[24]) + W[19];
+    W[27] = SIG1(W[25]) + W[20];
+    W[28] = SIG1(W[26]) + W[21];
+    W[29] = SIG1(W[27]) + W[22];
+    W[30] = SIG1(W[28]) + W[23] + SIG0(264u);
+    W[31] = SIG1(W[29]) + W[24] + SIG0(W[16]) + 264u;
+    for (int i = 32; i < 64; i++) {
+        W[i] = SIG1(W[i-2]) + W[i-7] + SIG0(W[i-15]) + W[i-16];
+    }
+
+    /* Round 0 from the constant initial state: only W[0] varies */
+    const uint32_t t1_0 = 0x5be0cd19u + EP1(0x510e527fu) +
+                          CH(0x510e527fu, 0x9b05688cu, 0x1f83d9abu) + 0x428a2f98u;
+    const uint32_t t2_0 = EP0(0x6a09e667u) + MAJ(0x6a09e667u, 0xbb67ae85u, 0x3c6ef372u);
+    HV_T t1 = W[0] + t1_0;
+    HV_T a = zero + 0x6a09e667u, b = zero + 0xbb67ae85u, c = zero + 0x3c6ef372u;
+    HV_T d = t1 + 0xa54ff53au;
+    HV_T e = zero + 0x510e527fu, f = zero + 0x9b05688cu, g = zero + 0x1f83d9abu;
+    HV_T h = t1 + t2_0;
+
+    /* Rounds 1..7: (h, a, b, ..., g) after round 0 */
+    HV_SHA_RND(h, a, b, c, d, e, f, g, W[1] + sha256_K[1]);
+    HV_SHA_RND(g, h, a, b, c, d, e, f, W[2] + sha256_K[2]);
+    HV_SHA_RND(f, g, h, a, b, c, d, e, W[3] + sha256_K[3]);
+    HV_SHA_RND(e, f, g, h, a, b, c, d, W[4] + sha256_K[4]);
+    HV_SHA_RND(d, e, f, g, h, a, b, c, W[5] + sha256_K[5]);
+    HV_SHA_RND(c, d, e, f, g, h, a, b, W[6] + sha256_K[6]);
+    HV_SHA_RND(b, c, d, e, f, g, h, a, W[7] + sha256_K[7]);
+
+    /* Rounds 8..15: constant padding words folded into K */
+    HV_SHA_RND8(8, W[8], 0u, 0u, 0u, 0u, 0u, 0u, 264u);
+
+    for (int i = 16; i < 64; i += 8) {
+        HV_SHA_RND8(i, W[i], W[i+1], W[i+2], W[i+3], W[i+4], W[i+5], W[i+6], W[i+7]);
+    }
+
+    st[0] = a + sha256_H0[0]; st[1] = b + sha256_H0[1];
+    st[2] = c + sha256_H0[2]; st[3] = d + sha256_H0[3];
+    st[4] = e + sha256_H0[4]; st[5] = f + sha256_H0[5];
+    st[6] = g + sha256_H0[6]; st[7] = h + sha256_H0[7];
+}
+
+/* RIPEMD160 of the 32-byte SHA256 digest given as state words -> h[0..4] */
+static inline void HV_FN(rmd160_digest)(const HV_T st[8], HV_T out[5]) {
+    const HV_T zero = { 0 };
+
+    /* Digest bytes as little-endian words; words 8..15 are the constant
+     * padding (0x80, zeros, bit length 256) and appear as 0 below */
+    HV_T x[8];
+    for (int i = 0; i < 8; i++)
+        x[i] = BSWAP32_LANES(st[i]);
+
+    HV_T al = zero + rmd160_H0[0], bl = zero + rmd160_H0[1], cl = zero + rmd160_H0[2];
+    HV_T dl = zero + rmd160_H0[3], el = zero + rmd160_H0[4];
+    HV_T ar = al, br = bl, cr = cl, dr = dl, er = el;
+
+    /* Left rounds */
+    /* Round 1: F, K=0x00000000 */
+    RMD_ROUND(al, bl, cl, dl, el, F(bl,cl,dl), x[0], 0x00000000, 11);
+    RMD_ROUND(el, al, bl, cl, dl, F(al,bl,cl), x[1], 0x00000000, 14);
+    RMD_ROUND(dl, el, al, bl, cl, F(el,al,bl), x[2], 0x00000000, 15);
+    RMD_ROUND(cl, dl, el, al, bl, F(dl,el,al), x[3], 0x00000000, 12);
+    RMD_ROUND(bl, cl, dl, el, al, F(cl,dl,el), x[4], 0x00000000,  5);
+    RMD_ROUND(al, bl, cl, dl, el, F(bl,cl,dl), x[5], 0x00000000,  8);
+    RMD_ROUND(el, al, bl, cl, dl, F(al,bl,cl), x[6], 0x00000000,  7);
+    RMD_ROUND(dl, el, al, bl, cl, F(el,al,bl), x[7], 0x00000000,  9);
+    RMD_ROUND(cl, dl, el, al, bl, F(dl,el,al),     0, 0x00000080, 11);
+    RMD_ROUND(bl, cl, dl, el, al, F(cl,dl,el),     0, 0x00000000, 13);
+    RMD_ROUND(al, bl, cl, dl, el, F(bl,cl,dl),     0, 0x00000000, 14);
+    RMD_ROUND(el, al, bl, cl, dl, F(al,bl,cl),     0, 0x00000000, 15);
+    RMD_ROUND(dl, el, al, bl, cl, F(el,al,bl),     0, 0x00000000,  6);
+    RMD_ROUND(cl, dl, el, al, bl, F(dl,el,al),     0, 0x00000000,  7);
+    RMD_ROUND(bl, cl, dl, el, al, F(cl,dl,el),     0, 0x00000100,  9);
+    RMD_ROUND(al, bl, cl, dl, el, F(bl,cl,dl),     0, 0x00000000,  8);
+
+    /* Round 2: G, K=0x5A827999 */
+    RMD_ROUND(el, al, bl, cl, dl, G(al,bl,cl), x[7], 0x5A827999,  7);
+    RMD_ROUND(dl, el, al, bl, cl, G(el,al,bl), x[4], 0x5A827999,  6);
+    RMD_ROUND(cl, dl, el, al, bl, G(dl,el,al),     0, 0x5A827999,  8);
+    RMD_ROUND(bl, cl, dl, el, al, G(cl,dl,el), x[1], 0x5A827999, 13);
+    RMD_ROUND(al, bl, cl, dl, el, G(bl,cl,dl),     0, 0x5A827999, 11);
+    RMD_ROUND(el, al, bl, cl, dl, G(al,bl,cl), x[6], 0x5A827999,  9);
+    RMD_ROUND(dl, el, al, bl, cl, G(el,al,bl),     0, 0x5A827999,  7);
+    RMD_ROUND(cl, dl, el, al, bl, G(dl,el,al), x[3], 0x5A827999, 15);
+    RMD_ROUND(bl, cl, dl, el, al, G(cl,dl,el),     0, 0x5A827999,  7);
+    RMD_ROUND(al, bl, cl, dl, el, G(bl,cl,dl), x[0], 0x5A827999, 12);
+    RMD_ROUND(el, al, bl, cl, dl, G(al,bl,cl),     0, 0x5A827999, 15);
+    RMD_ROUND(dl, el, al, bl, cl, G(el,al,bl), x[5], 0x5A827999,  9);
+    RMD_ROUND(cl, dl, el, al, bl, G(dl,el,al), x[2], 0x5A827999, 11);
+    RMD_ROUND(bl, cl, dl, el, al, G(cl,dl,el),     0, 0x5A827A99,  7);
+    RMD_ROUND(al, bl, cl, dl, el, G(bl,cl,dl),     0, 0x5A827999, 13);
+    RMD_ROUND(el, al, bl, cl, dl, G(al,bl,cl),     0, 0x5A827A19, 12);
+
+    /* Round 3: H, K=0x6ED9EBA1 */
+    RMD_ROUND(dl, el, al, bl, cl, H(el,al,bl), x[3], 0x6ED9EBA1, 11);
+    RMD_ROUND(cl, dl, el, al, bl, H(dl,el,al),     0, 0x6ED9EBA1, 13);
+    RMD_ROUND(bl, cl, dl, el, al, H(cl,dl,el),     0, 0x6ED9ECA1,  6);
+    RMD_ROUND(al, bl, cl, dl, el, H(bl,cl,dl), x[4], 0x6ED9EBA1,  7);
+    RMD_ROUND(el, al, bl, cl, dl, H(al,bl,cl),     0, 0x6ED9EBA1, 14);
+    RMD_ROUND(dl, el, al, bl, cl, H(el,al,bl),     0, 0x6ED9EBA1,  9);
+    RMD_ROUND(cl, dl, el, al, bl, H(dl,el,al),     0, 0x6ED9EC21, 13);
+    RMD_ROUND(bl, cl, dl, el, al, H(cl,dl,el), x[1], 0x6ED9EBA1, 15);
+    RMD_ROUND(al, bl, cl, dl, el, H(bl,cl,dl), x[2], 0x6ED9EBA1, 14);
+    RMD_ROUND(el, al, bl, cl, dl, H(al,bl,cl), x[7], 0x6ED9EBA1,  8);
+    RMD_ROUND(dl, el, al, bl, cl, H(el,al,bl), x[0], 0x6ED9EBA1, 13);
+    RMD_ROUND(cl, dl, el, al, bl, H(dl,el,al), x[6], 0x6ED9EBA1,  6);
+    RMD_ROUND(bl, cl, dl, el, al, H(cl,dl,el),     0, 0x6ED9EBA1,  5);
+    RMD_ROUND(al, bl, cl, dl, el, H(bl,cl,dl),     0, 0x6ED9EBA1, 12);
+    RMD_ROUND(el, al, bl, cl, dl, H(al,bl,cl), x[5], 0x6ED9EBA1,  7);
+    RMD_ROUND(dl, el, al, bl, cl, H(el,al,bl),     0, 0x6ED9EBA1,  5);
+
+    /* Round 4: I, K=0x8F1BBCDC */
+    RMD_ROUND(cl, dl, el, al, bl, I(dl,el,al), x[1], 0x8F1BBCDC, 11);
+    RMD_ROUND(bl, cl, dl, el, al, I(cl,dl,el),     0, 0x8F1BBCDC, 12);
+    RMD_ROUND(al, bl, cl, dl, el, I(bl,cl,dl),     0, 0x8F1BBCDC, 14);
+    RMD_ROUND(el, al, bl, cl, dl, I(al,bl,cl),     0, 0x8F1BBCDC, 15);
+    RMD_ROUND(dl, el, al, bl, cl, I(el,al,bl), x[0], 0x8F1BBCDC, 14);
+    RMD_ROUND(cl, dl, el, al, bl, I(dl,el,al),     0, 0x8F1BBD5C, 15);
+    RMD_ROUND(bl, cl, dl, el, al, I(cl,dl,el),     0, 0x8F1BBCDC,  9);
+    RMD_ROUND(al, bl, cl, dl, el, I(bl,cl,dl), x[4], 0x8F1BBCDC,  8);
+    RMD_ROUND(el, al, bl, cl, dl, I(al,bl,cl),     0, 0x8F1BBCDC,  9);
+    RMD_ROUND(dl, el, al, bl, cl, I(el,al,bl), x[3], 0x8F1BBCDC, 14);
+    RMD_ROUND(cl, dl, el, al, bl, I(dl,el,al), x[7], 0x8F1BBCDC,  5);
+    RMD_ROUND(bl, cl, dl, el, al, I(cl,dl,el),     0, 0x8F1BBCDC,  6);
+    RMD_ROUND(al, bl, cl, dl, el, I(bl,cl,dl),     0, 0x8F1BBDDC,  8);
+    RMD_ROUND(el, al, bl, cl, dl, I(al,bl,cl), x[5], 0x8F1BBCDC,  6);
+    RMD_ROUND(dl, el, al, bl, cl, I(el,al,bl), x[6], 0x8F1BBCDC,  5);
+    RMD_ROUND(cl, dl, el, al, bl, I(dl,el,al), x[2], 0x8F1BBCDC, 12);
+
+    /* Round 5: J, K=0xA953FD4E */
+    RMD_ROUND(bl, cl, dl, el, al, J(cl,dl,el), x[4], 0xA953FD4E,  9);
+    RMD_ROUND(al, bl, cl, dl, el, J(bl,cl,dl), x[0], 0xA953FD4E, 15);
+    RMD_ROUND(el, al, bl, cl, dl, J(al,bl,cl), x[5], 0xA953FD4E,  5);
+    RMD_ROUND(dl, el, al, bl, cl, J(el,al,bl),     0, 0xA953FD4E, 11);
+    RMD_ROUND(cl, dl, el, al, bl, J(dl,el,al), x[7], 0xA953FD4E,  6);
+    RMD_ROUND(bl, cl, dl, el, al, J(cl,dl,el),     0, 0xA953FD4E,  8);
+    RMD_ROUND(al, bl, cl, dl, el, J(bl,cl,dl), x[2], 0xA953FD4E, 13);
+    RMD_ROUND(el, al, bl, cl, dl, J(al,bl,cl),     0, 0xA953FD4E, 12);
+    RMD_ROUND(dl, el, al, bl, cl, J(el,al,bl),     0, 0xA953FE4E,  5);
+    RMD_ROUND(cl, dl, el, al, bl, J(dl,el,al), x[1], 0xA953FD4E, 12);
+    RMD_ROUND(bl, cl, dl, el, al, J(cl,dl,el), x[3], 0xA953FD4E, 13);
+    RMD_ROUND(al, bl, cl, dl, el, J(bl,cl,dl),     0, 0xA953FDCE, 14);
+    RMD_ROUND(el, al, bl, cl, dl, J(al,bl,cl),     0, 0xA953FD4E, 11);
+    RMD_ROUND(dl, el, al, bl, cl, J(el,al,bl), x[6], 0xA953FD4E,  8);
+    RMD_ROUND(cl, dl, el, al, bl, J(dl,el,al),     0, 0xA953FD4E,  5);
+    RMD_ROUND(bl, cl, dl, el, al, J(cl,dl,el),     0, 0xA953FD4E,  6);
+
+    /* Right rounds */
+    /* Round 1: J, K=0x50A28BE6 */
+    RMD_ROUND(ar, br, cr, dr, er, J(br,cr,dr), x[5], 0x50A28BE6,  8);
+    RMD_ROUND(er, ar, br, cr, dr, J(ar,br,cr),     0, 0x50A28CE6,  9);
+    RMD_ROUND(dr, er, ar, br, cr, J(er,ar,br), x[7], 0x50A28BE6,  9);
+    RMD_ROUND(cr, dr, er, ar, br, J(dr,er,ar), x[0], 0x50A28BE6, 11);
+    RMD_ROUND(br, cr, dr, er, ar, J(cr,dr,er),     0, 0x50A28BE6, 13);
+    RMD_ROUND(ar, br, cr, dr, er, J(br,cr,dr), x[2], 0x50A28BE6, 15);
+    RMD_ROUND(er, ar, br, cr, dr, J(ar,br,cr),     0, 0x50A28BE6, 15);
+    RMD_ROUND(dr, er, ar, br, cr, J(er,ar,br), x[4], 0x50A28BE6,  5);
+    RMD_ROUND(cr, dr, er, ar, br, J(dr,er,ar),     0, 0x50A28BE6,  7);
+    RMD_ROUND(br, cr, dr, er, ar, J(cr,dr,er), x[6], 0x50A28BE6,  7);
+    RMD_ROUND(ar, br, cr, dr, er, J(br,cr,dr),     0, 0x50A28BE6,  8);
+    RMD_ROUND(er, ar, br, cr, dr, J(ar,br,cr),     0, 0x50A28C66, 11);
+    RMD_ROUND(dr, er, ar, br, cr, J(er,ar,br), x[1], 0x50A28BE6, 14);
+    RMD_ROUND(cr, dr, er, ar, br, J(dr,er,ar),     0, 0x50A28BE6, 14);
+    RMD_ROUND(br, cr, dr, er, ar, J(cr,dr,er), x[3], 0x50A28BE6, 12);
+    RMD_ROUND(ar, br, cr, dr, er, J(br,cr,dr),     0, 0x50A28BE6,  6);
+
+    /* Round 2: I, K=0x5C4DD124 */
+    RMD_ROUND(er, ar, br, cr, dr, I(ar,br,cr), x[6], 0x5C4DD124,  9);
+    RMD_ROUND(dr, er, ar, br, cr, I(er,ar,br),     0, 0x5C4DD124, 13);
+    RMD_ROUND(cr, dr, er, ar, br, I(dr,er,ar), x[3], 0x5C4DD124, 15);
+    RMD_ROUND(br, cr, dr, er, ar, I(cr,dr,er), x[7], 0x5C4DD124,  7);
+    RMD_ROUND(ar, br, cr, dr, er, I(br,cr,dr), x[0], 0x5C4DD124, 12);
+    RMD_ROUND(er, ar, br, cr, dr, I(ar,br,cr),     0, 0x5C4DD124,  8);
+    RMD_ROUND(dr, er, ar, br, cr, I(er,ar,br), x[5], 0x5C4DD124,  9);
+    RMD_ROUND(cr, dr, er, ar, br, I(dr,er,ar),     0, 0x5C4DD124, 11);
+    RMD_ROUND(br, cr, dr, er, ar, I(cr,dr,er),     0, 0x5C4DD224,  7);
+    RMD_ROUND(ar, br, cr, dr, er, I(br,cr,dr),     0, 0x5C4DD124,  7);
+    RMD_ROUND(er, ar, br, cr, dr, I(ar,br,cr),     0, 0x5C4DD1A4, 12);
+    RMD_ROUND(dr, er, ar, br, cr, I(er,ar,br),     0, 0x5C4DD124,  7);
+    RMD_ROUND(cr, dr, er, ar, br, I(dr,er,ar), x[4], 0x5C4DD124,  6);
+    RMD_ROUND(br, cr, dr, er, ar, I(cr,dr,er),     0, 0x5C4DD124, 15);
+    RMD_ROUND(ar, br, cr, dr, er, I(br,cr,dr), x[1], 0x5C4DD124, 13);
+    RMD_ROUND(er, ar, br, cr, dr, I(ar,br,cr), x[2], 0x5C4DD124, 11);
+
+    /* Round 3: H, K=0x6D703EF3 */
+    RMD_ROUND(dr, er, ar, br, cr, H(er,ar,br),     0, 0x6D703EF3,  9);
+    RMD_ROUND(cr, dr, er, ar, br, H(dr,er,ar), x[5], 0x6D703EF3,  7);
+    RMD_ROUND(br, cr, dr, er, ar, H(cr,dr,er), x[1], 0x6D703EF3, 15);
+    RMD_ROUND(ar, br, cr, dr, er, H(br,cr,dr), x[3], 0x6D703EF3, 11);
+    RMD_ROUND(er, ar, br, cr, dr, H(ar,br,cr), x[7], 0x6D703EF3,  8);
+    RMD_ROUND(dr, er, ar, br, cr, H(er,ar,br),     0, 0x6D703FF3,  6);
+    RMD_ROUND(cr, dr, er, ar, br, H(dr,er,ar), x[6], 0x6D703EF3,  6);
+    RMD_ROUND(br, cr, dr, er, ar, H(cr,dr,er),     0, 0x6D703EF3, 14);
+    RMD_ROUND(ar, br, cr, dr, er, H(br,cr,dr),     0, 0x6D703EF3, 12);
+    RMD_ROUND(er, ar, br, cr, dr, H(ar,br,cr),     0, 0x6D703F73, 13);
+    RMD_ROUND(dr, er, ar, br, cr, H(er,ar,br),     0, 0x6D703EF3,  5);
+    RMD_ROUND(cr, dr, er, ar, br, H(dr,er,ar), x[2], 0x6D703EF3, 14);
+    RMD_ROUND(br, cr, dr, er, ar, H(cr,dr,er),     0, 0x6D703EF3, 13);
+    RMD_ROUND(ar, br, cr, dr, er, H(br,cr,dr), x[0], 0x6D703EF3, 13);
+    RMD_ROUND(er, ar, br, cr, dr, H(ar,br,cr), x[4], 0x6D703EF3,  7);
+    RMD_ROUND(dr, er, ar, br, cr, H(er,ar,br),     0, 0x6D703EF3,  5);
+
+    /* Round 4: G, K=0x7A6D76E9 */
+    RMD_ROUND(cr, dr, er, ar, br, G(dr,er,ar),     0, 0x7A6D7769, 15);
+    RMD_ROUND(br, cr, dr, er, ar, G(cr,dr,er), x[6], 0x7A6D76E9,  5);
+    RMD_ROUND(ar, br, cr, dr, er, G(br,cr,dr), x[4], 0x7A6D76E9,  8);
+    RMD_ROUND(er, ar, br, cr, dr, G(ar,br,cr), x[1], 0x7A6D76E9, 11);
+    RMD_ROUND(dr, er, ar, br, cr, G(er,ar,br), x[3], 0x7A6D76E9, 14);
+    RMD_ROUND(cr, dr, er, ar, br, G(dr,er,ar),     0, 0x7A6D76E9, 14);
+    RMD_ROUND(br, cr, dr, er, ar, G(cr,dr,er),     0, 0x7A6D76E9,  6);
+    RMD_ROUND(ar, br, cr, dr, er, G(br,cr,dr), x[0], 0x7A6D76E9, 14);
+    RMD_ROUND(er, ar, br, cr, dr, G(ar,br,cr), x[5], 0x7A6D76E9,  6);
+    RMD_ROUND(dr, er, ar, br, cr, G(er,ar,br),     0, 0x7A6D76E9,  9);
+    RMD_ROUND(cr, dr, er, ar, br, G(dr,er,ar), x[2], 0x7A6D76E9, 12);
+    RMD_ROUND(br, cr, dr, er, ar, G(cr,dr,er),     0, 0x7A6D76E9,  9);
+    RMD_ROUND(ar, br, cr, dr, er, G(br,cr,dr),     0, 0x7A6D76E9, 12);
+    RMD_ROUND(er, ar, br, cr, dr, G(ar,br,cr), x[7], 0x7A6D76E9,  5);
+    RMD_ROUND(dr, er, ar, br, cr, G(er,ar,br),     0, 0x7A6D76E9, 15);
+    RMD_ROUND(cr, dr, er, ar, br, G(dr,er,ar),     0, 0x7A6D77E9,  8);
+
+    /* Round 5: F, K=0x00000000 */
+    RMD_ROUND(br, cr, dr, er, ar, F(cr,dr,er),     0, 0x00000000,  8);
+    RMD_ROUND(ar, br, cr, dr, er, F(br,cr,dr),     0, 0x00000000,  5);
+    RMD_ROUND(er, ar, br, cr, dr, F(ar,br,cr),     0, 0x00000000, 12);
+    RMD_ROUND(dr, er, ar, br, cr, F(er,ar,br), x[4], 0x00000000,  9);
+    RMD_ROUND(cr, dr, er, ar, br, F(dr,er,ar), x[1], 0x00000000, 12);
+    RMD_ROUND(br, cr, dr, er, ar, F(cr,dr,er), x[5], 0x00000000,  5);
+    RMD_ROUND(ar, br, cr, dr, er, F(br,cr,dr),     0, 0x00000080, 14);
+    RMD_ROUND(er, ar, br, cr, dr, F(ar,br,cr), x[7], 0x00000000,  6);
+    RMD_ROUND(dr, er, ar, br, cr, F(er,ar,br), x[6], 0x00000000,  8);
+    RMD_ROUND(cr, dr, er, ar, br, F(dr,er,ar), x[2], 0x00000000, 13);
+    RMD_ROUND(br, cr, dr, er, ar, F(cr,dr,er),     0, 0x00000000,  6);
+    RMD_ROUND(ar, br, cr, dr, er, F(br,cr,dr),     0, 0x00000100,  5);
+    RMD_ROUND(er, ar, br, cr, dr, F(ar,br,cr), x[0], 0x00000000, 15);
+    RMD_ROUND(dr, er, ar, br, cr, F(er,ar,br), x[3], 0x00000000, 13);
+    RMD_ROUND(cr, dr, er, ar, br, F(dr,er,ar),     0, 0x00000000, 11);
+    RMD_ROUND(br, cr, dr, er, ar, F(cr,dr,er),     0, 0x00000000, 11);
+
+    out[0] = rmd160_H0[1] + cl + dr;
+    out[1] = rmd160_H0[2] + dl + er;
+    out[2] = rmd160_H0[3] + el + ar;
+    out[3] = rmd160_H0[4] + al + br;
+    out[4] = rmd160_H0[0] + bl + cr;
+}
+
+/*
+ * hash160 of HV_LANES pubkeys given as lane-interleaved words:
+ *   prefix[l]  = 0x02 / 0x03 of pubkey l
+ *   x[i][l]    = big-endian word i of pubkey l's X coordinate
+ *   h[i][l]    = little-endian word i of hash160 l (h[0][l] = bytes 0..3)
+ */
+static inline void HV_FN(hash160_xw)(const uint32_t prefix[HV_LANES],
+                                     const uint32_t x[8][HV_LANES],
+                                     uint32_t h[5][HV_LANES]) {
+    HV_T xv[8], st[8], hv[5];
+#if SHA256_HAVE_SHANI && HV_LANES <= 8
+    if (sha256_use_shani) {
+        uint32_t st_l[8][HV_LANES];
+        for (int l = 0; l < HV_LANES; l++) {
+            uint32_t xl[8], sl[8];
+            for (int i = 0; i < 8; i++)
+                xl[i] = x[i][l];
+            sha256_33_shani_xw(prefix[l], xl, sl);
+            for (int i = 0; i < 8; i++)
+                st_l[i][l] = sl[i];
+        }
+        memcpy(st, st_l, sizeof(st));
+    } else
+#endif
+    {
+        HV_T pv;
+        memcpy(&pv, prefix, sizeof(pv));
+        memcpy(xv, x, sizeof(xv));
+        HV_FN(sha256_pubkey)(&pv, xv, st);
+    }
+    HV_FN(rmd160_digest)(st, hv);
+    memcpy(h, hv, sizeof(hv));
+}
+
+/* hash160 of HV_LANES 33-byte pubkeys: out[l] = RIPEMD160(SHA256(in[l])) */
+static inline void HV_FN(hash160_fast)(const unsigned char in[][33], unsigned char out[][20]) {
+    uint32_t prefix[HV_LANES], x[8][HV_LANES], h[5][HV_LANES];
+    for (int l = 0; l < HV_LANES; l++) {
+        prefix[l] = in[l][0];
+        for (int i = 0; i < 8; i++)
+            x[i][l] = be32(in[l] + 1 + i * 4);
+    }
+    HV_FN(hash160_xw)(prefix, x, h);
+    for (int l = 0; l < HV_LANES; l++) {
+        for (int i = 0; i < 5; i++)
+            put_le32(out[l] + i * 4, h[i][l]);
+    }
+}
+
+/* Flat-array form of hash160_xw for the runtime-selected function pointer */
+static inline void HV_FN(hash160_xw_flat)(const uint32_t *prefix, const uint32_t *x, uint32_t *h) {
+    HV_FN(hash160_xw)(prefix, (const uint32_t (*)[HV_LANES])x, (uint32_t (*)[HV_LANES])h);
+}
+
+#undef HV_SHA_RND
+#undef HV_SHA_RND8
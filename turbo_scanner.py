@@ -9,6 +9,10 @@ Strategy: Hybrid random-jump + sequential-batch scanning.
   - Each worker picks a random offset, scans CHUNK consecutive keys
   - Uses iceland secp256k1 batch h160 for max throughput
   - blob.find() with alignment-safe loop for correctness
+  - --engine=c: c_scanner's engine (libc_scanner.so via c_engine.py) runs
+    all workers as native threads in one process instead
+  - --ledger: jumps land on whole work units the shared coverage ledger
+    (coverage_ledger.py) does not cover yet, and scanned units are recorded
 """
 
 import sys
@@ -25,6 +29,8 @@ from datetime import datetime, timedelta
 sys.path.insert(0, "/root/iceland_secp256k1")
 import secp256k1 as ice
 
+import coverage_ledger
+
 # ─── CONFIG ───────────────────────────────────────────────────────────
 TARGET_H160 = bytes.fromhex("f6f5431d25bbf7b12e8add9af5e3475c44a0a5b8")
 TARGET_ADDR = "1PWo3JeB9jrGwfHDNpdGK54CRas7fsVzXU"
@@ -34,6 +40,8 @@ KEYSPACE = END - START + 1
 
 BATCH = 50000                   # keys per batch
 CHUNK = BATCH * 20              # keys per random jump (1M per chunk)
+C_CHUNK = 1 << 22               # --engine=c: keys per random jump per worker
+LEDGER_DRAWS = 64               # --ledger: random units tried before taking a covered one
 LOG_INTERVAL = 15               # seconds between status prints
 STATS_FILE = "/root/puzzle71/data/turbo_stats.json"
 FOUND_PATHS = [
@@ -95,43 +103,66 @@ def scan_blob_for_target(blob, target, batch_size):
         search_start = idx + 1
 
 
-def turbo_worker(wid):
+def verify_and_save(found_pk, wid):
+    """Double-verify a hit with individual address generation; save it."""
+    verify_addr = ice.privatekey_to_address(0, True, found_pk)
+    if verify_addr == TARGET_ADDR:
+        save_key(found_pk)
+        found_flag.set()
+        shutdown_flag.set()
+        return True
+    # False positive from h160 collision (astronomically unlikely)
+    print(f"[W-{wid}] False positive at 0x{found_pk:x}: {verify_addr}", flush=True)
+    return False
+
+
+def pick_units(ledger, n):
+    """First of n consecutive work units, at random among those the ledger
+    does not cover (any run once LEDGER_DRAWS draws have all been covered)."""
+    for _ in range(LEDGER_DRAWS):
+        first = random.randrange(coverage_ledger.NUM_UNITS - n + 1)
+        if not any(ledger.covered(u) for u in range(first, first + n)):
+            break
+    return first
+
+
+def turbo_worker(wid, ledger_path=None):
     """Hybrid turbo worker: sequential batches at random offsets."""
     random.seed(int.from_bytes(os.urandom(8), 'big') ^ (wid * 31337))
+    ledger = coverage_ledger.Ledger(ledger_path) if ledger_path else None
     local = 0
 
     while not shutdown_flag.is_set() and not found_flag.is_set():
-        # Pick random start within range, ensuring batch won't exceed END
-        max_base = END - CHUNK + 1
-        if max_base < START:
-            max_base = START
-        base = random.randint(START, max_base)
-
-        for offset in range(0, CHUNK, BATCH):
+        if ledger:
+            # One whole work unit, so it can be recorded
+            unit = pick_units(ledger, 1)
+            base, chunk = coverage_ledger.unit_key(unit), coverage_ledger.UNIT_KEYS
+        else:
+            # Pick random start within range, ensuring batch won't exceed END
+            max_base = END - CHUNK + 1
+            if max_base < START:
+                max_base = START
+            base, chunk = random.randint(START, max_base), CHUNK
+
+        for offset in range(0, chunk, BATCH):
             if shutdown_flag.is_set() or found_flag.is_set():
                 return
 
             key_start = base + offset
+            n = min(BATCH, chunk - offset)
             # SSE variant is ~30% faster than non-SSE
             # Correct arg order: (num, addr_type, iscompressed, pvk_int)
-            blob = ice.privatekey_loop_h160_sse(BATCH, 0, True, key_start)
+            blob = ice.privatekey_loop_h160_sse(n, 0, True, key_start)
 
             # Alignment-safe search
-            key_offset = scan_blob_for_target(blob, TARGET_H160, BATCH)
-            if key_offset >= 0:
-                found_pk = key_start + key_offset
-                # Double-verify with individual address generation
-                verify_addr = ice.privatekey_to_address(0, True, found_pk)
-                if verify_addr == TARGET_ADDR:
-                    save_key(found_pk)
-                    found_flag.set()
-                    shutdown_flag.set()
-                    return
-                else:
-                    # False positive from h160 collision (astronomically unlikely)
-                    print(f"[W-{wid}] False positive at 0x{found_pk:x}: {verify_addr}", flush=True)
-
-            local += BATCH
+            key_offset = scan_blob_for_target(blob, TARGET_H160, n)
+            if key_offset >= 0 and verify_and_save(key_start + key_offset, wid):
+                return
+
+            local += n
+
+        if ledger:
+            ledger.add(unit, unit + 1)
 
         # Bulk update shared counter (less lock contention)
         with counter.get_lock():
@@ -139,6 +170,42 @@ def turbo_worker(wid):
         local = 0
 
 
+def c_engine_worker(nworkers, ledger_path=None):
+    """All workers as threads of the native engine: each scan() call checks
+    nworkers * C_CHUNK keys from a random offset with the GIL released."""
+    import c_engine
+    random.seed(int.from_bytes(os.urandom(8), 'big'))
+    ledger = coverage_ledger.Ledger(ledger_path) if ledger_path else None
+    try:
+        eng = c_engine.CEngine(threads=nworkers)
+        eng.set_targets([TARGET_H160])
+    except (OSError, RuntimeError) as e:
+        print(f"[C] Cannot start the C engine: {e}", flush=True)
+        shutdown_flag.set()
+        return
+    print(f"[C] {eng.info()}", flush=True)
+
+    chunk = C_CHUNK * nworkers
+    units = chunk // coverage_ledger.UNIT_KEYS
+    hits = []
+    while not shutdown_flag.is_set() and not found_flag.is_set():
+        if ledger:
+            first = pick_units(ledger, units)
+            base = coverage_ledger.unit_key(first)
+        else:
+            base = random.randint(START, END - chunk + 1)
+        n = eng.scan(base, chunk, lambda key, h160: hits.append(key))
+        with counter.get_lock():
+            counter.value += n
+        # A scan cut short by a stop is not recorded
+        if ledger and n == chunk:
+            ledger.add(first, first + units)
+        while hits:
+            if verify_and_save(hits.pop(), "C"):
+                break
+    eng.close()
+
+
 def write_stats_atomic(data):
     """Write stats JSON atomically via temp file + rename."""
     try:
@@ -213,6 +280,12 @@ def main():
                         help='Number of worker processes (default: 4)')
     parser.add_argument('-b', '--batch', type=int, default=0,
                         help='Batch size override')
+    parser.add_argument('-e', '--engine', choices=['ice', 'c'], default='ice',
+                        help='ice: iceland batch h160 per process (default); '
+                             'c: c_scanner engine threads via c_engine.py')
+    parser.add_argument('--ledger', nargs='?', const=coverage_ledger.LEDGER_FILE,
+                        help='Skip and record work units in the shared coverage ledger '
+                             f'(default file: {coverage_ledger.LEDGER_FILE})')
     args = parser.parse_args()
 
     nworkers = args.workers
@@ -229,6 +302,10 @@ def main():
     assert CHUNK <= KEYSPACE, "Chunk larger than keyspace"
 
     print(f"PUZZLE_BOT starting with {nworkers} workers...", flush=True)
+    if args.ledger:
+        ledger = coverage_ledger.Ledger(args.ledger)
+        print(f"Coverage ledger {args.ledger}: {ledger.units_covered():,} units covered", flush=True)
+        ledger.close()
 
     procs = []
 
@@ -238,10 +315,15 @@ def main():
     procs.append(m)
 
     # Workers
-    for i in range(nworkers):
-        p = mp.Process(target=turbo_worker, args=(i,))
+    if args.engine == 'c':
+        p = mp.Process(target=c_engine_worker, args=(nworkers, args.ledger))
         p.start()
         procs.append(p)
+    else:
+        for i in range(nworkers):
+            p = mp.Process(target=turbo_worker, args=(i, args.ledger))
+            p.start()
+            procs.append(p)
 
     print(f"All {nworkers} workers launched.", flush=True)
 
@@ -0,0 +1,554 @@
+#!/usr/bin/env python3
+"""
+work_coordinator.py -- Work-unit coordinator for a c_scanner fleet
+==================================================================
+
+Hands out leases on c_scanner work units so that every box in the fleet
+(multi_gpu_launch.sh / gpu_vast_ai.sh instances, or any other host) scans
+a disjoint part of the puzzle #71 range, and keeps one coverage ledger of
+every unit that has been completed.  Completed units also go into the
+binary coverage ledger shared with the other schedulers (coverage_ledger.py),
+and units it already covers -- scanned by turbo_scanner.py, a BitCrack run
+or another coordinator -- are counted done instead of being leased.
+
+Work units are the same as `c_scanner --units`: unit u covers the keys
+2^70 + u*2^22 .. 2^70 + (u+1)*2^22 - 1, and units are handed out in the
+order seq -> unit_permute(seq, seed) with one fleet-wide seed.  The
+coordinator only deals in sequence numbers; nodes map them to key ranges.
+
+Leases expire when a node stops sending heartbeats (a preempted spot
+instance, a crashed box).  Their unfinished units go back into a pool and
+are leased out again before any fresh units.
+
+Protocol: one TCP connection per node, one text line per request / reply.
+  HELLO <node> [token]              -> OK <seed-hex>
+  LEASE <count>                     -> OK <lease-id> <seq> <seq> ...
+  DONE <lease-id> <seq>             -> OK
+  HEARTBEAT <keys-total> <keys/s>   -> OK <lease-secs>
+  FOUND <privkey-hex>               -> OK
+  STATUS                            -> OK <json>
+Every request but HELLO needs a HELLO (with the token) first.  STATUS says
+who found the key and when, never the key: that stays in FOUND_FILE and the
+state file on the coordinator.
+Errors are answered with "ERR <reason>".
+
+Files (under /root/puzzle71/data):
+  coordinator_state.json     seed, issue counter, completion watermark
+  coverage_ledger.jsonl      one JSON line per completed unit
+  coverage.ledger            shared binary ledger (coverage_ledger.py)
+
+Usage:
+  python work_coordinator.py [--bind 0.0.0.0] [--port 7171] [--token SECRET]
+                             [--lease-timeout 180] [--data-dir DIR]
+  python work_coordinator.py --status [--host HOST] [--port 7171] [--token SECRET]
+
+Clients:
+  ./c_scanner 16 --coordinator=HOST:7171 --node=$(hostname)
+"""
+
+import argparse
+import bisect
+import datetime
+import json
+import os
+import secrets
+import socket
+import socketserver
+import sys
+import tempfile
+import threading
+import time
+
+import coverage_ledger
+
+# =============================================================================
+# Constants
+# =============================================================================
+
+UNIT_BITS = 22
+NUM_UNITS = 1 << (70 - UNIT_BITS)
+RANGE_START = 1 << 70
+
+DATA_DIR = "/root/puzzle71/data"
+STATE_FILE = os.path.join(DATA_DIR, "coordinator_state.json")
+LEDGER_FILE = os.path.join(DATA_DIR, "coverage_ledger.jsonl")
+COVERAGE_FILE = os.path.join(DATA_DIR, "coverage.ledger")
+FOUND_FILE = "/root/puzzle71/FOUND_KEY.txt"
+LOG_FILE = "/root/puzzle71/logs/work_coordinator.log"
+
+DEFAULT_PORT = 7171
+DEFAULT_LEASE_TIMEOUT = 180   # seconds without a heartbeat before reclaim
+MAX_LEASE_UNITS = 4096
+MAX_LEASE_CHECKS = 16384      # ledger lookups per LEASE under a seed (lock held)
+STATE_SAVE_INTERVAL = 10      # seconds between state snapshots
+
+# =============================================================================
+# Logging
+# =============================================================================
+
+def log(msg, level="INFO"):
+    """Print and write to log file with timestamp."""
+    ts = datetime.datetime.now(datetime.timezone.utc).strftime("%Y-%m-%d %H:%M:%S UTC")
+    line = f"[{ts}] [{level}] {msg}"
+    print(line, flush=True)
+    try:
+        with open(LOG_FILE, "a") as f:
+            f.write(line + "\n")
+    except Exception:
+        pass  # don't crash if log write fails
+
+# =============================================================================
+# Unit <-> key range (mirrors unit_permute / unit_start in c_scanner.c)
+# =============================================================================
+
+def unit_permute(seq, seed):
+    """Bijection on [0, NUM_UNITS): claim order -> unit index."""
+    mask = NUM_UNITS - 1
+    x = seq
+    if seed == 0:
+        return x
+    for r in range(3):
+        x ^= (seed >> (r * 16)) & mask
+        x = (x * 0x9E3779B97F4A7C15) & mask
+        x ^= x >> 23
+        x = (x * (0xBF58476D1CE4E5B9 ^ (seed & 0xFFFF0))) & mask
+        x ^= x >> 17
+    return x
+
+
+def unit_range(unit):
+    """First and last key of a work unit."""
+    start = RANGE_START + (unit << UNIT_BITS)
+    return start, start + (1 << UNIT_BITS) - 1
+
+# =============================================================================
+# Coordinator state
+# =============================================================================
+
+class Coordinator:
+    """
+    Lease bookkeeping.  Sequence numbers are issued in order from next_seq;
+    every seq below done_below is complete, done_above holds completed ones
+    past that watermark, done_runs the [first, end) runs of seqs skipped as
+    covered in the ledger (the watermark swallows them when it gets there),
+    and pool holds reclaimed seqs waiting to be leased again.  Everything
+    is guarded by one lock -- requests are a few per second per node.
+    coverage is the shared ledger (None to run without).
+    """
+
+    def __init__(self, lease_timeout):
+        self.lock = threading.Lock()
+        self.lease_timeout = lease_timeout
+        self.seed = secrets.randbits(64)
+        self.next_seq = 0
+        self.done_below = 0
+        self.done_above = set()
+        self.done_runs = []       # sorted, disjoint [first, end) of skipped seqs
+        self.pool = []
+        self.leases = {}          # id -> {"node", "seqs": set, "expires"}
+        self.next_lease_id = 1
+        self.nodes = {}           # name -> {"keys", "rate", "last_seen", "units"}
+        self.found = None
+        self.dirty = False
+        self.coverage = None
+        self.skipped = 0          # units found covered in the ledger
+
+    # ---- persistence -------------------------------------------------------
+
+    def load(self):
+        try:
+            with open(STATE_FILE) as f:
+                st = json.load(f)
+        except FileNotFoundError:
+            return
+        self.seed = int(st["seed"], 16)
+        self.next_seq = st["next_seq"]
+        self.done_below = st["done_below"]
+        self.done_above = set(st["done_above"])
+        self.done_runs = [list(r) for r in st.get("done_runs", [])]
+        self._advance()
+        # Leases outstanding at shutdown are handed out again
+        self.pool = sorted(s for s in st["pool"] if not self.is_done(s))
+        self.next_lease_id = st.get("next_lease_id", 1)
+        self.found = st.get("found")
+        log(f"Loaded state: {self.done_below} units complete, "
+            f"{len(self.done_above)} done ahead, {len(self.pool)} to re-lease")
+
+    def save(self):
+        with self.lock:
+            outstanding = set(self.pool)
+            for lease in self.leases.values():
+                outstanding |= lease["seqs"]
+            st = {
+                "version": 1,
+                "unit_bits": UNIT_BITS,
+                "seed": f"{self.seed:016x}",
+                "next_seq": self.next_seq,
+                "done_below": self.done_below,
+                "done_above": sorted(self.done_above),
+                "done_runs": self.done_runs,
+                "pool": sorted(outstanding),
+                "next_lease_id": self.next_lease_id,
+                "found": self.found,
+                "saved": time.time(),
+            }
+            self.dirty = False
+        fd, tmp_path = tempfile.mkstemp(dir=DATA_DIR, suffix=".tmp")
+        with os.fdopen(fd, "w") as f:
+            json.dump(st, f)
+            f.flush()
+            os.fsync(f.fileno())
+        os.replace(tmp_path, STATE_FILE)
+
+    # ---- leases ------------------------------------------------------------
+
+    def is_done(self, seq):
+        if seq < self.done_below or seq in self.done_above:
+            return True
+        i = bisect.bisect_right(self.done_runs, [seq, NUM_UNITS + 1]) - 1
+        return i >= 0 and seq < self.done_runs[i][1]
+
+    def lease(self, node, count):
+        now = time.time()
+        with self.lock:
+            self._reclaim(now)
+            seqs = []
+            while self.pool and len(seqs) < count:
+                s = self.pool.pop(0)
+                if not self.is_done(s):
+                    seqs.append(s)
+            checks = 0
+            while len(seqs) < count and self.next_seq < NUM_UNITS:
+                s = self.next_seq
+                if not self.coverage:
+                    end = s
+                elif self.seed == 0:
+                    # Claim order is unit order: skip a covered run in one step
+                    end = self.coverage.next_free(s)
+                else:
+                    end = s
+                    while (end < NUM_UNITS and checks < MAX_LEASE_CHECKS
+                           and self.coverage.covered(unit_permute(end, self.seed))):
+                        end += 1
+                        checks += 1
+                if end > s:
+                    self._mark_run(s, end)
+                    self.skipped += end - s
+                    self.next_seq = end
+                    continue
+                if checks >= MAX_LEASE_CHECKS:
+                    break
+                seqs.append(s)
+                self.next_seq += 1
+                checks += 1
+            if not seqs:
+                # More covered units than one request may look through
+                # holds more: the node asks again
+                return (None, []) if self.next_seq >= NUM_UNITS else (0, [])
+            lease_id = self.next_lease_id
+            self.next_lease_id += 1
+            self.leases[lease_id] = {"node": node, "seqs": set(seqs),
+                                     "expires": now + self.lease_timeout}
+            self.dirty = True
+            return lease_id, seqs
+
+    def done(self, node, lease_id, seq):
+        with self.lock:
+            lease = self.leases.get(lease_id)
+            if lease is not None:
+                lease["seqs"].discard(seq)
+                if not lease["seqs"]:
+                    del self.leases[lease_id]
+            # Completions from expired / pre-restart leases still count
+            if self.is_done(seq):
+                return False
+            self._mark_done(seq)
+            info = self.nodes.setdefault(node, {"keys": 0, "rate": 0.0, "units": 0})
+            info["units"] += 1
+            info["last_seen"] = time.time()
+            self.dirty = True
+        unit = unit_permute(seq, self.seed)
+        start, end = unit_range(unit)
+        rec = {"t": round(time.time(), 3), "node": node, "seq": seq, "unit": unit,
+               "start": f"{start:x}", "end": f"{end:x}", "seed": f"{self.seed:016x}"}
+        with open(LEDGER_FILE, "a") as f:
+            f.write(json.dumps(rec) + "\n")
+        if self.coverage:
+            with self.lock:
+                self.coverage.add(unit, unit + 1)
+        return True
+
+    def _mark_done(self, seq):
+        self.done_above.add(seq)
+        self._advance()
+
+    def _mark_run(self, first, end):
+        """Seqs [first, end) done at once; runs come in ascending order
+        from next_seq, so they extend the last one."""
+        if self.done_runs and self.done_runs[-1][1] == first:
+            self.done_runs[-1][1] = end
+        else:
+            self.done_runs.append([first, end])
+        self._advance()
+
+    def _advance(self):
+        """Move the watermark over completed seqs and skipped runs."""
+        moved = False
+        while True:
+            if self.done_below in self.done_above:
+                self.done_above.remove(self.done_below)
+                self.done_below += 1
+            elif self.done_runs and self.done_runs[0][0] <= self.done_below:
+                self.done_below = max(self.done_below, self.done_runs.pop(0)[1])
+                moved = True
+            else:
+                break
+        if moved:
+            self.done_above = {s for s in self.done_above if s >= self.done_below}
+        self.dirty = True
+
+    def heartbeat(self, node, keys, rate):
+        now = time.time()
+        with self.lock:
+            info = self.nodes.setdefault(node, {"keys": 0, "units": 0})
+            info["keys"] = keys
+            info["rate"] = rate
+            info["last_seen"] = now
+            for lease in self.leases.values():
+                if lease["node"] == node:
+                    lease["expires"] = now + self.lease_timeout
+
+    def _reclaim(self, now):
+        """Return the unfinished units of expired leases to the pool."""
+        expired = [lid for lid, l in self.leases.items() if l["expires"] < now]
+        for lid in expired:
+            lease = self.leases.pop(lid)
+            left = sorted(s for s in lease["seqs"] if not self.is_done(s))
+            if left:
+                log(f"Lease {lid} from {lease['node']} expired, reclaiming {len(left)} units", "WARN")
+                self.pool.extend(left)
+        if expired:
+            self.pool.sort()
+            self.dirty = True
+
+    def status(self):
+        now = time.time()
+        with self.lock:
+            self._reclaim(now)
+            nodes = {n: {"keys": i.get("keys", 0), "rate": i.get("rate", 0.0),
+                         "units": i.get("units", 0),
+                         "last_seen_s": round(now - i.get("last_seen", 0), 1)}
+                     for n, i in self.nodes.items()}
+            return {
+                "seed": f"{self.seed:016x}",
+                "units_total": NUM_UNITS,
+                "units_complete": self.done_below + len(self.done_above)
+                                  + sum(e - f for f, e in self.done_runs),
+                "done_below": self.done_below,
+                "next_seq": self.next_seq,
+                "leases": len(self.leases),
+                "units_leased": sum(len(l["seqs"]) for l in self.leases.values()),
+                "units_pooled": len(self.pool),
+                "units_skipped": self.skipped,
+                "fleet_rate": sum(i["rate"] for i in nodes.values()
+                                  if i["last_seen_s"] < self.lease_timeout),
+                "nodes": nodes,
+                "found": ({"node": self.found["node"], "t": self.found["t"]}
+                          if self.found else None),
+            }
+
+    def report_found(self, node, key_hex):
+        with self.lock:
+            self.found = {"key": key_hex, "node": node, "t": time.time()}
+            self.dirty = True
+        log(f"KEY FOUND by {node}: {key_hex}", "ALERT")
+        try:
+            with open(FOUND_FILE, "a") as f:
+                f.write("PUZZLE #71 SOLUTION\n")
+                f.write(f"Private Key: {key_hex}\n")
+                f.write(f"Reported by: {node}\n")
+                f.write(f"Found: {datetime.datetime.now(datetime.timezone.utc).isoformat()}\n")
+        except Exception as e:
+            log(f"Could not write {FOUND_FILE}: {e}", "ERROR")
+
+# =============================================================================
+# TCP server
+# =============================================================================
+
+class NodeHandler(socketserver.StreamRequestHandler):
+    """One connected node; requests are handled strictly in order."""
+
+    def reply(self, text):
+        self.wfile.write((text + "\n").encode())
+
+    def handle(self):
+        coord = self.server.coord
+        node = None
+        peer = f"{self.client_address[0]}:{self.client_address[1]}"
+        for raw in self.rfile:
+            parts = raw.decode(errors="replace").split()
+            if not parts:
+                continue
+            cmd, args = parts[0].upper(), parts[1:]
+            try:
+                if cmd == "HELLO":
+                    token = args[1] if len(args) > 1 else ""
+                    if self.server.token and token != self.server.token:
+                        self.reply("ERR bad token")
+                        log(f"Rejected {peer}: bad token", "WARN")
+                        return
+                    node = args[0]
+                    log(f"Node {node} connected from {peer}")
+                    self.reply(f"OK {coord.seed:016x}")
+                elif node is None:
+                    self.reply("ERR HELLO first")
+                elif cmd == "STATUS":
+                    self.reply("OK " + json.dumps(coord.status()))
+                elif cmd == "LEASE":
+                    count = max(1, min(int(args[0]), MAX_LEASE_UNITS))
+                    lease_id, seqs = coord.lease(node, count)
+                    if lease_id is None:
+                        self.reply("ERR exhausted")
+                    elif not seqs:
+                        self.reply("ERR busy skipping covered units")
+                    else:
+                        self.reply(f"OK {lease_id} " + " ".join(map(str, seqs)))
+                elif cmd == "DONE":
+                    coord.done(node, int(args[0]), int(args[1]))
+                    self.reply("OK")
+                elif cmd == "HEARTBEAT":
+                    coord.heartbeat(node, int(args[0]), float(args[1]))
+                    self.reply(f"OK {coord.lease_timeout}")
+                elif cmd == "FOUND":
+                    coord.report_found(node, args[0])
+                    self.reply("OK")
+                else:
+                    self.reply("ERR unknown command")
+            except (IndexError, ValueError):
+                self.reply("ERR bad arguments")
+        if node:
+            log(f"Node {node} disconnected")
+
+
+class CoordinatorServer(socketserver.ThreadingMixIn, socketserver.TCPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+
+def saver_loop(coord, stop):
+    """Snapshot state periodically, reclaim expired leases and pick up
+    coverage other schedulers appended to the ledger."""
+    while not stop.wait(STATE_SAVE_INTERVAL):
+        with coord.lock:
+            coord._reclaim(time.time())
+            if coord.coverage:
+                coord.coverage.reload()
+            dirty = coord.dirty
+        if dirty:
+            try:
+                coord.save()
+            except Exception as e:
+                log(f"State save failed: {e}", "ERROR")
+
+
+def serve(args):
+    os.makedirs(DATA_DIR, exist_ok=True)
+    os.makedirs(os.path.dirname(LOG_FILE), exist_ok=True)
+    coord = Coordinator(args.lease_timeout)
+    coord.load()
+    coord.save()
+    if not args.no_ledger:
+        coord.coverage = coverage_ledger.Ledger(COVERAGE_FILE)
+        log(f"Coverage ledger {COVERAGE_FILE}: {coord.coverage.units_covered():,} units covered")
+    server = CoordinatorServer((args.bind, args.port), NodeHandler)
+    server.coord = coord
+    server.token = args.token
+    log(f"Coordinator listening on {args.bind}:{args.port} "
+        f"(seed {coord.seed:016x}, lease timeout {args.lease_timeout}s)")
+    if not args.token and args.bind not in ("127.0.0.1", "localhost"):
+        log("No --token set: any host that can reach this port can take leases", "WARN")
+
+    stop = threading.Event()
+    saver = threading.Thread(target=saver_loop, args=(coord, stop), daemon=True)
+    saver.start()
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        log("Coordinator stopped by user (Ctrl+C).")
+    finally:
+        stop.set()
+        server.server_close()
+        coord.save()
+        if coord.coverage:
+            coord.coverage.close()
+
+# =============================================================================
+# Status client
+# =============================================================================
+
+def show_status(args):
+    with socket.create_connection((args.host, args.port), timeout=10) as s:
+        f = s.makefile()
+        s.sendall(f"HELLO status {args.token}\nSTATUS\n".encode())
+        line = f.readline()
+        if line.startswith("OK "):
+            line = f.readline()
+    if not line.startswith("OK "):
+        print(line.strip(), file=sys.stderr)
+        return 1
+    st = json.loads(line[3:])
+    print(f"Seed:            {st['seed']}")
+    print(f"Units complete:  {st['units_complete']:,} / {st['units_total']:,} "
+          f"({100.0 * st['units_complete'] / st['units_total']:.9f}%)")
+    print(f"Leased / pooled: {st['units_leased']:,} / {st['units_pooled']:,} "
+          f"({st['leases']} leases)")
+    print(f"Ledger-skipped:  {st.get('units_skipped', 0):,} units covered elsewhere")
+    print(f"Fleet rate:      {st['fleet_rate'] / 1e6:,.2f} Mk/s")
+    for name, n in sorted(st["nodes"].items()):
+        print(f"  {name:24s} {n['rate'] / 1e6:10.2f} Mk/s  {n['units']:8d} units  "
+              f"seen {n['last_seen_s']:.0f}s ago")
+    if st["found"]:
+        found_at = datetime.datetime.fromtimestamp(st["found"]["t"], datetime.timezone.utc)
+        print(f"FOUND by {st['found']['node']} at {found_at.isoformat()} "
+              f"(key in {FOUND_FILE} on the coordinator)")
+    return 0
+
+# =============================================================================
+# Entry point
+# =============================================================================
+
+def main():
+    global DATA_DIR, STATE_FILE, LEDGER_FILE, COVERAGE_FILE
+    parser = argparse.ArgumentParser(
+        description="Work-unit coordinator for c_scanner nodes (leases, heartbeats, "
+                    "reclaim of preempted nodes, shared coverage ledger).",
+    )
+    parser.add_argument("--bind", default="0.0.0.0", help="Listen address (default: 0.0.0.0)")
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT,
+                        help=f"TCP port (default: {DEFAULT_PORT})")
+    parser.add_argument("--token", default=os.environ.get("COORDINATOR_TOKEN", ""),
+                        help="Shared secret nodes must send in HELLO (default: $COORDINATOR_TOKEN)")
+    parser.add_argument("--lease-timeout", type=int, default=DEFAULT_LEASE_TIMEOUT,
+                        help=f"Seconds without heartbeat before a lease is reclaimed "
+                             f"(default: {DEFAULT_LEASE_TIMEOUT})")
+    parser.add_argument("--data-dir", default=DATA_DIR,
+                        help=f"State and ledger directory (default: {DATA_DIR})")
+    parser.add_argument("--no-ledger", action="store_true",
+                        help="Do not read or append the shared coverage.ledger")
+    parser.add_argument("--status", action="store_true",
+                        help="Query a running coordinator and print fleet status")
+    parser.add_argument("--host", default="127.0.0.1", help="Coordinator host for --status")
+    args = parser.parse_args()
+
+    if args.status:
+        sys.exit(show_status(args))
+
+    DATA_DIR = args.data_dir
+    STATE_FILE = os.path.join(DATA_DIR, "coordinator_state.json")
+    LEDGER_FILE = os.path.join(DATA_DIR, "coverage_ledger.jsonl")
+    COVERAGE_FILE = os.path.join(DATA_DIR, "coverage.ledger")
+    serve(args)
+
+
+if __name__ == "__main__":
+    main()